@@ -13,6 +13,7 @@
 class Surface;
 class Device;
 class FrameResource;
+class SubmitInfo;
 
 namespace cmdline {
   class parser;
@@ -30,6 +31,8 @@ class ApplicationClustered : public T  {
   void logic() override;
   void recordDrawBuffer(FrameResource& res) override;
   FrameResource createFrameResource() override;
+  void submitCompute(FrameResource& res) override;
+  SubmitInfo createDrawSubmitInfo(FrameResource const& res) const override;
   void updateResourceCommandBuffers(FrameResource& res) override;
   void updatePipelines() override;
   void updateDescriptors() override;
@@ -66,6 +69,9 @@ class ApplicationClustered : public T  {
   glm::uvec3 m_lightGridSize;
   glm::uvec2 m_tileSize;
   std::array<glm::vec4, 4> m_nearFrustumCornersClipSpace;
+  // signaled by draw once the light grid was read, waited for by next compute
+  vk::Semaphore m_semaphore_grid;
+  bool m_grid_in_use;
 };
 
 #include "application_clustered.inl"
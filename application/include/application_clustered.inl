@@ -1,6 +1,7 @@
 #include "wrap/conversions.hpp"
 #include "wrap/image_res.hpp"
 #include "wrap/descriptor_pool.hpp"
+#include "wrap/submit_info.hpp"
 
 #include "frame_resource.hpp"
 #include "geometry_loader.hpp"
@@ -61,7 +62,9 @@ ApplicationClustered<T>::ApplicationClustered(std::string const& resource_path,
           glm::vec4(+1.0f, +1.0f, 0.0f, 1.0f),  // bottom right
           glm::vec4(+1.0f, -1.0f, 0.0f, 1.0f),  // top right
           glm::vec4(-1.0f, -1.0f, 0.0f, 1.0f)   // top left
-      } {
+      },
+      m_semaphore_grid{this->m_device->createSemaphore({})},
+      m_grid_in_use{false} {
   this->m_shaders.emplace("compute", Shader{this->m_device, {this->resourcePath() + "shaders/light_grid_comp.spv"}});
   this->m_shaders.emplace("simple", Shader{this->m_device, {this->resourcePath() + "shaders/simple_world_space_vert.spv", this->resourcePath() + "shaders/simple_frag.spv"}});
   this->m_shaders.emplace("quad", Shader{this->m_device, {this->resourcePath() + "shaders/quad_vert.spv", this->resourcePath() + "shaders/deferred_clustered_pbr_frag.spv"}});
@@ -72,6 +75,8 @@ ApplicationClustered<T>::ApplicationClustered(std::string const& resource_path,
   createLights();  
   createTextureImages();
   createTextureSamplers();
+  // light grid is built on the compute queue while the gbuffer is drawn
+  this->m_command_pools.emplace("compute", CommandPool{this->m_device, this->m_device.getQueueIndex("compute"), vk::CommandPoolCreateFlagBits::eResetCommandBuffer});
 
   this->createRenderResources();
 }
@@ -79,18 +84,42 @@ ApplicationClustered<T>::ApplicationClustered(std::string const& resource_path,
 template<typename T>
 ApplicationClustered<T>::~ApplicationClustered() {
   this->shutDown();
+  this->m_device->destroySemaphore(m_semaphore_grid);
 }
 
 template<typename T>
 FrameResource ApplicationClustered<T>::createFrameResource() {
   auto res = T::createFrameResource();
-  res.command_buffers.emplace("compute", this->m_command_pools.at("graphics").createBuffer(vk::CommandBufferLevel::eSecondary));
+  res.command_buffers.emplace("compute", this->m_command_pools.at("compute").createBuffer(vk::CommandBufferLevel::ePrimary));
+  res.addSemaphore("compute");
   res.command_buffers.emplace("gbuffer", this->m_command_pools.at("graphics").createBuffer(vk::CommandBufferLevel::eSecondary));
   res.command_buffers.emplace("lighting", this->m_command_pools.at("graphics").createBuffer(vk::CommandBufferLevel::eSecondary));
   res.command_buffers.emplace("tonemapping", this->m_command_pools.at("graphics").createBuffer(vk::CommandBufferLevel::eSecondary));
   return res;
 }
 
+template<typename T>
+void ApplicationClustered<T>::submitCompute(FrameResource& res) {
+  SubmitInfo info{};
+  info.addCommandBuffer(res.command_buffers.at("compute").get());
+  // previous frame must have finished reading the light grid
+  if (m_grid_in_use) {
+    info.addWaitSemaphore(m_semaphore_grid, vk::PipelineStageFlagBits::eComputeShader);
+  }
+  info.addSignalSemaphore(res.semaphore("compute"));
+  this->m_device.getQueue("compute").submit({info}, nullptr);
+  m_grid_in_use = true;
+}
+
+template<typename T>
+SubmitInfo ApplicationClustered<T>::createDrawSubmitInfo(FrameResource const& res) const {
+  SubmitInfo info = T::createDrawSubmitInfo(res);
+  // gbuffer pass overlaps the light grid build, only lighting waits
+  info.addWaitSemaphore(res.semaphore("compute"), vk::PipelineStageFlagBits::eFragmentShader);
+  info.addSignalSemaphore(m_semaphore_grid);
+  return info;
+}
+
 template<typename T>
 void ApplicationClustered<T>::logic() { 
   if (this->m_camera.changed()) {
@@ -131,9 +160,9 @@ template<typename T>
 void ApplicationClustered<T>::updateResourceCommandBuffers(FrameResource& res) {
   vk::CommandBufferInheritanceInfo inheritanceInfo{};
 
-  // light grid compute
+  // light grid compute, submitted separately
   res.commandBuffer("compute")->reset({});
-  res.commandBuffer("compute")->begin({vk::CommandBufferUsageFlagBits::eSimultaneousUse, &inheritanceInfo});
+  res.commandBuffer("compute")->begin({vk::CommandBufferUsageFlagBits::eSimultaneousUse});
   res.commandBuffer("compute")->bindPipeline(vk::PipelineBindPoint::eCompute, m_pipeline_compute);
   res.commandBuffer("compute")->bindDescriptorSets(
       vk::PipelineBindPoint::eCompute, m_pipeline_compute.layout(), 0,
@@ -169,11 +198,7 @@ void ApplicationClustered<T>::updateResourceCommandBuffers(FrameResource& res) {
   inheritanceInfo.subpass = 1;
   res.commandBuffer("lighting")->reset({});
   res.commandBuffer("lighting")->begin({vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eSimultaneousUse, &inheritanceInfo});
-
-  res.commandBuffer("lighting").imageBarrier(this->m_images.at("light_vol"), vk::ImageLayout::eGeneral, 
-    vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderWrite, 
-    vk::PipelineStageFlagBits::eFragmentShader, vk::AccessFlagBits::eShaderRead
-  );
+  // light grid writes are made visible by the compute semaphore
 
   res.commandBuffer("lighting")->bindPipeline(vk::PipelineBindPoint::eGraphics, this->m_pipelines.at("quad"));
   res.commandBuffer("lighting")->bindDescriptorSets(vk::PipelineBindPoint::eGraphics, this->m_pipelines.at("quad").layout(), 0, {this->m_descriptor_sets.at("matrix"), this->m_descriptor_sets.at("lighting")}, {});
@@ -204,7 +229,6 @@ void ApplicationClustered<T>::recordDrawBuffer(FrameResource& res) {
   res.commandBuffer("primary")->reset({});
 
   res.commandBuffer("primary")->begin({vk::CommandBufferUsageFlagBits::eSimultaneousUse | vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
-  res.commandBuffer("primary")->executeCommands({res.commandBuffer("compute")});
 
   res.commandBuffer("primary")->beginRenderPass(m_framebuffer.beginInfo(), vk::SubpassContents::eSecondaryCommandBuffers);
   // execute gbuffer creation buffer
@@ -439,7 +463,7 @@ void ApplicationClustered<T>::createTextureImages() {
   // bind and upload test texture data
   this->m_allocators.at("images").allocate(this->m_images.at("texture"));
 
-  this->m_transferrer.uploadImageData(pix_data.ptr(), pix_data.size(), this->m_images.at("texture"), vk::ImageLayout::eShaderReadOnlyOptimal);
+  this->m_transferrer.uploadImageData(pix_data.ptr(0), pix_data.size(0), this->m_images.at("texture"), vk::ImageLayout::eShaderReadOnlyOptimal);
 }
 
 template<typename T>
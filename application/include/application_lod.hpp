@@ -30,11 +30,11 @@ class ApplicationLod : public T {
  private:
   void recordTransferBuffer(FrameResource& res) override;
   void recordDrawBuffer(FrameResource& res) override;
-  void updateResourceCommandBuffers(FrameResource& res) override;
   void updateResourceDescriptors(FrameResource& resource) override;
   FrameResource createFrameResource() override;
   void updatePipelines() override;
   void updateDescriptors() override;
+  void recordMemoryStatistics() override;
   
   void createLights();
   void loadModel();
@@ -45,6 +45,8 @@ class ApplicationLod : public T {
   void createTextureSampler();
 
   void updateView();
+  // rerecorded every frame with new matrix offset
+  void recordSceneBuffer(FrameResource& res, uint32_t offset_matrix);
 
   void createFramebuffers() override;
   void createRenderPasses() override;
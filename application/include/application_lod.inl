@@ -8,6 +8,7 @@
 
 #include "texture_loader.hpp"
 #include "geometry_loader.hpp"
+#include "memory_telemetry.hpp"
 
 #include "cmdline.h"
 
@@ -103,19 +104,20 @@ template<typename T>
 FrameResource ApplicationLod<T>::createFrameResource() {
   auto res = T::createFrameResource();
   res.setCommandBuffer("gbuffer", this->m_command_pools.at("graphics").createBuffer(vk::CommandBufferLevel::eSecondary));
-  res.buffer_views["uniform"] = BufferView{sizeof(UniformBufferObject), vk::BufferUsageFlagBits::eUniformBuffer};
-  res.buffer_views.at("uniform").bindTo(this->m_buffers.at("uniforms"));
+  res.transient_buffer = TransientBuffer{this->m_device, 64 * 1024};
   res.query_pools["timers"] = QueryPool{this->m_device, vk::QueryType::eTimestamp, 4};
   return res;
 }
 
 template<typename T>
 void ApplicationLod<T>::updateResourceDescriptors(FrameResource& res) {
-  res.descriptor_sets.at("matrix").bind(0, res.buffer_views.at("uniform"), vk::DescriptorType::eUniformBuffer);
+  // actual offset is given when binding
+  BufferRegion region{res.transient_buffer.buffer().get(), sizeof(UniformBufferObject)};
+  res.descriptor_sets.at("matrix").bind(0, region, vk::DescriptorType::eUniformBufferDynamic);
 }
 
 template<typename T>
-void ApplicationLod<T>::updateResourceCommandBuffers(FrameResource& res) {
+void ApplicationLod<T>::recordSceneBuffer(FrameResource& res, uint32_t offset_matrix) {
   res.commandBuffer("gbuffer")->reset({});
 
   vk::CommandBufferInheritanceInfo inheritanceInfo{};
@@ -128,7 +130,7 @@ void ApplicationLod<T>::updateResourceCommandBuffers(FrameResource& res) {
 
   res.commandBuffer("gbuffer")->bindPipeline(vk::PipelineBindPoint::eGraphics, this->m_pipelines.at("scene"));
 
-  res.commandBuffer("gbuffer")->bindDescriptorSets(vk::PipelineBindPoint::eGraphics, this->m_pipelines.at("scene").layout(), 0, {res.descriptor_sets.at("matrix"), this->m_descriptor_sets.at("lighting")}, {});
+  res.commandBuffer("gbuffer")->bindDescriptorSets(vk::PipelineBindPoint::eGraphics, this->m_pipelines.at("scene").layout(), 0, {res.descriptor_sets.at("matrix"), this->m_descriptor_sets.at("lighting")}, {offset_matrix});
 
   res.commandBuffer("gbuffer")->setViewport(0, viewport(this->resolution()));
   res.commandBuffer("gbuffer")->setScissor(0, rect(this->resolution()));
@@ -149,13 +151,15 @@ void ApplicationLod<T>::recordTransferBuffer(FrameResource& res) {
   //   this->m_statistics.add("gpu_draw", (values[3] - values[2]));
   // }
 
-  this->m_statistics.start("update");
+  static const Handle handle_update{"update"};
+  static const Handle handle_uploads{"uploads"};
+  this->m_statistics.start(handle_update);
   // upload node data
   m_model_lod.update(this->matrixView(), this->matrixFrustum());
   size_t curr_uploads = m_model_lod.numUploads();
-  this->m_statistics.add("uploads", double(curr_uploads));
+  this->m_statistics.add(handle_uploads, double(curr_uploads));
   if (curr_uploads > 0) {
-    this->m_statistics.add("update", this->m_statistics.stopValue("update") / double(curr_uploads));
+    this->m_statistics.add(handle_update, this->m_statistics.stopValue(handle_update) / double(curr_uploads));
   }
   // store upload num for later when reading out timers
   res.num_uploads = double(curr_uploads);
@@ -167,8 +171,7 @@ void ApplicationLod<T>::recordTransferBuffer(FrameResource& res) {
   // res.query_pools.at("timers").reset(res.commandBuffer("transfer"));
   // res.query_pools.at("timers").timestamp(res.commandBuffer("transfer"), 0, vk::PipelineStageFlagBits::eTopOfPipe);
 
-  m_model_lod.performCopiesCommand(res.commandBuffer("transfer"));
-  m_model_lod.updateDrawCommands(res.commandBuffer("transfer"));
+  m_model_lod.performCopiesCommand(res.commandBuffer("transfer"), this->transferQueueFamily());
   
   // res.query_pools.at("timers").timestamp(res.commandBuffer("transfer"), 1, vk::PipelineStageFlagBits::eBottomOfPipe);
   res.commandBuffer("transfer")->end();
@@ -182,20 +185,18 @@ void ApplicationLod<T>::recordDrawBuffer(FrameResource& res) {
   res.commandBuffer("primary")->begin({vk::CommandBufferUsageFlagBits::eSimultaneousUse | vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
   // always update, because last update could have been to other frame
   updateView();
-  res.commandBuffer("primary")->updateBuffer(
-    res.buffer_views.at("uniform").buffer(),
-    res.buffer_views.at("uniform").offset(),
-    sizeof(ubo_cam),
-    &ubo_cam
-  );
-  // make matrices visible to vertex shader
-  res.commandBuffer("primary").bufferBarrier(res.buffer_views.at("uniform"), 
-    vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite, 
-    vk::PipelineStageFlagBits::eVertexShader, vk::AccessFlagBits::eUniformRead
-  );
+  // coherent host writes are visible to the following submit
+  auto alloc_matrix = res.transient_buffer.upload(ubo_cam);
+  // scene buffer only depends on the matrix offset, which is the same unless other data was allocated first
+  if (!res.recorded("gbuffer", alloc_matrix.offset)) {
+    recordSceneBuffer(res, alloc_matrix.offset);
+    res.setRecorded("gbuffer", alloc_matrix.offset);
+  }
 
   res.query_pools.at("timers").timestamp(res.commandBuffer("primary"), 2, vk::PipelineStageFlagBits::eTopOfPipe);
 
+  // written on graphics queue, transfer queue only copies node data
+  m_model_lod.updateDrawCommands(res.commandBuffer("primary"));
   // make draw commands visible to drawindirect
   res.commandBuffer("primary").bufferBarrier(m_model_lod.viewDrawCommands(), 
     vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite, 
@@ -387,7 +388,7 @@ void ApplicationLod<T>::createTextureImage() {
   this->m_images["texture"] = BackedImage{this->m_device, pix_data.extent, pix_data.format, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst};
   this->m_allocators.at("images").allocate(this->m_images.at("texture"));
   
-  this->m_transferrer.uploadImageData(pix_data.ptr(), pix_data.size(), this->m_images.at("texture"), vk::ImageLayout::eShaderReadOnlyOptimal);
+  this->m_transferrer.uploadImageData(pix_data.ptr(0), pix_data.size(0), this->m_images.at("texture"), vk::ImageLayout::eShaderReadOnlyOptimal);
 }
 
 template<typename T>
@@ -395,6 +396,13 @@ void ApplicationLod<T>::createTextureSampler() {
   m_sampler = Sampler{this->m_device, vk::Filter::eLinear, vk::SamplerAddressMode::eRepeat};
 }
 
+template<typename T>
+void ApplicationLod<T>::recordMemoryStatistics() {
+  T::recordMemoryStatistics();
+  this->m_telemetry.record("lod_draw", m_model_lod.allocatorDraw());
+  this->m_telemetry.record("lod_stage", m_model_lod.allocatorStage());
+}
+
 template<typename T>
 void ApplicationLod<T>::updateDescriptors() {
   this->m_descriptor_sets.at("lighting").bind(1, m_model_lod.viewNodeLevels(), vk::DescriptorType::eStorageBuffer);
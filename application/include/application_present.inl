@@ -151,7 +151,8 @@ void ApplicationPresent<T>::createFrustra() {
 
 template<typename T>
 void ApplicationPresent<T>::receiveData(FrameResource& res) {
-  this->m_statistics.start("receive");
+  static const Handle handle_receive{"receive"};
+  this->m_statistics.start(handle_receive);
   glm::uvec2 res_worker = this->resolution() / m_frustum_cells;
   int size_chunk = int(res_worker.x * res_worker.y * 4);
   // copy into current subregion
@@ -159,7 +160,7 @@ void ApplicationPresent<T>::receiveData(FrameResource& res) {
   // copy chunk from process [1] to beginning
   offset -= size_chunk; 
   MPI::COMM_WORLD.Gather(MPI::IN_PLACE, size_chunk, MPI::BYTE, m_ptr_buff_transfer + offset, size_chunk, MPI::BYTE, 0);
-  this->m_statistics.stop("receive");
+  this->m_statistics.stop(handle_receive);
 }
 
 template<typename T>
@@ -31,9 +31,11 @@ class ApplicationScenegraph : public T {
   void logic() override;
   void recordDrawBuffer(FrameResource& res) override;
   void updateResourceCommandBuffers(FrameResource& res);
+  void recordSceneBuffer(FrameResource& res, std::vector<BufferRegion> const& regions_indirect = {});
   FrameResource createFrameResource() override;
   void updatePipelines() override;
   void updateDescriptors() override;
+  void recordMemoryStatistics() override;
 
   void createVertexBuffer();
   void onResize() override;
@@ -75,6 +77,15 @@ class ApplicationScenegraph : public T {
   Navigation m_navigator;
   glm::vec3 m_cam_old_pos;
   glm::vec3 m_cam_new_pos;
+  // draw scene with multi draw indirect, data is uploaded every frame
+  bool m_setting_indirect;
+  // graph version the indirect draws were collected at, they are collected again when nodes were added or removed
+  uint32_t m_scene_version;
+  Renderer::indirect_draws_t m_draws_indirect;
+  // gbuffer pass is split into secondary buffers recorded by jobs
+  std::size_t m_num_slices;
+  // buffer names of slices, resolved once
+  std::vector<Handle> m_handles_gbuffer;
   float m_frame_time;
   glm::vec3 m_last_translation;
   glm::fvec2 m_last_rotation;
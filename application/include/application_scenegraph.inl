@@ -5,6 +5,7 @@
 #include "wrap/surface.hpp"
 
 #include "texture_loader.hpp"
+#include "memory_telemetry.hpp"
 #include "frame_resource.hpp"
 #include "frame_resource.hpp"
 #include "geometry_loader.hpp"
@@ -30,6 +31,7 @@
 
 #include "cmdline.h"
 
+#include <algorithm>
 #include <iostream>
 
 struct UniformBufferObject {
@@ -41,7 +43,9 @@ struct UniformBufferObject {
 
 template<typename T>
 cmdline::parser ApplicationScenegraph<T>::getParser() {
-  return T::getParser();
+  cmdline::parser cmd_parse{T::getParser()};
+  cmd_parse.add("indirect", 'i', "draw scene with multi draw indirect");
+  return cmd_parse;
 }
 
 template<typename T>
@@ -60,6 +64,11 @@ ApplicationScenegraph<T>::ApplicationScenegraph(std::string const& resource_path
  ,m_navigator{&surf.window()}
  ,m_cam_old_pos{0.0f}
  ,m_cam_new_pos{0.0f}
+ ,m_setting_indirect{cmd_parse.exist("indirect")}
+ ,m_scene_version{~0u}
+ ,m_draws_indirect{}
+ ,m_num_slices{this->m_jobs.numWorkers() + 1}
+ ,m_handles_gbuffer{}
 {
   // check if input file was specified
   if (cmd_parse.rest().size() != 1) {
@@ -71,9 +80,14 @@ ApplicationScenegraph<T>::ApplicationScenegraph(std::string const& resource_path
     }
     exit(0);
   }
+  // skip decoding of textures loaded in previous runs
+  m_instance.dbTexture().setCacheDirectory(this->resourcePath() + "cache/");
+  m_instance.dbTexture().setJobSystem(this->m_jobs);
   scene_loader::json(cmd_parse.rest()[0], this->resourcePath(), &m_graph);
 
-  this->m_shaders.emplace("scene", Shader{this->m_device, {this->resourcePath() + "shaders/graph_renderer_vert.spv", this->resourcePath() + "shaders/graph_renderer_frag.spv"}});
+  // indirect draws read indices from instance attribute instead of push constants
+  std::string shader_vert = m_setting_indirect ? "shaders/graph_renderer_indirect_vert.spv" : "shaders/graph_renderer_vert.spv";
+  this->m_shaders.emplace("scene", Shader{this->m_device, {this->resourcePath() + shader_vert, this->resourcePath() + "shaders/graph_renderer_frag.spv"}});
   this->m_shaders.emplace("lights", Shader{this->m_device, {this->resourcePath() + "shaders/lighting_vert.spv", this->resourcePath() + "shaders/deferred_pbr_frag.spv"}});
   this->m_shaders.emplace("tonemapping", Shader{this->m_device, {this->resourcePath() + "shaders/fullscreen_vert.spv", this->resourcePath() + "shaders/tone_mapping_frag.spv"}});
 
@@ -91,6 +105,13 @@ ApplicationScenegraph<T>::ApplicationScenegraph(std::string const& resource_path
 
   createVertexBuffer();
 
+  this->m_statistics.addTimer("record_gbuffer");
+  // pools must not be used concurrently, each slice is recorded by one job at a time
+  for (std::size_t i = 0; i < m_num_slices; ++i) {
+    m_handles_gbuffer.emplace_back("gbuffer_" + std::to_string(i));
+    this->m_command_pools.emplace("gbuffer_" + std::to_string(i), CommandPool{this->m_device, this->m_device.getQueueIndex("graphics"), vk::CommandPoolCreateFlagBits::eResetCommandBuffer});
+  }
+
   this->createRenderResources();
 }
 
@@ -99,6 +120,17 @@ ApplicationScenegraph<T>::~ApplicationScenegraph() {
   this->shutDown();
 }
 
+template<typename T>
+void ApplicationScenegraph<T>::recordMemoryStatistics() {
+  T::recordMemoryStatistics();
+  this->m_telemetry.record("textures", m_instance.dbTexture().allocator());
+  this->m_telemetry.recordContention("textures", m_instance.dbTexture().allocator());
+  this->m_telemetry.record("materials", m_instance.dbMaterial().allocator());
+  this->m_telemetry.record("lights", m_instance.dbLight().allocator());
+  this->m_telemetry.record("transforms", m_instance.dbTransform().allocator());
+  this->m_telemetry.record("cameras", m_instance.dbCamera().allocator());
+}
+
 template<typename T>
 Scenegraph& ApplicationScenegraph<T>::getGraph(){
   return m_graph;
@@ -107,9 +139,16 @@ Scenegraph& ApplicationScenegraph<T>::getGraph(){
 template<typename T>
 FrameResource ApplicationScenegraph<T>::createFrameResource() {
   auto res = T::createFrameResource();
-  res.command_buffers.emplace("gbuffer", this->m_command_pools.at("graphics").createBuffer(vk::CommandBufferLevel::eSecondary));
+  for (std::size_t i = 0; i < m_num_slices; ++i) {
+    auto name = "gbuffer_" + std::to_string(i);
+    res.command_buffers.emplace(name, this->m_command_pools.at(name).createBuffer(vk::CommandBufferLevel::eSecondary));
+  }
   res.command_buffers.emplace("lighting", this->m_command_pools.at("graphics").createBuffer(vk::CommandBufferLevel::eSecondary));
   res.command_buffers.emplace("tonemapping", this->m_command_pools.at("graphics").createBuffer(vk::CommandBufferLevel::eSecondary));
+  if (m_setting_indirect) {
+    // instance data and draw commands
+    res.transient_buffer = TransientBuffer{this->m_device, 4 * 1024 * 1024};
+  }
   return res;
 }
 
@@ -187,28 +226,61 @@ void ApplicationScenegraph<T>::logic() {
 }
 
 template<typename T>
-void ApplicationScenegraph<T>::updateResourceCommandBuffers(FrameResource& res) {
-  res.commandBuffer("gbuffer")->reset({});
-
+void ApplicationScenegraph<T>::recordSceneBuffer(FrameResource& res, std::vector<BufferRegion> const& regions_indirect) {
   vk::CommandBufferInheritanceInfo inheritanceInfo{};
   inheritanceInfo.renderPass = m_render_pass;
   inheritanceInfo.framebuffer = m_framebuffer;
   inheritanceInfo.subpass = 0;
 
-  // first pass
-  res.commandBuffer("gbuffer").begin({vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eSimultaneousUse, &inheritanceInfo});
+  // indirect draws are few, they are recorded into the first slice
+  std::vector<Renderer::draw_t> draws{};
+  if (!m_setting_indirect) {
+    RenderVisitor render_visitor{};
+    m_graph.accept(render_visitor);
+    draws = m_renderer.sortDraws(render_visitor.visibleNodes());
+  }
+  // small scenes leave the last slices empty
+  std::size_t const min_draws_slice = 256;
+  auto draws_slice = std::max((draws.size() + m_num_slices - 1) / m_num_slices, min_draws_slice);
+
+  auto record_slice = [&](std::size_t i) {
+    auto& buffer = res.commandBuffer(m_handles_gbuffer[i]);
+    buffer->reset({});
+    // first pass
+    buffer.begin({vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eSimultaneousUse, &inheritanceInfo});
+
+    buffer.bindPipeline(this->m_pipelines.at("scene"));
+    buffer.bindDescriptorSets(0, {this->m_descriptor_sets.at("camera"), this->m_descriptor_sets.at("transform"), this->m_descriptor_sets.at("material")}, {});
+    buffer->setViewport(0, viewport(this->resolution()));
+    buffer->setScissor(0, rect(this->resolution()));
+    // draw collected models
+    if (m_setting_indirect) {
+      if (i == 0) {
+        m_renderer.drawIndirect(buffer, m_draws_indirect, regions_indirect);
+      }
+    }
+    else {
+      m_renderer.draw(buffer, draws, std::min(i * draws_slice, draws.size()), std::min((i + 1) * draws_slice, draws.size()));
+    }
+
+    buffer.end();
+  };
+  static const Handle handle_record{"record_gbuffer"};
+  this->m_statistics.start(handle_record);
+  this->m_jobs.parallelFor(0, m_num_slices, record_slice);
+  this->m_statistics.stop(handle_record);
+}
 
-  res.commandBuffer("gbuffer").bindPipeline(this->m_pipelines.at("scene"));
-  res.commandBuffer("gbuffer").bindDescriptorSets(0, {this->m_descriptor_sets.at("camera"), this->m_descriptor_sets.at("transform"), this->m_descriptor_sets.at("material")}, {});
-  res.commandBuffer("gbuffer")->setViewport(0, viewport(this->resolution()));
-  res.commandBuffer("gbuffer")->setScissor(0, rect(this->resolution()));
+template<typename T>
+void ApplicationScenegraph<T>::updateResourceCommandBuffers(FrameResource& res) {
+  if (!m_setting_indirect) {
+    recordSceneBuffer(res);
+  }
 
-  RenderVisitor render_visitor{};
-  m_graph.accept(render_visitor);
-  // draw collected models
-  m_renderer.draw(res.commandBuffer("gbuffer"), render_visitor.visibleNodes());
+  vk::CommandBufferInheritanceInfo inheritanceInfo{};
+  inheritanceInfo.renderPass = m_render_pass;
+  inheritanceInfo.framebuffer = m_framebuffer;
 
-  res.commandBuffer("gbuffer").end();
   //deferred shading pass 
   inheritanceInfo.subpass = 1;
   res.commandBuffer("lighting")->reset({});
@@ -242,6 +314,23 @@ void ApplicationScenegraph<T>::updateResourceCommandBuffers(FrameResource& res)
 
 template<typename T>
 void ApplicationScenegraph<T>::recordDrawBuffer(FrameResource& res) {
+  if (m_setting_indirect) {
+    if (m_scene_version != m_graph.getVersion()) {
+      RenderVisitor render_visitor{};
+      m_graph.accept(render_visitor);
+      m_draws_indirect = m_renderer.collectIndirect(render_visitor.visibleNodes());
+      m_scene_version = m_graph.getVersion();
+    }
+    // transient data of the previous use of this resource is no longer read
+    auto regions = m_renderer.uploadIndirect(m_draws_indirect, res.transient_buffer);
+    // allocations repeat every frame, so the buffers only change with the scene
+    uint64_t state = uint64_t(m_scene_version) << 32 | (regions.empty() ? 0 : regions.front().offset());
+    if (!res.recorded("gbuffer", state)) {
+      recordSceneBuffer(res, regions);
+      res.setRecorded("gbuffer", state);
+    }
+  }
+
   res.commandBuffer("primary")->reset({});
 
   res.commandBuffer("primary")->begin({vk::CommandBufferUsageFlagBits::eSimultaneousUse | vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
@@ -257,8 +346,12 @@ void ApplicationScenegraph<T>::recordDrawBuffer(FrameResource& res) {
   );
 
   res.commandBuffer("primary")->beginRenderPass(m_framebuffer.beginInfo(), vk::SubpassContents::eSecondaryCommandBuffers);
-  // execute gbuffer creation buffer
-  res.commandBuffer("primary")->executeCommands({res.commandBuffer("gbuffer")});
+  // execute gbuffer creation buffers
+  std::vector<vk::CommandBuffer> buffers_gbuffer{};
+  for (std::size_t i = 0; i < m_num_slices; ++i) {
+    buffers_gbuffer.emplace_back(res.commandBuffer(m_handles_gbuffer[i]).get());
+  }
+  res.commandBuffer("primary")->executeCommands(buffers_gbuffer);
   
   res.commandBuffer("primary")->nextSubpass(vk::SubpassContents::eSecondaryCommandBuffers);
   // execute lighting buffer
@@ -331,7 +424,13 @@ void ApplicationScenegraph<T>::createPipelines() {
   info_pipe.setAttachmentBlending(colorBlendAttachment, 2);
 
   info_pipe.setShader(this->m_shaders.at("scene"));
-  info_pipe.setVertexInput(m_model.vertexInfo());
+  auto info_vert = m_model.vertexInfo();
+  if (m_setting_indirect) {
+    // transform and material index per instance
+    info_vert.setBinding(1, sizeof(glm::u32vec2), vk::VertexInputRate::eInstance);
+    info_vert.setAttribute(1, 3, vk::Format::eR32G32Uint, 0);
+  }
+  info_pipe.setVertexInput(info_vert);
   info_pipe.setPass(m_render_pass, 0);
   info_pipe.addDynamic(vk::DynamicState::eViewport);
   info_pipe.addDynamic(vk::DynamicState::eScissor);
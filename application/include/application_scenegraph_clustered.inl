@@ -5,6 +5,7 @@
 #include "wrap/surface.hpp"
 
 #include "texture_loader.hpp"
+#include "memory_telemetry.hpp"
 #include "frame_resource.hpp"
 #include "frame_resource.hpp"
 #include "geometry_loader.hpp"
@@ -50,7 +51,9 @@ struct LightGridBufferObject {
 
 template<typename T>
 cmdline::parser ApplicationScenegraphClustered<T>::getParser() {
-  return T::getParser();
+  cmdline::parser cmd_parse{T::getParser()};
+  cmd_parse.add("indirect", 'i', "draw scene with multi draw indirect");
+  return cmd_parse;
 }
 
 template<typename T>
@@ -76,6 +79,9 @@ ApplicationScenegraphClustered<T>::ApplicationScenegraphClustered(std::string co
  ,m_navigator{&surf.window()}
  ,m_cam_old_pos{0.0f}
  ,m_cam_new_pos{0.0f}
+ ,m_setting_indirect{cmd_parse.exist("indirect")}
+ ,m_scene_version{~0u}
+ ,m_draws_indirect{}
 {
   // check if input file was specified
   if (cmd_parse.rest().size() != 1) {
@@ -87,9 +93,14 @@ ApplicationScenegraphClustered<T>::ApplicationScenegraphClustered(std::string co
     }
     exit(0);
   }
+  // skip decoding of textures loaded in previous runs
+  m_instance.dbTexture().setCacheDirectory(this->resourcePath() + "cache/");
+  m_instance.dbTexture().setJobSystem(this->m_jobs);
   scene_loader::json(cmd_parse.rest()[0], this->resourcePath(), &m_graph);
 
-  this->m_shaders.emplace("scene", Shader{this->m_device, {this->resourcePath() + "shaders/graph_renderer_vert.spv", this->resourcePath() + "shaders/graph_renderer_frag.spv"}});
+  // indirect draws read indices from instance attribute instead of push constants
+  std::string shader_vert = m_setting_indirect ? "shaders/graph_renderer_indirect_vert.spv" : "shaders/graph_renderer_vert.spv";
+  this->m_shaders.emplace("scene", Shader{this->m_device, {this->resourcePath() + shader_vert, this->resourcePath() + "shaders/graph_renderer_frag.spv"}});
   this->m_shaders.emplace("tonemapping", Shader{this->m_device, {this->resourcePath() + "shaders/fullscreen_vert.spv", this->resourcePath() + "shaders/tone_mapping_frag.spv"}});
   this->m_shaders.emplace("quad", Shader{this->m_device, {this->resourcePath() + "shaders/quad_vert.spv", this->resourcePath() + "shaders/deferred_clustered_pbr_frag.spv"}});
   this->m_shaders.emplace("compute", Shader{this->m_device, {this->resourcePath() + "shaders/light_grid_comp.spv"}});
@@ -118,6 +129,17 @@ ApplicationScenegraphClustered<T>::~ApplicationScenegraphClustered() {
   this->shutDown();
 }
 
+template<typename T>
+void ApplicationScenegraphClustered<T>::recordMemoryStatistics() {
+  T::recordMemoryStatistics();
+  this->m_telemetry.record("textures", m_instance.dbTexture().allocator());
+  this->m_telemetry.recordContention("textures", m_instance.dbTexture().allocator());
+  this->m_telemetry.record("materials", m_instance.dbMaterial().allocator());
+  this->m_telemetry.record("lights", m_instance.dbLight().allocator());
+  this->m_telemetry.record("transforms", m_instance.dbTransform().allocator());
+  this->m_telemetry.record("cameras", m_instance.dbCamera().allocator());
+}
+
 template<typename T>
 FrameResource ApplicationScenegraphClustered<T>::createFrameResource() {
   auto res = T::createFrameResource();
@@ -125,7 +147,10 @@ FrameResource ApplicationScenegraphClustered<T>::createFrameResource() {
   res.command_buffers.emplace("lighting", this->m_command_pools.at("graphics").createBuffer(vk::CommandBufferLevel::eSecondary));
   res.command_buffers.emplace("tonemapping", this->m_command_pools.at("graphics").createBuffer(vk::CommandBufferLevel::eSecondary));
   res.command_buffers.emplace("compute", this->m_command_pools.at("graphics").createBuffer(vk::CommandBufferLevel::eSecondary));
-
+  if (m_setting_indirect) {
+    // instance data and draw commands
+    res.transient_buffer = TransientBuffer{this->m_device, 4 * 1024 * 1024};
+  }
   return res;
 }
 
@@ -230,6 +255,36 @@ void ApplicationScenegraphClustered<T>::updateLightGrid() {
                                  this->m_buffer_views.at("lightgrid"));
 }
 
+template<typename T>
+void ApplicationScenegraphClustered<T>::recordSceneBuffer(FrameResource& res, std::vector<BufferRegion> const& regions_indirect) {
+  res.commandBuffer("gbuffer")->reset({});
+
+  vk::CommandBufferInheritanceInfo inheritanceInfo{};
+  inheritanceInfo.renderPass = m_render_pass;
+  inheritanceInfo.framebuffer = m_framebuffer;
+  inheritanceInfo.subpass = 0;
+
+  // first pass
+  res.commandBuffer("gbuffer").begin({vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eSimultaneousUse, &inheritanceInfo});
+
+  res.commandBuffer("gbuffer").bindPipeline(this->m_pipelines.at("scene"));
+  res.commandBuffer("gbuffer").bindDescriptorSets(0, {this->m_descriptor_sets.at("camera"), this->m_descriptor_sets.at("transform"), this->m_descriptor_sets.at("material")}, {});
+  res.commandBuffer("gbuffer")->setViewport(0, viewport(this->resolution()));
+  res.commandBuffer("gbuffer")->setScissor(0, rect(this->resolution()));
+
+  // draw collected models
+  if (m_setting_indirect) {
+    m_renderer.drawIndirect(res.commandBuffer("gbuffer"), m_draws_indirect, regions_indirect);
+  }
+  else {
+    RenderVisitor render_visitor{};
+    m_graph.accept(render_visitor);
+    m_renderer.draw(res.commandBuffer("gbuffer"), render_visitor.visibleNodes());
+  }
+
+  res.commandBuffer("gbuffer").end();
+}
+
 template<typename T>
 void ApplicationScenegraphClustered<T>::updateResourceCommandBuffers(FrameResource& res) {
   vk::CommandBufferInheritanceInfo inheritanceInfo{};
@@ -254,26 +309,12 @@ void ApplicationScenegraphClustered<T>::updateResourceCommandBuffers(FrameResour
 
   res.commandBuffer("compute")->end();
 
-  res.commandBuffer("gbuffer")->reset({});
+  if (!m_setting_indirect) {
+    recordSceneBuffer(res);
+  }
 
   inheritanceInfo.renderPass = m_render_pass;
   inheritanceInfo.framebuffer = m_framebuffer;
-  inheritanceInfo.subpass = 0;
-
-  // first pass
-  res.commandBuffer("gbuffer").begin({vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eSimultaneousUse, &inheritanceInfo});
-
-  res.commandBuffer("gbuffer").bindPipeline(this->m_pipelines.at("scene"));
-  res.commandBuffer("gbuffer").bindDescriptorSets(0, {this->m_descriptor_sets.at("camera"), this->m_descriptor_sets.at("transform"), this->m_descriptor_sets.at("material")}, {});
-  res.commandBuffer("gbuffer")->setViewport(0, viewport(this->resolution()));
-  res.commandBuffer("gbuffer")->setScissor(0, rect(this->resolution()));
-
-  RenderVisitor render_visitor{};
-  m_graph.accept(render_visitor);
-  // draw collected models
-  m_renderer.draw(res.commandBuffer("gbuffer"), render_visitor.visibleNodes());
-
-  res.commandBuffer("gbuffer").end();
   //deferred shading pass 
   inheritanceInfo.subpass = 1;
   res.commandBuffer("lighting")->reset({});
@@ -305,6 +346,23 @@ void ApplicationScenegraphClustered<T>::updateResourceCommandBuffers(FrameResour
 
 template<typename T>
 void ApplicationScenegraphClustered<T>::recordDrawBuffer(FrameResource& res) {
+  if (m_setting_indirect) {
+    if (m_scene_version != m_graph.getVersion()) {
+      RenderVisitor render_visitor{};
+      m_graph.accept(render_visitor);
+      m_draws_indirect = m_renderer.collectIndirect(render_visitor.visibleNodes());
+      m_scene_version = m_graph.getVersion();
+    }
+    // transient data of the previous use of this resource is no longer read
+    auto regions = m_renderer.uploadIndirect(m_draws_indirect, res.transient_buffer);
+    // allocations repeat every frame, so the buffer only changes with the scene
+    uint64_t state = uint64_t(m_scene_version) << 32 | (regions.empty() ? 0 : regions.front().offset());
+    if (!res.recorded("gbuffer", state)) {
+      recordSceneBuffer(res, regions);
+      res.setRecorded("gbuffer", state);
+    }
+  }
+
   res.commandBuffer("primary")->reset({});
 
   res.commandBuffer("primary")->begin({vk::CommandBufferUsageFlagBits::eSimultaneousUse | vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
@@ -397,7 +455,13 @@ void ApplicationScenegraphClustered<T>::createPipelines() {
   info_pipe.setAttachmentBlending(colorBlendAttachment, 2);
 
   info_pipe.setShader(this->m_shaders.at("scene"));
-  info_pipe.setVertexInput(m_model.vertexInfo());
+  auto info_vert = m_model.vertexInfo();
+  if (m_setting_indirect) {
+    // transform and material index per instance
+    info_vert.setBinding(1, sizeof(glm::u32vec2), vk::VertexInputRate::eInstance);
+    info_vert.setAttribute(1, 3, vk::Format::eR32G32Uint, 0);
+  }
+  info_pipe.setVertexInput(info_vert);
   info_pipe.setPass(m_render_pass, 0);
   info_pipe.addDynamic(vk::DynamicState::eViewport);
   info_pipe.addDynamic(vk::DynamicState::eScissor);
@@ -304,7 +304,7 @@ void ApplicationSimple<T>::createTextureImage() {
   this->m_images["texture"] = BackedImage{this->m_device, pix_data.extent, pix_data.format, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst};
   this->m_allocators.at("images").allocate(this->m_images.at("texture"));
  
-  this->m_transferrer.uploadImageData(pix_data.ptr(), pix_data.size(), this->m_images.at("texture"), vk::ImageLayout::eShaderReadOnlyOptimal);
+  this->m_transferrer.uploadImageData(pix_data.ptr(0), pix_data.size(0), this->m_images.at("texture"), vk::ImageLayout::eShaderReadOnlyOptimal);
 }
 
 template<typename T>
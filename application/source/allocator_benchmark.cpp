@@ -0,0 +1,454 @@
+#include "allocator_block.hpp"
+#include "allocator_buddy.hpp"
+#include "allocator_concurrent.hpp"
+#include "allocator_static.hpp"
+#include "host_resource.hpp"
+#include "memory_backend.hpp"
+#include "averager.hpp"
+#include "wrap/timer.hpp"
+
+#include "cmdline.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// replays allocation traces against the allocators, backed by host memory
+
+struct trace_op_t {
+  bool alloc;
+  size_t id;
+  vk::DeviceSize size;
+  vk::DeviceSize alignment;
+};
+using trace_t = std::vector<trace_op_t>;
+
+struct strategy_t {
+  std::string name;
+  vk::DeviceSize block_bytes;
+  std::function<std::unique_ptr<Allocator>(std::shared_ptr<MemoryBackend> const&)> create;
+  // bytes relocated after each operation, block allocator only
+  vk::DeviceSize defrag_budget;
+};
+
+struct result_t {
+  Averager<double> time_alloc;
+  Averager<double> time_free;
+  double peak_fragmentation = 0.0;
+  std::size_t peak_blocks = 0;
+  vk::DeviceSize peak_overhead = 0;
+  Averager<double> reserved;
+  vk::DeviceSize bytes_moved = 0;
+  std::size_t failed = 0;
+};
+
+static vk::MemoryRequirements requirements(vk::DeviceSize size, vk::DeviceSize alignment) {
+  vk::MemoryRequirements reqs{};
+  reqs.size = size;
+  reqs.alignment = alignment;
+  reqs.memoryTypeBits = 1u;
+  return reqs;
+}
+
+// remove random live resource
+static void free_random(std::mt19937& rng, std::vector<trace_op_t>& live, trace_t& trace) {
+  std::uniform_int_distribution<size_t> dist_idx{0, live.size() - 1};
+  auto idx = dist_idx(rng);
+  trace.push_back(trace_op_t{false, live[idx].id, live[idx].size, live[idx].alignment});
+  std::swap(live[idx], live.back());
+  live.pop_back();
+}
+
+static void free_all(std::vector<trace_op_t>& live, trace_t& trace) {
+  for (auto const& op : live) {
+    trace.push_back(trace_op_t{false, op.id, op.size, op.alignment});
+  }
+  live.clear();
+}
+
+// square rgba8 textures, streamed in with eviction over budget
+static trace_t trace_textures(std::mt19937& rng, size_t count) {
+  vk::DeviceSize const budget = vk::DeviceSize{512} * 1024 * 1024;
+  std::uniform_int_distribution<int> dist_exp{6, 11};
+  trace_t trace{};
+  std::vector<trace_op_t> live{};
+  vk::DeviceSize bytes_live = 0;
+  for (size_t i = 0; i < count; ++i) {
+    auto edge = vk::DeviceSize{1} << dist_exp(rng);
+    auto op = trace_op_t{true, i, edge * edge * 4, 0x10000};
+    // evict oldest textures first
+    while (bytes_live + op.size > budget) {
+      auto const& evicted = live.front();
+      trace.push_back(trace_op_t{false, evicted.id, evicted.size, evicted.alignment});
+      bytes_live -= evicted.size;
+      live.erase(live.begin());
+    }
+    trace.push_back(op);
+    live.push_back(op);
+    bytes_live += op.size;
+  }
+  free_all(live, trace);
+  return trace;
+}
+
+// vertex and index buffers of varying size, loaded and unloaded
+static trace_t trace_geometry(std::mt19937& rng, size_t count) {
+  size_t const target_live = 256;
+  std::uniform_int_distribution<vk::DeviceSize> dist_size{1024, 4 * 1024 * 1024};
+  std::bernoulli_distribution dist_free{0.5};
+  trace_t trace{};
+  std::vector<trace_op_t> live{};
+  for (size_t i = 0; i < count; ++i) {
+    if (live.size() >= target_live || (!live.empty() && dist_free(rng))) {
+      free_random(rng, live, trace);
+    }
+    auto op = trace_op_t{true, i, dist_size(rng), 256};
+    trace.push_back(op);
+    live.push_back(op);
+  }
+  free_all(live, trace);
+  return trace;
+}
+
+// fixed size lod slots, replaced in random order
+static trace_t trace_lod(std::mt19937& rng, size_t count) {
+  size_t const num_slots = 1024;
+  vk::DeviceSize const slot_bytes = 64 * 1024;
+  trace_t trace{};
+  std::vector<trace_op_t> live{};
+  for (size_t i = 0; i < count; ++i) {
+    if (live.size() >= num_slots) {
+      free_random(rng, live, trace);
+    }
+    auto op = trace_op_t{true, i, slot_bytes, 256};
+    trace.push_back(op);
+    live.push_back(op);
+  }
+  free_all(live, trace);
+  return trace;
+}
+
+// arbitrary sizes and power of two alignments
+static trace_t trace_random(std::mt19937& rng, size_t count, vk::DeviceSize max_size) {
+  size_t const target_live = 128;
+  std::uniform_int_distribution<vk::DeviceSize> dist_size{1, max_size};
+  std::uniform_int_distribution<int> dist_align{0, 16};
+  std::uniform_int_distribution<size_t> dist_live{0, 2 * target_live};
+  trace_t trace{};
+  std::vector<trace_op_t> live{};
+  for (size_t i = 0; i < count; ++i) {
+    // free with probability rising with number of live resources
+    while (!live.empty() && dist_live(rng) < live.size()) {
+      free_random(rng, live, trace);
+    }
+    auto op = trace_op_t{true, i, dist_size(rng), vk::DeviceSize{1} << dist_align(rng)};
+    trace.push_back(op);
+    live.push_back(op);
+  }
+  free_all(live, trace);
+  return trace;
+}
+
+// occupied ranges per memory block
+using occupancy_t = std::map<VkDeviceMemory, std::map<vk::DeviceSize, vk::DeviceSize>>;
+
+static void validate_alloc(HostResource const& res, trace_op_t const& op, vk::DeviceSize block_bytes, occupancy_t& occupancy) {
+  auto offset = res.offset();
+  auto end = offset + op.size;
+  if (offset % op.alignment != 0) {
+    throw std::runtime_error{"resource " + std::to_string(op.id) + " at offset " + std::to_string(offset) + " violates alignment " + std::to_string(op.alignment)};
+  }
+  if (end > block_bytes) {
+    throw std::runtime_error{"resource " + std::to_string(op.id) + " exceeds block end"};
+  }
+  auto& ranges = occupancy[VkDeviceMemory(res.memory())];
+  auto iter_next = ranges.lower_bound(offset);
+  if (iter_next != ranges.end() && iter_next->first < end) {
+    throw std::runtime_error{"resource " + std::to_string(op.id) + " overlaps following resource"};
+  }
+  if (iter_next != ranges.begin() && std::prev(iter_next)->second > offset) {
+    throw std::runtime_error{"resource " + std::to_string(op.id) + " overlaps preceding resource"};
+  }
+  ranges.emplace(offset, end);
+}
+
+static void validate_free(HostResource const& res, occupancy_t& occupancy) {
+  occupancy.at(VkDeviceMemory(res.memory())).erase(res.offset());
+}
+
+// moves resources out of least occupied block like the applications do, with host copies
+static void defragment(BlockAllocator& allocator, std::map<size_t, HostResource>& resources, vk::DeviceSize block_bytes, vk::DeviceSize budget, bool validate, occupancy_t& occupancy, result_t& result) {
+  vk::DeviceSize bytes_moved = 0;
+  for (auto const& handle : allocator.relocationCandidates()) {
+    if (bytes_moved >= budget) break;
+    auto iter_res = std::find_if(resources.begin(), resources.end(), [&handle](std::pair<size_t const, HostResource> const& pair_res) {
+      return pair_res.second.handle() == handle;
+    });
+    auto& res = iter_res->second;
+    auto const& requirements = res.requirements();
+    HostResource res_new{requirements};
+    if (!allocator.allocateElsewhere(res_new, res)) {
+      throw std::runtime_error{"planned relocation of resource " + std::to_string(iter_res->first) + " does not fit"};
+    }
+    std::memcpy(allocator.map(res_new), allocator.map(res), size_t(requirements.size));
+    if (validate) {
+      validate_free(res, occupancy);
+      validate_alloc(res_new, trace_op_t{true, iter_res->first, requirements.size, requirements.alignment}, block_bytes, occupancy);
+    }
+    // previous range is freed with temporary
+    res.swap(res_new);
+    bytes_moved += requirements.size;
+  }
+  allocator.releaseEmptyBlocks();
+  result.bytes_moved += bytes_moved;
+}
+
+static result_t replay(trace_t const& trace, Allocator& allocator, vk::DeviceSize block_bytes, vk::DeviceSize defrag_budget, bool validate) {
+  result_t result{};
+  auto allocator_block = dynamic_cast<BlockAllocator*>(&allocator);
+  std::map<size_t, HostResource> resources{};
+  occupancy_t occupancy{};
+  vk::DeviceSize bytes_live = 0;
+  Timer timer{};
+
+  for (auto const& op : trace) {
+    if (op.alloc) {
+      HostResource res{requirements(op.size, op.alignment)};
+      try {
+        timer.start();
+        allocator.allocate(res);
+        result.time_alloc.add(timer.durationEnd());
+      }
+      catch (std::length_error const&) {
+        ++result.failed;
+        continue;
+      }
+      if (validate) {
+        validate_alloc(res, op, block_bytes, occupancy);
+        // tag first and last byte to detect overwrites
+        auto ptr = allocator.map(res);
+        ptr[0] = uint8_t(op.id);
+        ptr[op.size - 1] = uint8_t(op.id);
+      }
+      bytes_live += op.size;
+      resources.emplace(op.id, std::move(res));
+    }
+    else {
+      auto iter_res = resources.find(op.id);
+      // allocation failed
+      if (iter_res == resources.end()) continue;
+
+      if (validate) {
+        auto ptr = allocator.map(iter_res->second);
+        if (ptr[0] != uint8_t(op.id) || ptr[op.size - 1] != uint8_t(op.id)) {
+          throw std::runtime_error{"resource " + std::to_string(op.id) + " was overwritten"};
+        }
+        validate_free(iter_res->second, occupancy);
+      }
+      bytes_live -= op.size;
+      // resource frees itself on destruction
+      timer.start();
+      resources.erase(iter_res);
+      result.time_free.add(timer.durationEnd());
+    }
+
+    if (defrag_budget > 0 && allocator_block != nullptr) {
+      defragment(*allocator_block, resources, block_bytes, defrag_budget, validate, occupancy, result);
+    }
+
+    if (validate && allocator.bytesUsed() != bytes_live) {
+      throw std::runtime_error{"allocator reports " + std::to_string(allocator.bytesUsed()) + " used bytes, expected " + std::to_string(bytes_live)};
+    }
+    result.peak_fragmentation = std::max(result.peak_fragmentation, allocator.fragmentation());
+    result.peak_blocks = std::max(result.peak_blocks, allocator.numBlocks());
+    result.peak_overhead = std::max(result.peak_overhead, allocator.bytesOverhead());
+    result.reserved.add(double(allocator.bytesReserved()));
+  }
+  return result;
+}
+
+static std::vector<strategy_t> strategies(vk::DeviceSize block_bytes, vk::DeviceSize static_bytes) {
+  return std::vector<strategy_t>{
+    strategy_t{"block", block_bytes, [block_bytes](std::shared_ptr<MemoryBackend> const& backend) {
+      return std::unique_ptr<Allocator>{new BlockAllocator{backend, 0, uint32_t(block_bytes)}};
+    }, 0},
+    strategy_t{"defragmented block", block_bytes, [block_bytes](std::shared_ptr<MemoryBackend> const& backend) {
+      return std::unique_ptr<Allocator>{new BlockAllocator{backend, 0, uint32_t(block_bytes)}};
+    }, block_bytes / 16},
+    strategy_t{"buddy", block_bytes, [block_bytes](std::shared_ptr<MemoryBackend> const& backend) {
+      return std::unique_ptr<Allocator>{new BuddyAllocator{backend, 0, block_bytes}};
+    }, 0},
+    strategy_t{"concurrent buddy", block_bytes, [block_bytes](std::shared_ptr<MemoryBackend> const& backend) {
+      return std::unique_ptr<Allocator>{new ConcurrentAllocator{std::unique_ptr<Allocator>{new BuddyAllocator{backend, 0, block_bytes}}, block_bytes / 4}};
+    }, 0},
+    strategy_t{"static", static_bytes, [static_bytes](std::shared_ptr<MemoryBackend> const& backend) {
+      return std::unique_ptr<Allocator>{new StaticAllocator{backend, 0, size_t(static_bytes)}};
+    }, 0}
+  };
+}
+
+static void benchmark(std::string const& name, trace_t const& trace) {
+  std::cout << name << " (" << trace.size() << " operations)" << std::endl;
+  // same block size as texture database
+  for (auto const& strategy : strategies(4 * 4 * 3840 * 2160, vk::DeviceSize{1} << 30)) {
+    auto backend = std::make_shared<HostMemoryBackend>();
+    auto allocator = strategy.create(backend);
+    auto result = replay(trace, *allocator, strategy.block_bytes, strategy.defrag_budget, false);
+    std::cout << "  " << strategy.name << " allocator" << std::endl;
+    std::cout << "    allocate: " << result.time_alloc.get() * 1000.0 << " microseconds, max " << result.time_alloc.max() * 1000.0 << std::endl;
+    std::cout << "    free: " << result.time_free.get() * 1000.0 << " microseconds, max " << result.time_free.max() * 1000.0 << std::endl;
+    std::cout << "    peak fragmentation: " << result.peak_fragmentation << std::endl;
+    std::cout << "    peak blocks: " << result.peak_blocks << std::endl;
+    std::cout << "    peak overhead: " << result.peak_overhead / 1024 / 1024 << " MB" << std::endl;
+    std::cout << "    average reserved: " << result.reserved.get() / 1024.0 / 1024.0 << " MB" << std::endl;
+    if (result.bytes_moved > 0) {
+      std::cout << "    relocated: " << result.bytes_moved / 1024 / 1024 << " MB" << std::endl;
+    }
+    if (result.failed > 0) {
+      std::cout << "    failed allocations: " << result.failed << std::endl;
+    }
+  }
+}
+
+static void fuzz(std::mt19937& rng, size_t count) {
+  vk::DeviceSize const block_bytes = 16 * 1024 * 1024;
+  auto trace = trace_random(rng, count, block_bytes / 16);
+  for (auto const& strategy : strategies(block_bytes, block_bytes * 8)) {
+    auto backend = std::make_shared<HostMemoryBackend>();
+    {
+      auto allocator = strategy.create(backend);
+      auto result = replay(trace, *allocator, strategy.block_bytes, strategy.defrag_budget, true);
+      if (allocator->bytesUsed() != 0) {
+        throw std::runtime_error{strategy.name + " allocator still reports used memory"};
+      }
+      std::cout << "  " << strategy.name << " allocator passed, " << result.failed << " allocations out of memory";
+      if (result.bytes_moved > 0) {
+        std::cout << ", " << result.bytes_moved / 1024 << " KB relocated";
+      }
+      std::cout << std::endl;
+    }
+    if (backend->numBlocks() != 0) {
+      throw std::runtime_error{strategy.name + " allocator leaked memory blocks"};
+    }
+  }
+}
+
+// every thread replays own trace against one allocator, like parallel asset loading
+static void contention(std::mt19937& rng, size_t count, unsigned num_threads, bool validate) {
+  vk::DeviceSize const block_bytes = 4 * 4 * 3840 * 2160;
+  std::vector<trace_t> traces{};
+  for (unsigned i = 0; i < num_threads; ++i) {
+    traces.emplace_back(trace_random(rng, count, 256 * 1024));
+  }
+  std::cout << num_threads << " threads (" << traces.front().size() << " operations each)" << std::endl;
+  // without chunks every operation takes the shared lock
+  for (auto chunk_bytes : {vk::DeviceSize{0}, block_bytes / 4}) {
+    auto backend = std::make_shared<HostMemoryBackend>();
+    double time = 0.0;
+    {
+      ConcurrentAllocator allocator{std::unique_ptr<Allocator>{new BuddyAllocator{backend, 0, block_bytes}}, chunk_bytes};
+      std::vector<std::string> errors(num_threads);
+      Timer timer{};
+      timer.start();
+      std::vector<std::thread> threads{};
+      for (unsigned i = 0; i < num_threads; ++i) {
+        threads.emplace_back([&allocator, &traces, &errors, i, validate]() {
+          std::map<size_t, HostResource> resources{};
+          try {
+            for (auto const& op : traces[i]) {
+              if (op.alloc) {
+                HostResource res{requirements(op.size, op.alignment)};
+                allocator.allocate(res);
+                if (validate) {
+                  // tag with thread and operation to detect overlaps between threads
+                  auto ptr = allocator.map(res);
+                  ptr[0] = uint8_t(i);
+                  ptr[op.size - 1] = uint8_t(op.id);
+                }
+                resources.emplace(op.id, std::move(res));
+              }
+              else {
+                auto iter_res = resources.find(op.id);
+                if (validate) {
+                  auto ptr = allocator.map(iter_res->second);
+                  if (ptr[0] != uint8_t(i) || ptr[op.size - 1] != uint8_t(op.id)) {
+                    throw std::runtime_error{"resource " + std::to_string(op.id) + " of thread " + std::to_string(i) + " was overwritten"};
+                  }
+                }
+                resources.erase(iter_res);
+              }
+            }
+          }
+          catch (std::exception const& e) {
+            errors[i] = e.what();
+          }
+        });
+      }
+      for (auto& thread : threads) {
+        thread.join();
+      }
+      time = timer.durationEnd();
+      for (auto const& error : errors) {
+        if (!error.empty()) throw std::runtime_error{error};
+      }
+      if (allocator.bytesUsed() != 0) {
+        throw std::runtime_error{"concurrent allocator still reports used memory"};
+      }
+      std::cout << "  " << (chunk_bytes > 0 ? "per-thread chunks" : "shared lock") << std::endl;
+      std::cout << "    time: " << time << " milliseconds" << std::endl;
+      std::cout << "    contended locks: " << allocator.numContended() << " of " << allocator.numLocks() << std::endl;
+      std::cout << "    waiting: " << allocator.timeContended() << " milliseconds" << std::endl;
+    }
+    if (backend->numBlocks() != 0) {
+      throw std::runtime_error{"concurrent allocator leaked memory blocks"};
+    }
+  }
+}
+
+int main(int argc, char* argv[]) {
+  cmdline::parser cmd_parse{};
+  cmd_parse.add<unsigned>("operations", 'n', "number of allocations per trace", false, 10000);
+  cmd_parse.add<unsigned>("seed", 's', "random seed", false, 0);
+  cmd_parse.add<unsigned>("fuzz", 'f', "validate allocators with given number of random traces", false, 0);
+  cmd_parse.add<unsigned>("threads", 't', "replay traces concurrently with given number of threads", false, 0);
+  cmd_parse.parse_check(argc, argv);
+
+  auto count = size_t(cmd_parse.get<unsigned>("operations"));
+  auto seed = cmd_parse.get<unsigned>("seed");
+
+  try {
+    if (cmd_parse.get<unsigned>("fuzz") > 0) {
+      for (unsigned i = 0; i < cmd_parse.get<unsigned>("fuzz"); ++i) {
+        std::cout << "fuzzing with seed " << seed + i << std::endl;
+        std::mt19937 rng{seed + i};
+        fuzz(rng, count);
+        if (cmd_parse.get<unsigned>("threads") > 0) {
+          contention(rng, count, cmd_parse.get<unsigned>("threads"), true);
+        }
+      }
+    }
+    else if (cmd_parse.get<unsigned>("threads") > 0) {
+      std::mt19937 rng{seed};
+      contention(rng, count, cmd_parse.get<unsigned>("threads"), false);
+    }
+    else {
+      std::mt19937 rng{seed};
+      benchmark("texture loading", trace_textures(rng, count));
+      benchmark("geometry churn", trace_geometry(rng, count));
+      benchmark("lod slots", trace_lod(rng, count));
+    }
+  }
+  catch (std::exception const& e) {
+    std::cerr << "error: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
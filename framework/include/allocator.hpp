@@ -1,15 +1,26 @@
 #ifndef ALLOCATOR_HPP
 #define ALLOCATOR_HPP
 
+#include <vulkan/vulkan.hpp>
+
 #include <cstdint>
+#include <memory>
 
 class Device;
 class MemoryResource;
+class MemoryBackend;
+
+// round offset up to next multiple of alignment
+inline vk::DeviceSize align_offset(vk::DeviceSize offset, vk::DeviceSize alignment) {
+  if (alignment == 0) return offset;
+  return ((offset + alignment - 1) / alignment) * alignment;
+}
 
 class Allocator {
- public: 
+ public:
   Allocator();
   Allocator(Device const& device, uint32_t type_index);
+  Allocator(std::shared_ptr<MemoryBackend> const& backend, uint32_t type_index);
   virtual ~Allocator() {};
   void swap(Allocator& rhs);
 
@@ -18,8 +29,24 @@ class Allocator {
   virtual void free(MemoryResource& resource) = 0;
   // get ptr to virtual address
   virtual uint8_t* map(MemoryResource& resource) = 0;
+
+  // statistics
+  virtual std::size_t numBlocks() const = 0;
+  // memory requested from backend
+  virtual vk::DeviceSize bytesReserved() const = 0;
+  // memory occupied by resources, without alignment padding
+  virtual vk::DeviceSize bytesUsed() const = 0;
+  virtual vk::DeviceSize largestFreeRange() const = 0;
+  // memory lost to size rounding, neither used nor free
+  virtual vk::DeviceSize bytesOverhead() const { return 0; }
+  // 0 if free memory is contiguous, close to 1 if scattered
+  double fragmentation() const;
+
+  uint32_t typeIndex() const;
+
  protected:
   Device const* m_device;
+  std::shared_ptr<MemoryBackend> m_backend;
   uint32_t m_type_index;
 };
 
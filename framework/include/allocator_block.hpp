@@ -3,7 +3,7 @@
 
 #include "allocator.hpp"
 
-#include "wrap/memory.hpp"
+#include "wrap/memory_resource.hpp"
 
 #include <vulkan/vulkan.hpp>
 
@@ -16,21 +16,25 @@ class MemoryResource;
 
 class BlockAllocator : public Allocator {
   struct range_t {
-    range_t(uint32_t b, vk::DeviceSize o, vk::DeviceSize s)
+    range_t(uint32_t b, vk::DeviceSize o, vk::DeviceSize s, vk::DeviceSize a = 1)
      :block{b}
      ,offset{o}
      ,size{s}
+     ,alignment{a}
     {}
 
     uint32_t block;
     vk::DeviceSize offset;
     vk::DeviceSize size;
+    // required by resource, for relocation
+    vk::DeviceSize alignment;
   }; 
 
   using iterator_t = std::list<range_t>::iterator;
  public: 
   BlockAllocator();
 	BlockAllocator(Device const& device, uint32_t type_index, uint32_t block_bytes);
+  BlockAllocator(std::shared_ptr<MemoryBackend> const& backend, uint32_t type_index, uint32_t block_bytes);
   BlockAllocator(BlockAllocator && rhs);
   BlockAllocator(BlockAllocator const&) = delete;
   ~BlockAllocator();
@@ -46,16 +50,34 @@ class BlockAllocator : public Allocator {
 
   virtual uint8_t* map(MemoryResource& resource) override;
 
+  virtual std::size_t numBlocks() const override;
+  virtual vk::DeviceSize bytesReserved() const override;
+  virtual vk::DeviceSize bytesUsed() const override;
+  virtual vk::DeviceSize largestFreeRange() const override;
+
+  // defragmentation
+  // resources of least occupied block, empty if they do not fit into the other blocks
+  std::vector<res_handle_t> relocationCandidates() const;
+  // allocates only in existing blocks other than the one of previous, returns false if no range fits
+  bool allocateElsewhere(MemoryResource& resource, MemoryResource const& previous);
+  // returns freed bytes
+  vk::DeviceSize releaseEmptyBlocks();
+
  private:
-  void addBlock();
+  // returns index of block, reuses released slots
+  uint32_t addBlock();
 
-  iterator_t findMatchingRange(vk::MemoryRequirements const& requirements);
+  iterator_t findMatchingRange(std::list<range_t>& ranges, vk::MemoryRequirements const& requirements, uint32_t block_excluded) const;
+  // remove allocated part from free range
+  void claimRange(std::list<range_t>& ranges, iterator_t iter_range, vk::DeviceSize offset, vk::DeviceSize size) const;
 
   void addResource(MemoryResource& resource, range_t const& range);
 
   uint32_t m_block_bytes;
+  vk::DeviceSize m_bytes_used;
 
-  std::list<Memory> m_blocks;
+  // released blocks are null
+  std::vector<vk::DeviceMemory> m_blocks;
   // list of per-block free ranges with offset and size
   std::list<range_t> m_free_ranges;
   std::map<res_handle_t, range_t> m_used_ranges;
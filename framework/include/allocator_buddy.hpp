@@ -0,0 +1,88 @@
+#ifndef BUDDY_ALLOCATOR_HPP
+#define BUDDY_ALLOCATOR_HPP
+
+#include "allocator.hpp"
+
+#include "wrap/memory_resource.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+#include <vector>
+#include <map>
+#include <set>
+
+class Device;
+class MemoryResource;
+
+// power-of-two buddy allocator, resources larger than half a block get dedicated memory
+class BuddyAllocator : public Allocator {
+  struct range_t {
+    range_t(uint32_t b, vk::DeviceSize o, uint32_t ord, vk::DeviceSize s)
+     :block{b}
+     ,offset{o}
+     ,order{ord}
+     ,size{s}
+    {}
+
+    uint32_t block;
+    vk::DeviceSize offset;
+    uint32_t order;
+    // requested size
+    vk::DeviceSize size;
+  };
+
+  struct dedicated_t {
+    vk::DeviceMemory memory;
+    vk::DeviceSize size;
+    uint8_t* ptr;
+  };
+
+ public:
+  BuddyAllocator();
+  // block size is rounded up to power of two
+  BuddyAllocator(Device const& device, uint32_t type_index, vk::DeviceSize block_bytes, vk::DeviceSize min_bytes = 4096);
+  BuddyAllocator(std::shared_ptr<MemoryBackend> const& backend, uint32_t type_index, vk::DeviceSize block_bytes, vk::DeviceSize min_bytes = 4096);
+  BuddyAllocator(BuddyAllocator && rhs);
+  BuddyAllocator(BuddyAllocator const&) = delete;
+  ~BuddyAllocator();
+
+  BuddyAllocator& operator=(BuddyAllocator&& rhs);
+  BuddyAllocator& operator=(BuddyAllocator const&) = delete;
+
+  void swap(BuddyAllocator& rhs);
+
+  virtual void allocate(MemoryResource& resource) override;
+
+  virtual void free(MemoryResource& resource) override;
+
+  virtual uint8_t* map(MemoryResource& resource) override;
+
+  virtual std::size_t numBlocks() const override;
+  virtual vk::DeviceSize bytesReserved() const override;
+  virtual vk::DeviceSize bytesUsed() const override;
+  virtual vk::DeviceSize largestFreeRange() const override;
+  // memory lost to rounding up to power of two sizes
+  virtual vk::DeviceSize bytesOverhead() const override;
+  std::size_t numDedicated() const;
+
+ private:
+  void addBlock();
+  void allocateDedicated(MemoryResource& resource);
+  // returns false if no block has a free range of at least given order
+  bool findRange(uint32_t order, uint32_t& block, vk::DeviceSize& offset);
+
+  uint32_t m_order_min;
+  uint32_t m_order_max;
+  vk::DeviceSize m_bytes_used;
+  vk::DeviceSize m_bytes_allocated;
+
+  std::vector<vk::DeviceMemory> m_blocks;
+  // per block, per order free offsets
+  std::vector<std::vector<std::set<vk::DeviceSize>>> m_free_ranges;
+  std::map<res_handle_t, range_t> m_used_ranges;
+  std::map<res_handle_t, dedicated_t> m_dedicated;
+  // for mapping
+  std::vector<uint8_t*> m_ptrs;
+};
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef CONCURRENT_ALLOCATOR_HPP
+#define CONCURRENT_ALLOCATOR_HPP
+
+#include "allocator.hpp"
+
+#include "wrap/memory_resource.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// thread-safe front-end, small resources are suballocated from per-thread chunks of the shared allocator
+class ConcurrentAllocator : public Allocator {
+  // memory range of a chunk, has no vulkan object and is freed with the chunk
+  class chunk_resource_t : public MemoryResource {
+   public:
+    chunk_resource_t(vk::MemoryRequirements const& requirements);
+    chunk_resource_t(chunk_resource_t const&) = delete;
+    ~chunk_resource_t();
+
+    chunk_resource_t& operator=(chunk_resource_t const&) = delete;
+
+    void bindTo(vk::DeviceMemory const& memory, vk::DeviceSize const& offset) override;
+    vk::MemoryRequirements requirements() const override;
+    res_handle_t handle() const override;
+
+    vk::DeviceMemory const& memory() const;
+    vk::DeviceSize offset() const;
+
+   private:
+    vk::MemoryRequirements m_requirements;
+    // unique key for the shared allocator
+    VkBuffer m_handle;
+    vk::DeviceMemory m_memory;
+    vk::DeviceSize m_offset;
+  };
+
+  // range of the shared allocator owned by one thread
+  struct chunk_t {
+    chunk_t(vk::MemoryRequirements const& requirements);
+
+    void addRange(vk::DeviceSize offset, vk::DeviceSize size);
+    void removeRange(std::map<vk::DeviceSize, vk::DeviceSize>::iterator iter_range);
+
+    chunk_resource_t resource;
+    uint8_t* ptr;
+    // offset to size, relative to chunk start
+    std::map<vk::DeviceSize, vk::DeviceSize> free_ranges;
+    // size to offset, for best fit search
+    std::multimap<vk::DeviceSize, vk::DeviceSize> free_sizes;
+    vk::DeviceSize bytes_used;
+  };
+
+  struct range_t {
+    chunk_t* chunk;
+    vk::DeviceSize offset;
+    vk::DeviceSize size;
+  };
+
+  struct cache_t {
+    std::mutex mutex;
+    // list for stable chunk addresses
+    std::list<chunk_t> chunks;
+    std::map<res_handle_t, range_t> used_ranges;
+  };
+
+ public:
+  ConcurrentAllocator();
+  // resources larger than a quarter chunk are allocated from the shared allocator directly
+  ConcurrentAllocator(std::unique_ptr<Allocator>&& allocator, vk::DeviceSize chunk_bytes);
+  ConcurrentAllocator(ConcurrentAllocator && rhs);
+  ConcurrentAllocator(ConcurrentAllocator const&) = delete;
+  ~ConcurrentAllocator();
+
+  ConcurrentAllocator& operator=(ConcurrentAllocator&& rhs);
+  ConcurrentAllocator& operator=(ConcurrentAllocator const&) = delete;
+  // not thread-safe
+  void swap(ConcurrentAllocator& rhs);
+
+  virtual void allocate(MemoryResource& resource) override;
+
+  virtual void free(MemoryResource& resource) override;
+
+  virtual uint8_t* map(MemoryResource& resource) override;
+
+  virtual std::size_t numBlocks() const override;
+  virtual vk::DeviceSize bytesReserved() const override;
+  virtual vk::DeviceSize bytesUsed() const override;
+  virtual vk::DeviceSize largestFreeRange() const override;
+  virtual vk::DeviceSize bytesOverhead() const override;
+
+  std::size_t numThreads() const;
+  // acquisitions of the shared allocator lock
+  uint64_t numLocks() const;
+  // acquisitions of any lock that had to wait
+  uint64_t numContended() const;
+  // milliseconds spent waiting for locks
+  double timeContended() const;
+
+ private:
+  std::unique_lock<std::mutex> lock(std::mutex& mutex) const;
+  bool isShared(vk::MemoryRequirements const& requirements) const;
+  cache_t& threadCache();
+  // returns false if chunk has no matching range
+  bool claimRange(chunk_t& chunk, vk::MemoryRequirements const& requirements, vk::DeviceSize& offset);
+  void releaseRange(cache_t& cache, std::map<res_handle_t, range_t>::iterator iter_range);
+
+  uint64_t m_id;
+  std::unique_ptr<Allocator> m_allocator;
+  vk::DeviceSize m_chunk_bytes;
+  std::map<std::thread::id, std::unique_ptr<cache_t>> m_caches;
+  mutable std::mutex m_mutex_shared;
+  mutable std::mutex m_mutex_caches;
+  std::atomic<vk::DeviceSize> m_bytes_used;
+  mutable std::atomic<uint64_t> m_num_locks;
+  mutable std::atomic<uint64_t> m_num_contended;
+  mutable std::atomic<uint64_t> m_ns_contended;
+};
+
+#endif
@@ -3,7 +3,7 @@
 
 #include "allocator.hpp"
 
-#include "wrap/memory.hpp"
+#include "wrap/memory_resource.hpp"
 
 #include <vulkan/vulkan.hpp>
 
@@ -28,6 +28,7 @@ class StaticAllocator : public Allocator {
  public: 
   StaticAllocator();
 	StaticAllocator(Device const& device, uint32_t type_index, size_t block_bytes);
+  StaticAllocator(std::shared_ptr<MemoryBackend> const& backend, uint32_t type_index, size_t block_bytes);
   StaticAllocator(StaticAllocator && rhs);
   StaticAllocator(StaticAllocator const&) = delete;
   ~StaticAllocator();
@@ -43,7 +44,12 @@ class StaticAllocator : public Allocator {
 
   virtual uint8_t* map(MemoryResource& resource) override;
 
-  Memory const& mem() const {
+  virtual std::size_t numBlocks() const override;
+  virtual vk::DeviceSize bytesReserved() const override;
+  virtual vk::DeviceSize bytesUsed() const override;
+  virtual vk::DeviceSize largestFreeRange() const override;
+
+  vk::DeviceMemory const& mem() const {
     return m_block;
   }
  private:
@@ -55,8 +61,9 @@ class StaticAllocator : public Allocator {
   void addResource(MemoryResource& resource, range_t const& range);
 
   size_t m_block_bytes;
+  vk::DeviceSize m_bytes_used;
 
-  Memory m_block;
+  vk::DeviceMemory m_block;
   // list of per-block free ranges with offset and size
   std::list<range_t> m_free_ranges;
   std::map<res_handle_t, range_t> m_used_ranges;
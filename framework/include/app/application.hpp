@@ -13,12 +13,17 @@
 #include "wrap/descriptor_pool.hpp"
 #include "wrap/descriptor_set.hpp"
 #include "wrap/command_pool.hpp"
+#include "wrap/timeline_semaphore.hpp"
 
 #include "allocator_block.hpp"
 #include "camera.hpp"
 #include "transferrer.hpp"
 #include "frame_resource.hpp"
+#include "frame_handles.hpp"
+#include "job_system.hpp"
+#include "frame_pacer.hpp"
 #include "statistics.hpp"
+#include "memory_telemetry.hpp"
 
 #include <map>
 #include <mutex>
@@ -36,8 +41,8 @@ class Application {
   // allocate and initialize objects
   Application(std::string const& resource_path, Device& device, uint32_t num_frames, cmdline::parser const& cmd_parse);
 
-  // free resources
-  virtual ~Application(){};
+  // free resources, print memory statistics
+  virtual ~Application();
 
   // react to key input
   inline virtual void keyCallback(int key, int scancode, int action, int mods) {};
@@ -55,12 +60,21 @@ class Application {
   virtual void emptyDrawQueue() = 0;
   // default parser without arguments
   static cmdline::parser getParser();
+  // frame resources given on command line, default if not set
+  static uint32_t numFrames(cmdline::parser const& cmd_parse, uint32_t num_default);
 
   virtual bool shouldClose() const = 0;
 
  protected:
   void recreatePipeline();
   void submitDraw(FrameResource& res);
+  // prints percentiles since the last report and starts a new period
+  void report();
+  // time from start of recording until the frame is presented
+  void recordLatency(Timer& timer_latency);
+  // stops timer of a wait on the recording thread, blocked time is slack for frame pacing
+  void stopWait(std::string const& name);
+  void stopWait(Handle const& handle);
   // initialisation methods
   virtual void createMemoryPools();
   virtual void createCommandPools();
@@ -73,7 +87,11 @@ class Application {
   // overwritten by abstract apps
   virtual void onFrameBegin() {};
   virtual void onFrameEnd() {};
+  // called after every frame, overwritten by apps with their own allocators
+  virtual void recordMemoryStatistics();
   virtual SubmitInfo createDrawSubmitInfo(FrameResource const& res) const;
+  // submitted right before the draw buffer, for work on other queues the draw waits on
+  virtual void submitCompute(FrameResource& res) {};
   virtual void render() = 0;
   virtual glm::u32vec2 queryResolution() const = 0;
   // update methods
@@ -94,6 +112,8 @@ class Application {
   virtual void shutDown() = 0;
   // MUST be called by high-level app at end of constructor
   void createRenderResources();
+  // move resources out of sparsely used memory blocks and release empty ones, returns moved bytes
+  vk::DeviceSize defragment(vk::DeviceSize budget);
 
   // make immutable for children classes
   std::string const& resourcePath() const;
@@ -112,17 +132,32 @@ class Application {
   std::map<std::string, Buffer> m_buffers;
   std::map<std::string, BufferView> m_buffer_views;
   std::map<std::string, CommandPool> m_command_pools;
+  // per queue, replace fences of frame resources if enabled
+  std::map<std::string, TimelineSemaphore> m_timelines;
   // below command pools so that it is destroyed before
   Transferrer m_transferrer;
 
   Statistics m_statistics;
+  // averagers of allocators, registered once
+  MemoryTelemetry m_telemetry;
+  // disabled unless the window app enables it
+  FramePacer m_pacer;
   // workaround so multithreaded apps can be run with single thread
   virtual void recordTransferBuffer(FrameResource& res) {};
+  // family of the queue the transfer buffer is submitted to
+  virtual uint32_t transferQueueFamily() const;
   std::vector<FrameResource> m_frame_resources;
+  // last so that workers stop before resources are destroyed
+  JobSystem m_jobs;
 
  private:
   std::string m_resource_path;
   glm::u32vec2 m_resolution;
+  // bytes relocated per frame
+  vk::DeviceSize m_defrag_budget;
+  // in ms, 0 - disabled
+  double m_report_interval;
+  Timer m_timer_report;
   // these two classes can change the resolution
   friend class ApplicationWorker;
   friend class ApplicationWin;
@@ -13,7 +13,7 @@ cmdline::parser ApplicationSingle<T>::getParser() {
 
 template<typename T>
 ApplicationSingle<T>::ApplicationSingle(std::string const& resource_path, Device& device, Surface const& surf, cmdline::parser const& cmd_parse, uint32_t num_frames) 
- :T{resource_path, device, surf, num_frames + 1, cmd_parse}
+ :T{resource_path, device, surf, T::numFrames(cmd_parse, num_frames) + 1, cmd_parse}
 {
   this->m_statistics.addTimer("gpu_draw");
   this->m_statistics.addTimer("record");
@@ -39,26 +39,28 @@ FrameResource ApplicationSingle<T>::createFrameResource() {
   auto res = T::createFrameResource();
   res.setCommandBuffer("transfer", std::move(this->m_command_pools.at("graphics").createBuffer(vk::CommandBufferLevel::ePrimary)));
   // record once to prevent validation error when not used 
-  res.commandBuffer("transfer")->begin(vk::CommandBufferBeginInfo{});
-  res.commandBuffer("transfer")->end();
+  res.commandBuffer(frame_handles::transfer)->begin(vk::CommandBufferBeginInfo{});
+  res.commandBuffer(frame_handles::transfer)->end();
   return res;
 }
 
 template<typename T>
 void ApplicationSingle<T>::render() { 
+  this->m_frame_resources.front().timer_latency.start();
   this->acquireImage(this->m_frame_resources.front());
-  this->m_statistics.start("record");
+  this->m_statistics.start(frame_handles::record);
   // make sure no command buffer is in use
-  this->m_statistics.start("fence_draw");
-  this->m_frame_resources.front().fence("draw").wait();
-  this->m_statistics.stop("fence_draw");
+  this->m_statistics.start(frame_handles::fence_draw);
+  this->m_frame_resources.front().wait(frame_handles::draw);
+  this->stopWait(frame_handles::fence_draw);
+  this->m_frame_resources.front().transient_buffer.reset();
   static uint64_t frame = 0;
   ++frame;
   this->recordTransferBuffer(this->m_frame_resources.front());
   this->recordDrawBuffer(this->m_frame_resources.front());
   
   this->submitDraw(this->m_frame_resources.front());
-  this->m_statistics.stop("record");
+  this->m_statistics.stop(frame_handles::record);
 
   this->presentFrame(this->m_frame_resources.front());
 }
@@ -66,14 +68,14 @@ void ApplicationSingle<T>::render() {
 template<typename T>
 SubmitInfo ApplicationSingle<T>::createDrawSubmitInfo(FrameResource const& res) const {  
   SubmitInfo info = T::createDrawSubmitInfo(res);
-  info.addCommandBuffer(res.command_buffers.at("transfer").get());
+  info.addCommandBuffer(res.command_buffers.at(frame_handles::transfer).get());
   return info;
 }
 
 template<typename T>
 void ApplicationSingle<T>::emptyDrawQueue() {
   // MUST wait after every present or everything freezes
-  this->m_device.getQueue("present").waitIdle();
+  this->m_device.getQueue(frame_handles::present).waitIdle();
   // wait until draw resources are avaible before recallocation
   for (auto const& res : this->m_frame_resources) {
     res.waitFences();
@@ -2,7 +2,7 @@
 #define APPLICATION_THREADED_HPP
 
 #include "app/application_single.hpp"
-#include "semaphore.hpp"
+#include "ring_queue.hpp"
 
 #include <vector>
 #include <atomic>
@@ -46,14 +46,12 @@ class ApplicationThreaded : public ApplicationSingle<T> {
   virtual void render() override;
   virtual void drawLoop();
 
-  std::mutex m_mutex_draw_queue;
-  std::mutex m_mutex_present_queue;
-
-  std::queue<uint32_t> m_queue_draw_frames;
+  // only accessed by recording thread
   std::queue<uint32_t> m_queue_record_frames;
-  std::queue<uint32_t> m_queue_present_frames;
-  Semaphore m_semaphore_draw;
-  Semaphore m_semaphore_present;
+  // filled by recording or transfer thread
+  RingQueue<uint32_t> m_queue_draw_frames;
+  // filled by drawing thread
+  RingQueue<uint32_t> m_queue_present_frames;
 
   std::atomic<bool> m_should_draw;
   std::thread m_thread_draw;
@@ -10,8 +10,9 @@ cmdline::parser ApplicationThreaded<T>::getParser() {
 template<typename T>
 ApplicationThreaded<T>::ApplicationThreaded(std::string const& resource_path, Device& device, Surface const& surf, cmdline::parser const& cmd_parse, uint32_t num_frames) 
  :ApplicationSingle<T>{resource_path, device, surf, cmd_parse, num_frames + 1}
- ,m_semaphore_draw{0}
- ,m_semaphore_present{0}
+ ,m_queue_record_frames{}
+ ,m_queue_draw_frames{this->m_frame_resources.size()}
+ ,m_queue_present_frames{this->m_frame_resources.size()}
  ,m_should_draw{true}
 {
   std::cout << "using drawing thread" << std::endl;
@@ -48,7 +49,7 @@ void ApplicationThreaded<T>::shutDown() {
   emptyDrawQueue();
   // shut down drawing thread
   m_should_draw = false;
-  m_semaphore_draw.shutDown();
+  m_queue_draw_frames.close();
   m_thread_draw.join();
   for (auto const& res : this->m_frame_resources) {
     // reset command buffers because the draw indirect buffer counts as reference to memory
@@ -61,10 +62,10 @@ void ApplicationThreaded<T>::shutDown() {
 
 template<typename T>
 void ApplicationThreaded<T>::present() {
-  this->m_statistics.start("sema_present");
+  this->m_statistics.start(frame_handles::sema_present);
   // only calculate new frame if previous one was rendered
-  m_semaphore_present.wait();
-  this->m_statistics.stop("sema_present");
+  m_queue_present_frames.wait();
+  this->stopWait(frame_handles::sema_present);
   // present next frame
   auto& resource_present = pullForPresent();
   this->presentFrame(resource_present);
@@ -73,15 +74,17 @@ void ApplicationThreaded<T>::present() {
 
 template<typename T>
 void ApplicationThreaded<T>::render() {
-  this->m_statistics.start("record");
+  this->m_statistics.start(frame_handles::record);
   static uint64_t frame = 0;
   ++frame;
   // get next resource to record
   auto& resource_record = pullForRecord();
+  resource_record.timer_latency.start();
   // make sure no command buffer is in use
-  this->m_statistics.start("fence_draw");
-  resource_record.fence("draw").wait();
-  this->m_statistics.stop("fence_draw");
+  this->m_statistics.start(frame_handles::fence_draw);
+  resource_record.wait(frame_handles::draw);
+  this->stopWait(frame_handles::fence_draw);
+  resource_record.transient_buffer.reset();
   // transfer doesnt need to know about image
   this->recordTransferBuffer(resource_record);
   // draw needs image
@@ -89,14 +92,14 @@ void ApplicationThreaded<T>::render() {
   this->recordDrawBuffer(resource_record);
   // add newly recorded frame for drawing
   pushForDraw(resource_record);
-  this->m_statistics.stop("record");
+  this->m_statistics.stop(frame_handles::record);
   
   present();
 }
 
 template<typename T>
 void ApplicationThreaded<T>::draw() {
-  this->m_statistics.start("frame_draw");
+  this->m_statistics.start(frame_handles::frame_draw);
   static std::uint64_t frame = 0;
   ++frame;
   // get next resource to draw
@@ -105,25 +108,17 @@ void ApplicationThreaded<T>::draw() {
   // do not wait here for finishing anymore
   // make frame avaible for rerecording
   pushForPresent(resource_draw);
-  this->m_statistics.stop("frame_draw");
+  this->m_statistics.stop(frame_handles::frame_draw);
 }
 
 template<typename T>
 void ApplicationThreaded<T>::pushForDraw(FrameResource& resource) {
-  {
-    std::lock_guard<std::mutex> queue_lock{m_mutex_draw_queue};
-    m_queue_draw_frames.push(resource.index);
-  }
-  m_semaphore_draw.signal();
+  m_queue_draw_frames.push(resource.index);
 }
 
 template<typename T>
 void ApplicationThreaded<T>::pushForPresent(FrameResource& resource) {
-  {
-    std::lock_guard<std::mutex> queue_lock{m_mutex_present_queue};
-    m_queue_present_frames.push(resource.index);
-  }
-  m_semaphore_present.signal();
+  m_queue_present_frames.push(resource.index);
 }
 
 template<typename T>
@@ -139,39 +134,25 @@ FrameResource& ApplicationThreaded<T>::pullForRecord() {
 
 template<typename T>
 FrameResource& ApplicationThreaded<T>::pullForDraw() {
-  uint32_t frame_draw = 0;
-  {
-    std::lock_guard<std::mutex> queue_lock{m_mutex_draw_queue};
-    assert(!m_queue_draw_frames.empty());
-    // get frame to draw
-    frame_draw = m_queue_draw_frames.front();
-    m_queue_draw_frames.pop();
-  }
-  return this->m_frame_resources[frame_draw];
+  // get frame to draw
+  return this->m_frame_resources[m_queue_draw_frames.pop()];
 }
 
 template<typename T>
 FrameResource& ApplicationThreaded<T>::pullForPresent() {
-  uint32_t frame_present = 0;
-  {
-    std::lock_guard<std::mutex> queue_lock{m_mutex_present_queue};
-    assert(!m_queue_present_frames.empty());
-    // get next frame to present
-    frame_present = m_queue_present_frames.front();
-    m_queue_present_frames.pop();
-  }
-  return this->m_frame_resources[frame_present];
+  // get next frame to present
+  return this->m_frame_resources[m_queue_present_frames.pop()];
 }
 
 template<typename T>
 void ApplicationThreaded<T>::drawLoop() {
   // wait for first frame
-  m_semaphore_draw.wait();
+  m_queue_draw_frames.wait();
   while (m_should_draw) {
     draw();
-    this->m_statistics.start("sema_draw");
-    m_semaphore_draw.wait();
-    this->m_statistics.stop("sema_draw");
+    this->m_statistics.start(frame_handles::sema_draw);
+    m_queue_draw_frames.wait();
+    this->m_statistics.stop(frame_handles::sema_draw);
   }
 }
 
@@ -179,21 +160,11 @@ template<typename T>
 void ApplicationThreaded<T>::emptyDrawQueue() {
   // check if all frames are ready for recording
   while(m_queue_record_frames.size() < this->m_frame_resources.size()) {
-    // check if frames can be presented
-    size_t num_present = 0;
-    {
-      std::lock_guard<std::mutex> queue_lock{m_mutex_present_queue};
-      num_present = m_queue_present_frames.size();
-    }
-    // invalidate remaining frames
-    while (num_present > 0) {
-      m_semaphore_present.wait(); 
-      m_queue_record_frames.push(pullForPresent().index);
-      --num_present;
-    }
+    // invalidate remaining frames, waits until they are drawn
+    m_queue_record_frames.push(pullForPresent().index);
   }
   // MUST wait after every present or everything freezes
-  this->m_device.getQueue("present").waitIdle();
+  this->m_device.getQueue(frame_handles::present).waitIdle();
   // wait until draw resources are avaible before recallocation
   for (auto const& res : this->m_frame_resources) {
     res.waitFences();
@@ -19,6 +19,7 @@ class ApplicationThreadedTransfer : public ApplicationThreaded<T> {
   void shutDown() override;
  
   virtual SubmitInfo createDrawSubmitInfo(FrameResource const& res) const override;
+  uint32_t transferQueueFamily() const override;
 
  private:
   void render() override;
@@ -31,9 +32,8 @@ class ApplicationThreadedTransfer : public ApplicationThreaded<T> {
   void transfer();
   void transferLoop();
   
-  std::mutex m_mutex_transfer_queue;
-  std::queue<uint32_t> m_queue_transfer_frames;
-  Semaphore m_semaphore_transfer;
+  // filled by recording thread
+  RingQueue<uint32_t> m_queue_transfer_frames;
 
   std::atomic<bool> m_should_transfer;
   std::thread m_thread_transfer;
@@ -8,7 +8,7 @@ cmdline::parser ApplicationThreadedTransfer<T>::getParser() {
 template<typename T> 
 ApplicationThreadedTransfer<T>::ApplicationThreadedTransfer(std::string const& resource_path, Device& device, Surface const& surf, cmdline::parser const& cmd_parse) 
  :ApplicationThreaded<T>{resource_path, device, surf, cmd_parse, 3}
- ,m_semaphore_transfer{0}
+ ,m_queue_transfer_frames{this->m_frame_resources.size()}
  ,m_should_transfer{true}
 {
   std::cout << "using transfer thread" << std::endl;
@@ -38,9 +38,9 @@ template<typename T>
 void ApplicationThreadedTransfer<T>::shutDown() {
   // shut down transfer thread
   m_should_transfer = false;
-  m_semaphore_transfer.shutDown();
+  m_queue_transfer_frames.close();
   m_thread_transfer.join();
-  this->m_device.getQueue("transfer").waitIdle();
+  this->m_device.getQueue(frame_handles::transfer).waitIdle();
   // shut down drawing thread
  ApplicationThreaded<T>::shutDown();
 }
@@ -52,42 +52,48 @@ FrameResource ApplicationThreadedTransfer<T>::createFrameResource() {
   res.setCommandBuffer("transfer", this->m_command_pools.at("transfer").createBuffer(vk::CommandBufferLevel::ePrimary));  
   res.addSemaphore("transfer");
   res.addFence("transfer");
+  if (!this->m_timelines.empty()) {
+    res.addTimeline("transfer", this->m_timelines.at("transfer"));
+  }
   // record once to prevent validation error when not used 
-  res.commandBuffer("transfer")->begin(vk::CommandBufferBeginInfo{});
-  res.commandBuffer("transfer")->end();
+  res.commandBuffer(frame_handles::transfer)->begin(vk::CommandBufferBeginInfo{});
+  res.commandBuffer(frame_handles::transfer)->end();
   return res;
 }
 
 template<typename T> 
 void ApplicationThreadedTransfer<T>::render() {
-  this->m_statistics.start("record");
+  this->m_statistics.start(frame_handles::record);
   static uint64_t frame = 0;
   ++frame;
   // get next resource to record
   auto& resource_record = this->pullForRecord();
+  resource_record.timer_latency.start();
   // wait for previous transfer completion
-  this->m_statistics.start("fence_transfer");
-  resource_record.fence("transfer").wait();
-  this->m_statistics.stop("fence_transfer");
+  this->m_statistics.start(frame_handles::fence_transfer);
+  resource_record.wait(frame_handles::transfer);
+  this->stopWait(frame_handles::fence_transfer);
   // transfer doesnt need to know about image
   this->recordTransferBuffer(resource_record);
   // draw needs image
   this->acquireImage(resource_record);
   // wait for previous draw completion
-  this->m_statistics.start("fence_draw");
-  resource_record.fence("draw").wait();
-  this->m_statistics.stop("fence_draw");
+  this->m_statistics.start(frame_handles::fence_draw);
+  resource_record.wait(frame_handles::draw);
+  this->stopWait(frame_handles::fence_draw);
+  // transient data can only be written after this point
+  resource_record.transient_buffer.reset();
   this->recordDrawBuffer(resource_record);
   // add newly recorded frame for drawing
   pushForTransfer(resource_record);
-  this->m_statistics.stop("record");
+  this->m_statistics.stop(frame_handles::record);
 
   this->present();
 }
 
 template<typename T> 
 void ApplicationThreadedTransfer<T>::transfer() {
-  this->m_statistics.start("frame_transfer");
+  this->m_statistics.start(frame_handles::frame_transfer);
   static std::uint64_t frame = 0;
   ++frame;
   // get frame to transfer
@@ -96,57 +102,66 @@ void ApplicationThreadedTransfer<T>::transfer() {
   submitTransfer(resource_transfer);
   // make frame avaible for rerecording
   this->pushForDraw(resource_transfer);
-  this->m_statistics.stop("frame_transfer");
+  this->m_statistics.stop(frame_handles::frame_transfer);
 }
 
 template<typename T> 
 void ApplicationThreadedTransfer<T>::pushForTransfer(FrameResource& resource) {
-  {
-    std::lock_guard<std::mutex> queue_lock{m_mutex_transfer_queue};
-    m_queue_transfer_frames.push(resource.index);
-  }
-  m_semaphore_transfer.signal();
+  m_queue_transfer_frames.push(resource.index);
 }
 
 template<typename T> 
 FrameResource& ApplicationThreadedTransfer<T>::pullForTransfer() {
-  uint32_t frame_transfer = 0;
-  {
-    std::lock_guard<std::mutex> queue_lock{m_mutex_transfer_queue};
-    assert(!m_queue_transfer_frames.empty());
-    // get frame to transfer
-    frame_transfer = m_queue_transfer_frames.front();
-    m_queue_transfer_frames.pop();
-  }
-  return this->m_frame_resources[frame_transfer];
+  // get frame to transfer
+  return this->m_frame_resources[m_queue_transfer_frames.pop()];
 }
 
 template<typename T> 
 void ApplicationThreadedTransfer<T>::submitTransfer(FrameResource& res) {
   SubmitInfo info{};
-  info.addCommandBuffer(res.command_buffers.at("transfer").get());
-  info.addSignalSemaphore(res.semaphore("transfer"));
-
-  res.fences.at("transfer").reset();
-  this->m_device.getQueue("transfer").submit({info}, res.fences.at("transfer"));
+  info.addCommandBuffer(res.command_buffers.at(frame_handles::transfer).get());
+  if (res.hasTimeline(frame_handles::transfer)) {
+    // draw waits for the same value
+    auto& point = res.timeline(frame_handles::transfer);
+    point.value = point.semaphore->next();
+    info.addSignalSemaphore(point.semaphore->get(), point.value);
+    this->m_device.getQueue(frame_handles::transfer).submit({info}, nullptr);
+  }
+  else {
+    info.addSignalSemaphore(res.semaphore(frame_handles::transfer));
+    res.fences.at(frame_handles::transfer).reset();
+    this->m_device.getQueue(frame_handles::transfer).submit({info}, res.fences.at(frame_handles::transfer));
+  }
 }
 
 template<typename T> 
 SubmitInfo ApplicationThreadedTransfer<T>::createDrawSubmitInfo(FrameResource const& res) const {
   // ignore submit info of ApplicationThreaded
   SubmitInfo info = T::createDrawSubmitInfo(res);
-  info.addWaitSemaphore(res.semaphore("transfer"), vk::PipelineStageFlagBits::eDrawIndirect);
+  // transfers only write vertex data, acquired at vertex input
+  if (res.hasTimeline(frame_handles::transfer)) {
+    auto const& point = res.timelines.at(frame_handles::transfer);
+    info.addWaitSemaphore(point.semaphore->get(), vk::PipelineStageFlagBits::eVertexInput, point.value);
+  }
+  else {
+    info.addWaitSemaphore(res.semaphore(frame_handles::transfer), vk::PipelineStageFlagBits::eVertexInput);
+  }
   return info;
 }
 
+template<typename T> 
+uint32_t ApplicationThreadedTransfer<T>::transferQueueFamily() const {
+  return this->m_device.getQueueIndex("transfer");
+}
+
 template<typename T> 
 void ApplicationThreadedTransfer<T>::transferLoop() {
   // wait for first frame
-  m_semaphore_transfer.wait();
+  m_queue_transfer_frames.wait();
   while (m_should_transfer) {
     transfer();
-    this->m_statistics.start("sema_transfer");
-    m_semaphore_transfer.wait();
-    this->m_statistics.stop("sema_transfer");
+    this->m_statistics.start(frame_handles::sema_transfer);
+    m_queue_transfer_frames.wait();
+    this->m_statistics.stop(frame_handles::sema_transfer);
   }
 }
@@ -6,10 +6,20 @@
 
 #include "allocator_static.hpp"
 
+#include <queue>
+#include <vector>
+
 class FrameResource;
 class Surface;
 
 class ApplicationWorker : public Application {
+  struct readback_t {
+    uint32_t resource;
+    uint32_t slot;
+    // copy of frame timer, resource may be rerecorded before frame is sent
+    Timer timer_latency;
+  };
+
  public:
   // allocate and initialize objects
   ApplicationWorker(std::string const& resource_path, Device& device, Surface const& surf, uint32_t image_count, cmdline::parser const& cmd_parse);
@@ -26,7 +36,6 @@ class ApplicationWorker : public Application {
   void acquireImage(FrameResource& res);
   void presentFrame(FrameResource& res);
   virtual void onResize() override;
-  virtual void updateFrameResources() override;
 
   glm::fmat4 const& matrixView() const;
   glm::fmat4 const& matrixFrustum() const;
@@ -36,6 +45,7 @@ class ApplicationWorker : public Application {
   virtual glm::u32vec2 queryResolution() const override final;
 
   virtual void presentCommands(FrameResource& res, ImageLayers const& view, vk::ImageLayout const& layout) override;
+  virtual void recordMemoryStatistics() override;
 
  private:
   void createImages(uint32_t image_count);
@@ -46,6 +56,15 @@ class ApplicationWorker : public Application {
  private:
   StaticAllocator m_allocator;
   uint8_t* m_ptr_buff_transfer;
+  // one more slot than frame resources, frames are sent one frame later
+  std::vector<BufferView> m_views_readback;
+  uint32_t m_slot_next;
+  // slot of last recorded copy per frame resource
+  std::vector<uint32_t> m_slots_recorded;
+  // frames not yet sent
+  std::queue<readback_t> m_readbacks;
+  // 0 if memory is coherent
+  vk::DeviceSize m_atom_invalidate;
   bool m_should_close;
   glm::fmat4 m_mat_view;
   glm::fmat4 m_mat_frustum;
@@ -7,12 +7,16 @@ class Averager {
 	Averager()
    :m_average{}
    ,m_max{}
+   ,m_m2{}
    ,m_count{0}
   {}
 
   void add(T const& val) {
+    auto delta = val - m_average;
     m_average = (m_average * T(m_count) + val) / T(m_count + 1);
     m_count += 1;
+    // welford update of squared distances to mean
+    m_m2 += delta * (val - m_average);
     if (val > m_max) {
       m_max = val;
     }
@@ -26,9 +30,14 @@ class Averager {
     return m_max;
   }
 
+  T variance() const {
+    return m_count > 1 ? m_m2 / T(m_count - 1) : T{};
+  }
+
   private:
   T m_average;
   T m_max;
+  T m_m2;
   unsigned long m_count;
 };
 
@@ -0,0 +1,31 @@
+#ifndef FRAME_HANDLES_HPP
+#define FRAME_HANDLES_HPP
+
+#include "handle.hpp"
+
+// names used by the frame pipeline every frame, resolved once
+namespace frame_handles {
+  // command buffers, semaphores, fences and queues
+  extern Handle const primary;
+  extern Handle const transfer;
+  extern Handle const draw;
+  extern Handle const acquire;
+  extern Handle const graphics;
+  extern Handle const present;
+  // statistics
+  extern Handle const frame;
+  extern Handle const frame_latency;
+  extern Handle const pacing_delay;
+  extern Handle const record;
+  extern Handle const frame_draw;
+  extern Handle const frame_transfer;
+  extern Handle const fence_draw;
+  extern Handle const fence_transfer;
+  extern Handle const fence_acquire;
+  extern Handle const sema_draw;
+  extern Handle const sema_present;
+  extern Handle const sema_transfer;
+  extern Handle const queue_present;
+}
+
+#endif
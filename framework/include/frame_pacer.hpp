@@ -0,0 +1,40 @@
+#ifndef FRAME_PACER_HPP
+#define FRAME_PACER_HPP
+
+#include <chrono>
+#include <deque>
+
+// delays frame starts so that time spent blocked on the gpu or display is spent before input is sampled
+// frames then finish just before they are presented
+class FramePacer {
+ public:
+  // disabled
+  FramePacer();
+  // period in ms limits the frame rate, 0 - display or gpu set the pace
+  FramePacer(double period, std::size_t history = 16);
+
+  // sleeps until the predicted frame start, returns slept time in ms
+  double wait();
+  // recording thread was blocked in current frame
+  void addBlocked(double duration);
+  // updates prediction with blocked time of current frame
+  void frameEnd();
+
+  bool enabled() const;
+  // delay predicted for next frame in ms
+  double delay() const;
+
+ private:
+  typedef std::chrono::steady_clock clock_type;
+
+  bool m_enabled;
+  double m_period;
+  std::size_t m_history;
+  // slack of recent frames, sleep and blocked time
+  std::deque<double> m_slacks;
+  double m_delay;
+  double m_blocked;
+  clock_type::time_point m_time_start;
+};
+
+#endif
@@ -4,15 +4,25 @@
 #include <vulkan/vulkan.hpp>
 
 #include "wrap/fence.hpp"
+#include "wrap/timeline_semaphore.hpp"
 #include "wrap/buffer.hpp"
 #include "wrap/buffer_view.hpp"
 #include "wrap/image_view.hpp"
 #include "wrap/query_pool.hpp"
 #include "wrap/descriptor_set.hpp"
 #include "wrap/command_buffer.hpp"
+#include "transient_buffer.hpp"
+#include "wrap/timer.hpp"
+#include "handle_map.hpp"
 
 #include <vector>
 
+// value a timeline semaphore reaches when a submission is finished
+struct timeline_point_t {
+  TimelineSemaphore* semaphore;
+  uint64_t value;
+};
+
 class FrameResource {
  public:
   FrameResource()
@@ -53,6 +63,11 @@ class FrameResource {
    fences.emplace(name, Fence{(*m_device), vk::FenceCreateFlagBits::eSignaled});
   }
 
+  // submissions under name signal the timeline instead of the fence
+  void addTimeline(std::string const& name, TimelineSemaphore& semaphore) {
+    timelines.emplace(name, timeline_point_t{&semaphore, 0});
+  }
+
   void setCommandBuffer(std::string const& name, CommandBuffer&& buffer) {
     command_buffers[name] = std::move(buffer);
   }
@@ -60,16 +75,92 @@ class FrameResource {
   vk::Semaphore const& semaphore(std::string const& name) const {
     return semaphores.at(name);
   }
+  vk::Semaphore const& semaphore(Handle const& handle) const {
+    return semaphores.at(handle);
+  }
 
   Fence& fence(std::string const& name) {
     return fences.at(name);
   }
+  Fence& fence(Handle const& handle) {
+    return fences.at(handle);
+  }
 
   CommandBuffer& commandBuffer(std::string const& name) {
     return command_buffers.at(name);
   }
+  CommandBuffer& commandBuffer(Handle const& handle) {
+    return command_buffers.at(handle);
+  }
+
+  // cached secondary buffers are reused while the state they were recorded with is unchanged
+  bool recorded(std::string const& name, uint64_t state) const {
+    auto iter = states_recorded.find(name);
+    return iter != states_recorded.end() && iter->second == state;
+  }
+
+  void setRecorded(std::string const& name, uint64_t state) {
+    states_recorded[name] = state;
+  }
+
+  // forces re-recording of cached buffers, e.g. after pipelines or framebuffers changed
+  void invalidateRecorded() {
+    states_recorded.clear();
+  }
+
+  bool hasTimeline(std::string const& name) const {
+    return timelines.find(name) != timelines.end();
+  }
+  bool hasTimeline(Handle const& handle) const {
+    return timelines.contains(handle);
+  }
+
+  timeline_point_t& timeline(std::string const& name) {
+    return timelines.at(name);
+  }
+  timeline_point_t& timeline(Handle const& handle) {
+    return timelines.at(handle);
+  }
+
+  // waits for last submission under name
+  void wait(std::string const& name) {
+    auto iter = timelines.find(name);
+    if (iter != timelines.end()) {
+      iter->second.semaphore->wait(iter->second.value);
+    }
+    else {
+      fences.at(name).wait();
+    }
+  }
+  void wait(Handle const& handle) {
+    if (hasTimeline(handle)) {
+      auto const& point = timelines.at(handle);
+      point.semaphore->wait(point.value);
+    }
+    else {
+      fence(handle).wait();
+    }
+  }
+
+  bool finished(std::string const& name) const {
+    auto iter = timelines.find(name);
+    if (iter != timelines.end()) {
+      return iter->second.semaphore->signaled(iter->second.value);
+    }
+    return fences.at(name).signaled();
+  }
+  bool finished(Handle const& handle) const {
+    if (hasTimeline(handle)) {
+      auto const& point = timelines.at(handle);
+      return point.semaphore->signaled(point.value);
+    }
+    return fences.at(handle).signaled();
+  }
 
   void waitFences() const {
+    for(auto const& pair_timeline : timelines) {
+      pair_timeline.second.semaphore->wait(pair_timeline.second.value);
+    }
     std::vector<vk::Fence> wait_fences;
     for(auto const& pair_fence : fences) {
       wait_fences.emplace_back(pair_fence.second);
@@ -90,11 +181,15 @@ class FrameResource {
     std::swap(command_buffers, rhs.command_buffers);
     std::swap(semaphores, rhs.semaphores);
     std::swap(fences, rhs.fences);
+    std::swap(timelines, rhs.timelines);
+    std::swap(states_recorded, rhs.states_recorded);
     std::swap(descriptor_sets, rhs.descriptor_sets);
     std::swap(buffers, rhs.buffers);
     std::swap(buffer_views, rhs.buffer_views);
     std::swap(query_pools, rhs.query_pools);
+    std::swap(transient_buffer, rhs.transient_buffer);
     std::swap(num_uploads, rhs.num_uploads);
+    std::swap(timer_latency, rhs.timer_latency);
   }
   // for presenting
   uint32_t image; 
@@ -102,13 +197,22 @@ class FrameResource {
   ImageLayers target_region;
   // for transferring between queues
   uint32_t index;
-  std::map<std::string, CommandBuffer> command_buffers;
-  std::map<std::string, vk::Semaphore> semaphores;
-  std::map<std::string, Fence> fences;
+  // also indexed by handle, for lookups on hot paths
+  HandleMap<CommandBuffer> command_buffers;
+  HandleMap<vk::Semaphore> semaphores;
+  HandleMap<Fence> fences;
+  // entries only written by the thread submitting under that name
+  HandleMap<timeline_point_t> timelines;
+  // state cached command buffers were recorded with
+  std::map<std::string, uint64_t> states_recorded;
   std::map<std::string, DescriptorSet> descriptor_sets;
   std::map<std::string, Buffer> buffers;
   std::map<std::string, BufferView> buffer_views;
   std::map<std::string, QueryPool> query_pools;
+  // per-frame uniform and staging data, reset when draw fence is signaled
+  TransientBuffer transient_buffer;
+  // started when recording begins, stopped on present
+  Timer timer_latency;
 
  private:
   Device const* m_device;
@@ -11,13 +11,17 @@
 class Device;
 class Transferrer;
 class VertexInfo;
+class GeometryBuffer;
 
 class Geometry {
  public:  
   Geometry();
   Geometry(Transferrer& transferrer, vertex_data const& model);
+  // packed into shared buffers
+  Geometry(GeometryBuffer& storage, vertex_data const& model);
   Geometry(Geometry && dev);
   Geometry(Geometry const&) = delete;
+  ~Geometry();
 
   Geometry& operator=(Geometry const&) = delete;
   Geometry& operator=(Geometry&& dev);
@@ -25,12 +29,13 @@ class Geometry {
   void swap(Geometry& dev);
 
   vk::Buffer const& buffer() const;
-  BufferView const& vertices() const;
-  BufferView const& indices() const;
+  BufferRegion const& vertices() const;
+  BufferRegion const& indices() const;
 
   VertexInfo vertexInfo() const;
   uint32_t numIndices() const;
   uint32_t numVertices() const;
+  // in elements, relative to buffer start
   uint32_t indexOffset() const;
   uint32_t vertexOffset() const;
 
@@ -41,6 +46,9 @@ class Geometry {
   Buffer m_buffer;
   BufferView m_view_vertices;
   BufferView m_view_indices;
+  // set if packed
+  GeometryBuffer* m_storage;
+  uint32_t m_handle;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,76 @@
+#ifndef GEOMETRY_BUFFER_HPP
+#define GEOMETRY_BUFFER_HPP
+
+#include "wrap/buffer.hpp"
+#include "allocator_static.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class Transferrer;
+struct vertex_data;
+
+// vertices and indices of many geometries packed into few large buffers
+class GeometryBuffer {
+  struct page_t {
+    // destroy allocator after buffer
+    StaticAllocator allocator;
+    Buffer buffer;
+    // offset to size
+    std::map<vk::DeviceSize, vk::DeviceSize> free_ranges;
+  };
+
+  struct slot_t {
+    size_t page;
+    vk::DeviceSize offset;
+    vk::DeviceSize size;
+    // multiple of vertex stride, for vertex offsets in draws
+    vk::DeviceSize alignment;
+    BufferRegion vertices;
+    BufferRegion indices;
+  };
+
+ public:
+  GeometryBuffer();
+  // geometries larger than a page get a page of their own
+  GeometryBuffer(Transferrer& transferrer, vk::DeviceSize page_bytes);
+  GeometryBuffer(GeometryBuffer && rhs);
+  GeometryBuffer(GeometryBuffer const&) = delete;
+
+  GeometryBuffer& operator=(GeometryBuffer const&) = delete;
+  GeometryBuffer& operator=(GeometryBuffer&& rhs);
+
+  void swap(GeometryBuffer& rhs);
+
+  // records upload into current transfer batch, returns handle
+  uint32_t store(vertex_data const& model);
+  void free(uint32_t handle);
+  BufferRegion const& vertices(uint32_t handle) const;
+  BufferRegion const& indices(uint32_t handle) const;
+
+  std::size_t numPages() const;
+  vk::DeviceSize bytesReserved() const;
+  vk::DeviceSize bytesUsed() const;
+
+ private:
+  std::unique_ptr<page_t> createPage(vk::DeviceSize size) const;
+  // returns false if page has no matching range
+  bool claimRange(page_t& page, vk::DeviceSize size, vk::DeviceSize alignment, vk::DeviceSize& offset);
+  void releaseRange(page_t& page, vk::DeviceSize offset, vk::DeviceSize size);
+  void setRegions(slot_t& slot, vk::DeviceSize bytes_vertices, vk::DeviceSize bytes_indices) const;
+
+  Transferrer* m_transferrer;
+  vk::DeviceSize m_page_bytes;
+  // released pages are null
+  std::vector<std::unique_ptr<page_t>> m_pages;
+  std::map<uint32_t, slot_t> m_slots;
+  uint32_t m_next_handle;
+  vk::DeviceSize m_bytes_used;
+  mutable std::mutex m_mutex;
+};
+
+#endif
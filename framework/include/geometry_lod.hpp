@@ -18,6 +18,7 @@
 #include <atomic>
 
 class Device;
+class CommandBuffer;
 class Camera;
 class Transferrer;
 class VertexInfo;
@@ -50,13 +51,18 @@ class GeometryLod {
   std::uint32_t numVertices() const;
   std::size_t numUploads() const;
   std::size_t sizeNode() const;
+  // for memory statistics
+  StaticAllocator const& allocatorDraw() const;
+  StaticAllocator const& allocatorStage() const;
 
   VertexInfo vertexInfo() const;
 
   void update(Camera const& cam);
   void update(glm::fmat4 const& view, glm::fmat4 const& projection);
-  void performCopiesCommand(vk::CommandBuffer const& command_buffer);
-  void updateDrawCommands(vk::CommandBuffer const& command_buffer);
+  // records copies of new nodes into a buffer submitted to queue family, releases them to the graphics queue
+  void performCopiesCommand(CommandBuffer const& command_buffer, uint32_t family);
+  // records into graphics buffer outside of renderpass, acquires released nodes
+  void updateDrawCommands(CommandBuffer const& command_buffer);
   std::vector<vk::DrawIndirectCommand> const& drawCommands() const;
   BufferView const& viewDrawCommands() const;
   BufferView const& viewNodeLevels() const;
@@ -105,6 +111,8 @@ class GeometryLod {
   std::vector<std::size_t> m_slots;
   std::vector<std::size_t> m_active_slots;
   std::vector<std::pair<std::size_t, std::size_t>> m_node_uploads;
+  // written slots and family of the writing queue, until acquired by the graphics queue
+  std::vector<std::pair<uint32_t, BufferRegion>> m_regions_released;
   std::vector<vk::DrawIndirectCommand> m_commands_draw;
   DoubleBuffer<std::vector<BufferRegion>> m_db_views_stage;
   uint8_t* m_ptr_mem_stage;
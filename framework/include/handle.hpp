@@ -0,0 +1,27 @@
+#ifndef HANDLE_HPP
+#define HANDLE_HPP
+
+#include <cstdint>
+#include <string>
+
+// name registered once and resolved to a dense process-wide index
+// used for lookups on hot paths instead of comparing strings
+class Handle {
+ public:
+  // invalid
+  Handle();
+  // registers name if it is new, thread-safe
+  explicit Handle(std::string const& name);
+
+  uint32_t index() const;
+  std::string const& name() const;
+  bool valid() const;
+
+  // number of registered names, all indices are smaller
+  static uint32_t count();
+
+ private:
+  uint32_t m_index;
+};
+
+#endif
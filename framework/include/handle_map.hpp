@@ -0,0 +1,130 @@
+#ifndef HANDLE_MAP_HPP
+#define HANDLE_MAP_HPP
+
+#include "handle.hpp"
+
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// string-keyed map that can also be indexed by handle without string comparisons
+// elements are owned by a std::map, so references stay valid like before
+template<typename T>
+class HandleMap {
+ public:
+  typedef typename std::map<std::string, T>::iterator iterator;
+  typedef typename std::map<std::string, T>::const_iterator const_iterator;
+
+  HandleMap()
+   :m_elements{}
+   ,m_slots{}
+  {}
+
+  HandleMap(HandleMap && rhs)
+   :HandleMap{}
+  {
+    swap(rhs);
+  }
+
+  HandleMap(HandleMap const&) = delete;
+  HandleMap& operator=(HandleMap const&) = delete;
+
+  HandleMap& operator=(HandleMap&& rhs) {
+    swap(rhs);
+    return *this;
+  }
+
+  void swap(HandleMap& rhs) {
+    // map nodes are not moved, slot pointers stay valid
+    std::swap(m_elements, rhs.m_elements);
+    std::swap(m_slots, rhs.m_slots);
+  }
+
+  template<typename U>
+  std::pair<iterator, bool> emplace(std::string const& name, U&& value) {
+    auto result = m_elements.emplace(name, std::forward<U>(value));
+    if (result.second) {
+      addSlot(Handle{name}, result.first->second);
+    }
+    return result;
+  }
+
+  T& operator[](std::string const& name) {
+    auto iter = m_elements.find(name);
+    if (iter == m_elements.end()) {
+      iter = m_elements.emplace(name, T{}).first;
+      addSlot(Handle{name}, iter->second);
+    }
+    return iter->second;
+  }
+
+  T& at(std::string const& name) {
+    return m_elements.at(name);
+  }
+  T const& at(std::string const& name) const {
+    return m_elements.at(name);
+  }
+
+  T& at(Handle const& handle) {
+    return *slot(handle);
+  }
+  T const& at(Handle const& handle) const {
+    return *slot(handle);
+  }
+
+  bool contains(Handle const& handle) const {
+    return handle.index() < m_slots.size() && m_slots[handle.index()] != nullptr;
+  }
+
+  iterator find(std::string const& name) {
+    return m_elements.find(name);
+  }
+  const_iterator find(std::string const& name) const {
+    return m_elements.find(name);
+  }
+
+  std::size_t count(std::string const& name) const {
+    return m_elements.count(name);
+  }
+  std::size_t size() const {
+    return m_elements.size();
+  }
+  bool empty() const {
+    return m_elements.empty();
+  }
+
+  iterator begin() {
+    return m_elements.begin();
+  }
+  iterator end() {
+    return m_elements.end();
+  }
+  const_iterator begin() const {
+    return m_elements.begin();
+  }
+  const_iterator end() const {
+    return m_elements.end();
+  }
+
+ private:
+  void addSlot(Handle const& handle, T& value) {
+    if (handle.index() >= m_slots.size()) {
+      m_slots.resize(handle.index() + 1, nullptr);
+    }
+    m_slots[handle.index()] = &value;
+  }
+
+  T* slot(Handle const& handle) const {
+    if (!contains(handle)) {
+      throw std::out_of_range{"no element for handle"};
+    }
+    return m_slots[handle.index()];
+  }
+
+  std::map<std::string, T> m_elements;
+  // pointers into elements, indexed by handle
+  std::vector<T*> m_slots;
+};
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+// fixed-size histogram with logarithmic buckets, 8 per power of two
+// buckets are about 9% wide, percentiles are interpolated within a bucket
+class Histogram {
+ public:
+  // values up to 2^-20 share the first bucket, from 2^36 the last one
+  static const int32_t EXP_MIN = -20;
+  static const int32_t EXP_MAX = 36;
+  static const uint32_t SUB_BITS = 3;
+  static const uint32_t NUM_BUCKETS = uint32_t(EXP_MAX - EXP_MIN) << SUB_BITS;
+
+  Histogram()
+   :m_buckets{}
+   ,m_count{0}
+   ,m_sum{0.0}
+   ,m_sum_squares{0.0}
+   ,m_min{std::numeric_limits<double>::max()}
+   ,m_max{std::numeric_limits<double>::lowest()}
+  {}
+
+  // read from exponent and leading mantissa bits of the value
+  static uint32_t bucket(double value) {
+    // also catches nan
+    if (!(value > 0.0)) return 0;
+    uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    auto exponent = int32_t(bits >> 52) - 1023;
+    if (exponent < EXP_MIN) return 0;
+    if (exponent >= EXP_MAX) return NUM_BUCKETS - 1;
+    auto sub = uint32_t(bits >> (52 - SUB_BITS)) & ((1u << SUB_BITS) - 1u);
+    return (uint32_t(exponent - EXP_MIN) << SUB_BITS) | sub;
+  }
+
+  static double lower(uint32_t bucket) {
+    auto sub = double(bucket & ((1u << SUB_BITS) - 1u)) / double(1u << SUB_BITS);
+    return std::ldexp(1.0 + sub, EXP_MIN + int32_t(bucket >> SUB_BITS));
+  }
+
+  static double upper(uint32_t bucket) {
+    return bucket + 1 < NUM_BUCKETS ? lower(bucket + 1) : std::ldexp(1.0, EXP_MAX);
+  }
+
+  void add(double value) {
+    ++m_buckets[bucket(value)];
+    ++m_count;
+    m_sum += value;
+    m_sum_squares += value * value;
+    m_min = std::min(m_min, value);
+    m_max = std::max(m_max, value);
+  }
+
+  void merge(Histogram const& rhs) {
+    for (uint32_t i = 0; i < NUM_BUCKETS; ++i) {
+      m_buckets[i] += rhs.m_buckets[i];
+    }
+    m_count += rhs.m_count;
+    m_sum += rhs.m_sum;
+    m_sum_squares += rhs.m_sum_squares;
+    m_min = std::min(m_min, rhs.m_min);
+    m_max = std::max(m_max, rhs.m_max);
+  }
+
+  uint64_t count() const {
+    return m_count;
+  }
+
+  double mean() const {
+    return m_count > 0 ? m_sum / double(m_count) : 0.0;
+  }
+
+  double variance() const {
+    if (m_count < 2) return 0.0;
+    auto mean_squares = m_sum * m_sum / double(m_count);
+    return std::max(0.0, (m_sum_squares - mean_squares) / double(m_count - 1));
+  }
+
+  double min() const {
+    return m_count > 0 ? m_min : 0.0;
+  }
+
+  double max() const {
+    return m_count > 0 ? m_max : 0.0;
+  }
+
+  // percent in [0, 100], clamped to the exact minimum and maximum
+  double percentile(double percent) const {
+    if (m_count == 0) return 0.0;
+    auto rank = std::min(std::max(percent, 0.0), 100.0) / 100.0 * double(m_count);
+    double count_below = 0.0;
+    for (uint32_t i = 0; i < NUM_BUCKETS; ++i) {
+      if (m_buckets[i] == 0) continue;
+      auto count_bucket = double(m_buckets[i]);
+      if (count_below + count_bucket >= rank) {
+        auto fraction = (rank - count_below) / count_bucket;
+        auto value = lower(i) + (upper(i) - lower(i)) * fraction;
+        return std::min(std::max(value, m_min), m_max);
+      }
+      count_below += count_bucket;
+    }
+    return m_max;
+  }
+
+ private:
+  // per-thread accumulators of statistics fill in the fields directly
+  friend class Statistics;
+
+  std::array<uint64_t, NUM_BUCKETS> m_buckets;
+  uint64_t m_count;
+  double m_sum;
+  double m_sum_squares;
+  double m_min;
+  double m_max;
+};
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef HOST_RESOURCE_HPP
+#define HOST_RESOURCE_HPP
+
+#include "wrap/memory_resource.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+// resource without vulkan object, to exercise allocators with a host backend
+class HostResource : public MemoryResource {
+ public:
+  HostResource();
+  HostResource(vk::MemoryRequirements const& requirements);
+  HostResource(HostResource && rhs);
+  HostResource(HostResource const&) = delete;
+  ~HostResource();
+
+  HostResource& operator=(HostResource const&) = delete;
+  HostResource& operator=(HostResource&& rhs);
+
+  void swap(HostResource& rhs);
+
+  void bindTo(vk::DeviceMemory const& memory, vk::DeviceSize const& offset) override;
+  vk::MemoryRequirements requirements() const override;
+  res_handle_t handle() const override;
+
+  vk::DeviceMemory const& memory() const;
+  vk::DeviceSize offset() const;
+
+ private:
+  vk::MemoryRequirements m_requirements;
+  VkBuffer m_handle;
+  vk::DeviceMemory m_memory;
+  vk::DeviceSize m_offset;
+};
+
+#endif
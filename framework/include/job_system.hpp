@@ -0,0 +1,82 @@
+#ifndef JOB_SYSTEM_HPP
+#define JOB_SYSTEM_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class JobGroup;
+class Statistics;
+
+// worker threads with one deque each, idle workers steal from the others
+class JobSystem {
+  struct workers_t;
+
+ public:
+  struct job_t {
+    std::function<void()> func;
+    JobGroup* group;
+    // job is profiled if not empty
+    std::string name;
+  };
+
+  // no workers, jobs are executed by waiting threads
+  JobSystem();
+  JobSystem(std::size_t num_workers);
+  JobSystem(JobSystem && rhs);
+  JobSystem(JobSystem const&) = delete;
+  // jobs must have been waited for
+  ~JobSystem();
+
+  JobSystem& operator=(JobSystem const&) = delete;
+  JobSystem& operator=(JobSystem&& rhs);
+
+  void swap(JobSystem& rhs);
+
+  // job is counted by group until it is finished
+  void run(JobGroup& group, std::function<void()> const& job, std::string const& name = "");
+  // job is started once all jobs in dependency are finished
+  void runAfter(JobGroup& dependency, JobGroup& group, std::function<void()> const& job, std::string const& name = "");
+  // each chunk of grain indices is one job, returns when all are finished
+  void parallelFor(std::size_t begin, std::size_t end, std::function<void(std::size_t)> const& func, std::size_t grain = 1, std::string const& name = "");
+  // executes jobs until group is finished, rethrows first exception of its jobs
+  void wait(JobGroup& group) const;
+
+  std::size_t numWorkers() const;
+  // adds durations of named jobs to statistics "job_<name>", in ms
+  // averagers are registered on the first sample of a name, only one thread may record
+  void recordStatistics(Statistics& statistics) const;
+
+  // one less than hardware threads, the waiting thread is the last
+  static std::size_t numHardwareWorkers();
+
+ private:
+  std::unique_ptr<workers_t> m_workers;
+};
+
+// counts unfinished jobs, can be reused once finished
+class JobGroup {
+ public:
+  JobGroup();
+  JobGroup(JobGroup const&) = delete;
+  JobGroup& operator=(JobGroup const&) = delete;
+
+  bool finished() const;
+
+ private:
+  friend class JobSystem;
+
+  std::atomic<uint32_t> m_pending;
+  // jobs started once group is finished
+  std::vector<JobSystem::job_t> m_continuations;
+  std::exception_ptr m_error;
+  // guards continuations, error and the last decrement of pending
+  std::mutex m_mutex;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef MEMORY_BACKEND_HPP
+#define MEMORY_BACKEND_HPP
+
+#include <vulkan/vulkan.hpp>
+
+#include <map>
+#include <vector>
+
+class Device;
+
+// source of memory blocks for allocators
+class MemoryBackend {
+ public:
+  virtual ~MemoryBackend() {};
+
+  virtual vk::DeviceMemory allocate(uint32_t type_index, vk::DeviceSize const& size) = 0;
+  virtual void free(vk::DeviceMemory const& memory) = 0;
+
+  virtual uint8_t* map(vk::DeviceMemory const& memory, vk::DeviceSize const& size, vk::DeviceSize const& offset) = 0;
+  virtual void unmap(vk::DeviceMemory const& memory) = 0;
+};
+
+// allocates blocks from the device
+class DeviceMemoryBackend : public MemoryBackend {
+ public:
+  DeviceMemoryBackend(Device const& device);
+
+  vk::DeviceMemory allocate(uint32_t type_index, vk::DeviceSize const& size) override;
+  void free(vk::DeviceMemory const& memory) override;
+
+  uint8_t* map(vk::DeviceMemory const& memory, vk::DeviceSize const& size, vk::DeviceSize const& offset) override;
+  void unmap(vk::DeviceMemory const& memory) override;
+
+ private:
+  vk::Device m_device;
+};
+
+// allocates blocks from host memory, for testing allocators without device
+class HostMemoryBackend : public MemoryBackend {
+ public:
+  HostMemoryBackend();
+
+  vk::DeviceMemory allocate(uint32_t type_index, vk::DeviceSize const& size) override;
+  void free(vk::DeviceMemory const& memory) override;
+
+  uint8_t* map(vk::DeviceMemory const& memory, vk::DeviceSize const& size, vk::DeviceSize const& offset) override;
+  void unmap(vk::DeviceMemory const& memory) override;
+
+  // number of currently allocated blocks
+  std::size_t numBlocks() const;
+
+ private:
+  // storage is only created when the block is mapped
+  struct block_t {
+    vk::DeviceSize size;
+    std::vector<uint8_t> data;
+  };
+
+  uint64_t m_next_handle;
+  std::map<VkDeviceMemory, block_t> m_blocks;
+};
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef MEMORY_TELEMETRY_HPP
+#define MEMORY_TELEMETRY_HPP
+
+#include "handle.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+class Statistics;
+class Allocator;
+class ConcurrentAllocator;
+class Device;
+
+// records memory of allocators and heaps into averagers, sampled once per frame
+// averagers are registered on the first sample of a source, later samples only add values
+class MemoryTelemetry {
+ public:
+  MemoryTelemetry(Statistics& stats);
+
+  // sizes are recorded in MB, the maximum of each averager is the high-water mark
+  void record(std::string const& name, Allocator const& allocator);
+  // lock contention, counts are cumulative so the maximum is the total
+  void recordContention(std::string const& name, ConcurrentAllocator const& allocator);
+  // budget and usage of every memory heap
+  void recordHeaps(Device const& device);
+
+ private:
+  struct source_t {
+    std::string name;
+    std::vector<Handle> handles;
+  };
+  // handles of the averagers of source, in order of the metric names
+  std::vector<Handle> const& handles(std::map<void const*, source_t>& sources, void const* source, std::string const& name, std::vector<std::string> const& metrics);
+
+  Statistics* m_stats;
+  std::map<void const*, source_t> m_allocators;
+  std::map<void const*, source_t> m_contention;
+  std::vector<Handle> m_heaps;
+};
+
+#endif
@@ -31,12 +31,22 @@ struct pixel_data {
    :pixels()
    ,extent{}
    ,format{vk::Format::eUndefined}
+   ,level_bytes{}
   {}
 
   pixel_data(std::vector<std::uint8_t> dat, vk::Format f, std::uint32_t w, std::uint32_t h = 1, std::uint32_t d = 1)
    :pixels(dat)
    ,extent{w, h, d}
    ,format{f}
+   ,level_bytes{pixels.size()}
+  {}
+
+  // levels are stored consecutively, starting with the largest
+  pixel_data(std::vector<std::uint8_t> dat, std::vector<std::size_t> level_sizes, vk::Format f, std::uint32_t w, std::uint32_t h = 1, std::uint32_t d = 1)
+   :pixels(dat)
+   ,extent{w, h, d}
+   ,format{f}
+   ,level_bytes(level_sizes)
   {}
 
   void const* ptr() const {
@@ -47,11 +57,29 @@ struct pixel_data {
     return pixels.size();
   }
 
+  std::uint32_t levels() const {
+    return std::uint32_t(level_bytes.size());
+  }
+
+  void const* ptr(std::uint32_t level) const {
+    auto offset = pixels.data();
+    for (std::uint32_t i = 0; i < level; ++i) {
+      offset += level_bytes[i];
+    }
+    return offset;
+  }
+
+  size_t size(std::uint32_t level) const {
+    return level_bytes[level];
+  }
+
   std::vector<uint8_t> pixels;
   vk::Extent3D extent;
 
   // channel format
   vk::Format format; 
+  // size of each stored mip level
+  std::vector<std::size_t> level_bytes;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,98 @@
+#ifndef RING_QUEUE_HPP
+#define RING_QUEUE_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+// bounded lock-free queue for one producer and one consumer thread
+// consumer spins shortly before parking, producer only locks when consumer is parked
+template<typename T>
+class RingQueue {
+ public:
+  RingQueue(std::size_t capacity)
+   :m_slots(capacity)
+   ,m_head{0}
+   ,m_tail{0}
+   ,m_parked{false}
+   ,m_closed{false}
+   ,m_mutex{}
+   ,m_condition{}
+  {}
+
+  RingQueue(RingQueue const&) = delete;
+  RingQueue& operator=(RingQueue const&) = delete;
+
+  // producer
+  inline void push(T const& value) {
+    auto tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) >= m_slots.size()) {
+      throw std::runtime_error{"ring queue full"};
+    }
+    m_slots[tail % m_slots.size()] = value;
+    // seq_cst pairs with parking, consumer sees element or producer sees flag
+    m_tail.store(tail + 1);
+    if (m_parked.load()) {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      m_condition.notify_one();
+    }
+  }
+
+  // consumer, returns false if queue was closed and is empty
+  inline bool wait() {
+    for (uint32_t i = 0; i < SPIN_COUNT; ++i) {
+      if (!empty() || m_closed.load(std::memory_order_acquire)) {
+        return !empty();
+      }
+    }
+    std::unique_lock<std::mutex> lock{m_mutex};
+    m_parked.store(true);
+    m_condition.wait(lock, [this]{return !empty() || m_closed.load();});
+    m_parked.store(false);
+    return !empty();
+  }
+
+  // consumer, waits for next element
+  inline T pop() {
+    if (!wait()) {
+      throw std::runtime_error{"ring queue closed"};
+    }
+    auto head = m_head.load(std::memory_order_relaxed);
+    T value = m_slots[head % m_slots.size()];
+    m_head.store(head + 1, std::memory_order_release);
+    return value;
+  }
+
+  // wakes consumer, following waits return once queue is empty
+  inline void close() {
+    m_closed.store(true);
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_condition.notify_all();
+  }
+
+  // exact only on consumer side
+  inline std::size_t size() const {
+    return std::size_t(m_tail.load() - m_head.load());
+  }
+
+  inline bool empty() const {
+    return m_tail.load() == m_head.load(std::memory_order_relaxed);
+  }
+
+ private:
+  static const uint32_t SPIN_COUNT = 4096;
+
+  std::vector<T> m_slots;
+  // monotonic, element index is modulo capacity
+  std::atomic<uint64_t> m_head;
+  std::atomic<uint64_t> m_tail;
+  std::atomic<bool> m_parked;
+  std::atomic<bool> m_closed;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+};
+
+#endif
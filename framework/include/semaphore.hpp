@@ -17,10 +17,10 @@ class Semaphore {
       m_count += count;
     }
     if (count > 1) {
-      m_condition_lock.notify_one();
+      m_condition_lock.notify_all();
     }
     else {
-      m_condition_lock.notify_all();
+      m_condition_lock.notify_one();
     }
   }
 
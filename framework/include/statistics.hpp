@@ -1,47 +1,105 @@
 #ifndef STATISTICS_HPP
 #define STATISTICS_HPP
 
-#include "averager.hpp"
-#include "wrap/timer.hpp"
+#include "handle.hpp"
+#include "histogram.hpp"
 
+#include <atomic>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
 
+// named histograms of timings and other samples, can be recorded from any thread
+// each thread accumulates into its own shard without locks, readers merge the shards
 class Statistics {
  public:
-  Statistics()
-  {}
+  struct summary_t {
+    uint64_t count;
+    double mean;
+    double deviation;
+    double min;
+    double max;
+    double p50;
+    double p95;
+    double p99;
+  };
 
-  void addTimer(std::string const& name) {
-    m_timers[name] = Timer{};
-    addAverager(name);
-  }
+  // at most capacity metrics can be registered
+  Statistics(std::size_t capacity = 512);
+  ~Statistics();
 
-  void addAverager(std::string const& name) {
-    m_averages[name] = Averager<double>{};
-  }
+  Statistics(Statistics const&) = delete;
+  Statistics& operator=(Statistics const&) = delete;
 
-  void start(std::string const& name) {
-    m_timers.at(name).start();
-  }
+  // registration is thread-safe, registering an existing name keeps its samples
+  // returned handle is used for recording, it can be cached or be a constant with the same name
+  Handle addTimer(std::string const& name);
+  Handle addAverager(std::string const& name);
 
-  void stop(std::string const& name) {
-    m_averages.at(name).add(m_timers.at(name).durationEnd());
-  }
-  double stopValue(std::string const& name) {
-    return m_timers.at(name).durationEnd();
-  }
+  // timers are per thread, start and stop must be called on the same one
+  void start(std::string const& name);
+  // handles skip the locked name lookup, for use on hot paths
+  void start(Handle const& handle);
+  void stop(std::string const& name);
+  void stop(Handle const& handle);
+  double stopValue(std::string const& name);
+  double stopValue(Handle const& handle);
 
-  void add(std::string const& name, double value) {
-    m_averages.at(name).add(value);
-  }
+  // first sample of a metric on a thread allocates its shard, later ones never do
+  void add(std::string const& name, double value);
+  void add(Handle const& handle, double value);
 
-  double get(std::string const& name) {
-    return m_averages.at(name).get();
-  }
+  // over all samples since construction
+  double get(std::string const& name) const;
+  double max(std::string const& name) const;
+  double variance(std::string const& name) const;
+  double percentile(std::string const& name, double percent) const;
+  summary_t summary(std::string const& name) const;
+
+  bool contains(std::string const& name) const;
+
+  // metrics with samples since the last reset
+  std::map<std::string, summary_t> snapshot() const;
+  // starts a new snapshot period, samples recorded concurrently may be lost
+  void reset();
+
+  // average and maximum of all entries starting with prefix
+  void print(std::ostream& os, std::string const& prefix = "") const;
 
  private:
-  std::map<std::string, Averager<double>> m_averages; 
-  std::map<std::string, Timer> m_timers; 
+  struct metric_t;
+  struct shard_t;
+
+  static summary_t summarize(Histogram const& histogram);
+
+  void record(metric_t& metric, double value);
+  uint32_t slot(Handle const& handle) const;
+  // requires lock
+  uint32_t slot(std::string const& name) const;
+  uint32_t slotLocked(std::string const& name) const;
+  // accumulator of slot owned by the calling thread
+  metric_t& metric(uint32_t slot);
+  // samples of current period, requires lock
+  Histogram collect(uint32_t slot) const;
+
+  std::size_t m_capacity;
+  // identifies the instance in thread-local caches
+  uint64_t m_id;
+  // guards everything below except the table pointer and generation
+  mutable std::mutex m_mutex;
+  // ordered for printing
+  std::map<std::string, uint32_t> m_slots;
+  // samples of previous periods
+  std::vector<Histogram> m_totals;
+  std::vector<std::unique_ptr<shard_t>> m_shards;
+  // slot for each handle index, replaced on registration and kept until destruction
+  std::vector<std::unique_ptr<std::vector<uint32_t>>> m_tables;
+  std::atomic<std::vector<uint32_t> const*> m_table;
+  // incremented by reset, accumulators of older periods are cleared by their thread
+  std::atomic<uint64_t> m_generation;
 };
 
-#endif
\ No newline at end of file
+#endif
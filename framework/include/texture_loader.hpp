@@ -6,7 +6,8 @@
 #include <string>
 
 namespace texture_loader {
-  pixel_data file(std::string const& file_name);
+  // decoded images are cached in cache_dir if it is not empty, compressed formats are not
+  pixel_data file(std::string const& file_name, std::string const& cache_dir = std::string{});
 };
 
 #endif
\ No newline at end of file
@@ -8,12 +8,14 @@
 
 #include <mutex>
 #include <memory>
+#include <vector>
 
 class Buffer;
 class BufferRegion;
 class Memory;
 class Device;
 class BufferView;
+class Image;
 class BackedImage;
 class ImageView;
 class ImageRange;
@@ -21,12 +23,19 @@ class ImageLayers;
 class CommandPool;
 class CommandBuffer;
 
+// identifies a batch of transfers, batches complete in submission order
+using transfer_token_t = uint64_t;
+
 class Transferrer {
+  struct batch_t;
+  struct batches_t;
+
  public:
   Transferrer();
   Transferrer(Device const& device, CommandPool& pool);
   Transferrer(Transferrer && dev);
   Transferrer(Transferrer const&) = delete;
+  ~Transferrer();
 
   Transferrer& operator=(Transferrer&& dev);
   Transferrer& operator=(Transferrer const&) = delete;
@@ -38,7 +47,7 @@ class Transferrer {
   void copyBuffer(BufferRegion const& srcBuffer, BufferRegion const& dstBuffer) const;
 
   // image functions
-  void uploadImageData(void const* data_ptr, vk::DeviceSize data_size, ImageLayers const& image, vk::ImageLayout const& newLayout);
+  void uploadImageData(void const* data_ptr, vk::DeviceSize data_size, ImageLayers const& image, vk::Format const& format, vk::ImageLayout const& newLayout);
 
   void copyBufferToImage(BufferRegion const& srcBuffer, ImageLayers const& dstImage, vk::ImageLayout imageLayout) const;
   void copyImageToBuffer(ImageLayers const& dstImage, vk::ImageLayout imageLayout, BufferRegion const& srcBuffer) const;
@@ -46,23 +55,53 @@ class Transferrer {
   void transitionToLayout(ImageRange const& img, vk::ImageLayout const& newLayout) const;
   void transitionToLayout(ImageRange const& img, vk::ImageLayout const& oldLayout, vk::ImageLayout const& newLayout) const;
 
+  // batched functions, recorded commands are submitted together on flush
+  // commands of one batch are not ordered against each other, earlier batches are finished before
+  // data is copied to staging memory immediately, uploads larger than a quarter of the staging ring are split
+  transfer_token_t uploadBufferDataAsync(void const* data_ptr, BufferRegion const& buffer);
+  // format of the image determines where its data can be split
+  transfer_token_t uploadImageDataAsync(void const* data_ptr, vk::DeviceSize data_size, ImageLayers const& image, vk::Format const& format, vk::ImageLayout const& newLayout);
+  transfer_token_t copyBufferAsync(BufferRegion const& srcBuffer, BufferRegion const& dstBuffer) const;
+  transfer_token_t transitionToLayoutAsync(ImageRange const& img, vk::ImageLayout const& oldLayout, vk::ImageLayout const& newLayout) const;
+  // submit recording batch, returns its token
+  transfer_token_t flush() const;
+  bool isComplete(transfer_token_t token) const;
+  // flushes if token belongs to the recording batch
+  void wait(transfer_token_t token) const;
+  void waitAll() const;
+  std::size_t numSubmits() const;
+  // waits for in-flight batches to free staging memory
+  std::size_t numStagingStalls() const;
+
+  // fills levels after the first by blitting, level 0 must be in layout_base and the others undefined
+  // blits require a graphics queue, pending uploads are waited for before the blits are submitted
+  void generateMipmaps(std::vector<Image const*> const& images, vk::ImageLayout const& layout_base, vk::ImageLayout const& newLayout) const;
+
   // helper functions to create commandbuffer for staging an formating
+  // records into a new batch which is submitted and waited for on end
   CommandBuffer const& beginSingleTimeCommands() const;
   void endSingleTimeCommands() const;
 
+  // release staging ring
   void deallocate();
 
   Device const& device() const;
 
  private:
-  void adjustStagingPool(vk::DeviceSize const& size);
+  // must be called with batch lock held
+  batch_t& recordingBatch() const;
+  transfer_token_t flushLocked() const;
+  // waits for batches up to token, recycles all completed ones
+  void retire(transfer_token_t token) const;
+  // copies data to staging ring, may submit and wait for batches to free space
+  // returned region is used by the recording batch
+  BufferRegion stage(void const* data_ptr, vk::DeviceSize size) const;
+  // submits batch if it holds too much staging memory
+  transfer_token_t finishRecord(batch_t& batch) const;
 
   Device const* m_device;
-  CommandBuffer m_command_buffer_help;
-  std::unique_ptr<StaticAllocator> m_allocator_stage;
-  std::unique_ptr<Buffer> m_buffer_stage;
-  mutable std::mutex m_mutex_single_command;
-  mutable std::mutex m_mutex_staging;
+  CommandPool const* m_pool;
+  std::unique_ptr<batches_t> m_batches;
 };
 
 #endif
\ No newline at end of file
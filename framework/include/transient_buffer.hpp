@@ -0,0 +1,65 @@
+#ifndef TRANSIENT_BUFFER_HPP
+#define TRANSIENT_BUFFER_HPP
+
+#include "wrap/buffer.hpp"
+#include "allocator_static.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstring>
+#include <memory>
+
+class Device;
+
+// suballocation valid until the owning frame is reused
+struct transient_alloc_t {
+  uint8_t* ptr;
+  BufferRegion region;
+  // offset for binding as dynamic descriptor
+  uint32_t offset;
+};
+
+// persistently mapped host-visible buffer for data written once per frame
+// allocations are bump-pointer, reset() reclaims all at once after the frame fence signaled
+class TransientBuffer {
+ public:
+  TransientBuffer();
+  TransientBuffer(Device const& device, vk::DeviceSize size, vk::BufferUsageFlags const& usage = vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferSrc);
+  TransientBuffer(TransientBuffer && rhs);
+  TransientBuffer(TransientBuffer const&) = delete;
+
+  TransientBuffer& operator=(TransientBuffer const&) = delete;
+  TransientBuffer& operator=(TransientBuffer&& rhs);
+
+  void swap(TransientBuffer& rhs);
+
+  // aligned to satisfy uniform and storage descriptor offsets
+  transient_alloc_t allocate(vk::DeviceSize size);
+  transient_alloc_t allocate(vk::DeviceSize size, vk::DeviceSize alignment);
+  // allocate and copy data
+  template<typename T>
+  transient_alloc_t upload(T const& data);
+  // make whole buffer available again, only call when GPU is done reading
+  void reset();
+
+  Buffer const& buffer() const;
+  vk::DeviceSize size() const;
+  vk::DeviceSize used() const;
+
+ private:
+  // allocator is destroyed after buffer
+  std::unique_ptr<StaticAllocator> m_allocator;
+  Buffer m_buffer;
+  uint8_t* m_ptr;
+  vk::DeviceSize m_offset;
+  vk::DeviceSize m_alignment;
+};
+
+template<typename T>
+transient_alloc_t TransientBuffer::upload(T const& data) {
+  auto alloc = allocate(sizeof(T));
+  std::memcpy(alloc.ptr, &data, sizeof(T));
+  return alloc;
+}
+
+#endif
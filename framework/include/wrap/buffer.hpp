@@ -34,7 +34,8 @@ class Buffer : public ResourceBuffer{
  public:
   
   Buffer();
-  Buffer(Device const& dev, vk::DeviceSize const& size, vk::BufferUsageFlags const& usage);
+  // exclusive buffers written and read by different queue families need ownership transfers
+  Buffer(Device const& dev, vk::DeviceSize const& size, vk::BufferUsageFlags const& usage, vk::SharingMode const& sharing = vk::SharingMode::eConcurrent);
   Buffer(Buffer && dev);
   Buffer(Buffer const&) = delete;
   ~Buffer();
@@ -23,6 +23,9 @@ struct session_t {
   vk::PipelineBindPoint bind_point;
   vk::PipelineLayout pipe_layout;
   Geometry const* geometry;
+  // geometries in the same buffers are drawn without rebinding
+  vk::Buffer buffer_vertices;
+  vk::Buffer buffer_indices;
 };
 
 using WrapperCommandBuffer = Wrapper<vk::CommandBuffer, vk::CommandBufferAllocateInfo>;
@@ -62,6 +65,10 @@ class CommandBuffer : public WrapperCommandBuffer {
   void transitionLayout(ImageRange const& view, vk::ImageLayout const& layout_old, vk::ImageLayout const& layout_new) const;
   void imageBarrier(ImageRange const& range, vk::ImageLayout imageLayout, vk::PipelineStageFlags stage_src, vk::AccessFlags const& acc_src, vk::PipelineStageFlags stage_dst, vk::AccessFlags const& acc_dst) const;
   void bufferBarrier(BufferRegion const& buffer, vk::PipelineStageFlags stage_src, vk::AccessFlags const& acc_src, vk::PipelineStageFlags stage_dst, vk::AccessFlags const& acc_dst) const;
+  // queue family ownership transfer of exclusive buffers, recorded on the source and the destination queue
+  // the acquiring submission must wait for the releasing one, nothing is recorded for equal families
+  void releaseBuffer(BufferRegion const& buffer, uint32_t family_src, uint32_t family_dst, vk::PipelineStageFlags stage_src, vk::AccessFlags const& acc_src) const;
+  void acquireBuffer(BufferRegion const& buffer, uint32_t family_src, uint32_t family_dst, vk::PipelineStageFlags stage_dst, vk::AccessFlags const& acc_dst) const;
   
   void drawGeometry(uint32_t instanceCount = 1, uint32_t firstInstance = 0);
  private:
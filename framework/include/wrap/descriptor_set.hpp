@@ -7,7 +7,7 @@
 #include <vulkan/vulkan.hpp>
 
 class Buffer;
-class BufferView;
+class BufferRegion;
 class ImageView;
 
 using WrapperDescriptorSet = Wrapper<vk::DescriptorSet, DescriptorSetLayoutInfo>;
@@ -30,7 +30,8 @@ class DescriptorSet : public WrapperDescriptorSet {
 
   // write buffer
   void bind(uint32_t binding, uint32_t index_base, vk::ArrayProxy<Buffer const> const& view, vk::DescriptorType const& type) const;
-  void bind(uint32_t binding, uint32_t index_base, vk::ArrayProxy<BufferView const> const& view, vk::DescriptorType const& type) const;
+  // write buffer region, also used for views and dynamic descriptors
+  void bind(uint32_t binding, uint32_t index_base, vk::ArrayProxy<BufferRegion const> const& regions, vk::DescriptorType const& type) const;
 
 
   // write as combined sampler
@@ -2,6 +2,7 @@
 #define DEVICE_HPP
 
 #include "wrap/wrapper.hpp"
+#include "handle_map.hpp"
 
 #include <vulkan/vulkan.hpp>
 
@@ -19,6 +20,15 @@ struct QueueFamilyIndices {
     }
 };
 
+struct heap_budget_t {
+  vk::DeviceSize size;
+  // equal to size if budget cannot be queried
+  vk::DeviceSize budget;
+  // zero if budget cannot be queried
+  vk::DeviceSize usage;
+  bool device_local;
+};
+
 inline bool index_matches_filter(uint32_t index, uint32_t type_filter) {
   return (type_filter & (1u << index)) == (1u << index);
 }
@@ -50,17 +60,36 @@ class Device : public WrapperDevice {
   vk::PhysicalDevice const& physical() const;
 
   vk::Queue const& getQueue(std::string const& name) const;
+  vk::Queue const& getQueue(Handle const& handle) const;
   uint32_t getQueueIndex(std::string const& name) const;
 
   std::vector<uint32_t> ownerIndices() const;
+  // uses VK_EXT_memory_budget if enabled
+  std::vector<heap_budget_t> memoryHeaps() const;
+  // VK_KHR_timeline_semaphore is enabled
+  bool supportsTimeline() const;
+  // drawIndirectFirstInstance is enabled, otherwise indirect instances must be offset through buffer bindings
+  bool supportsIndirectFirstInstance() const;
 
  private:
   void destroy() override;
 
   vk::PhysicalDevice m_phys_device;
   std::map<std::string, uint32_t> m_queue_indices;
-  std::map<std::string, vk::Queue> m_queues;
+  HandleMap<vk::Queue> m_queues;
   std::vector<const char*> m_extensions;
+  bool m_indirect_first_instance;
+#ifdef VK_EXT_memory_budget
+  // set by instance if budget extension is enabled
+  PFN_vkGetPhysicalDeviceMemoryProperties2KHR m_query_budget;
+  friend class Instance;
+#endif
+#ifdef VK_KHR_timeline_semaphore
+  // set if timeline extension is enabled
+  PFN_vkWaitSemaphoresKHR m_wait_semaphores;
+  PFN_vkGetSemaphoreCounterValueKHR m_semaphore_value;
+  friend class TimelineSemaphore;
+#endif
 };
 
 #endif
\ No newline at end of file
@@ -23,6 +23,7 @@ class Fence : public WrapperFence {
   
   void wait();
   void reset();
+  bool signaled() const;
 
  private:
   void destroy() override;
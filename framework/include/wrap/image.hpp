@@ -10,6 +10,10 @@ class Memory;
 
 bool is_depth(vk::Format const& format);
 bool has_stencil(vk::Format const& format);
+// texel rows per block of compressed formats, 1 otherwise
+uint32_t block_height(vk::Format const& format);
+// number of levels of a full mip chain
+uint32_t mip_levels(vk::Extent3D const& extent);
 
 vk::Format findSupportedFormat(vk::PhysicalDevice const& physicalDevice, std::vector<vk::Format> const& candidates, vk::ImageTiling const& tiling, vk::FormatFeatureFlags const& features);
 
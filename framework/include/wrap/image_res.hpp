@@ -15,7 +15,7 @@ class BackedImage : public ResourceImage, public Image {
  public:
   
   BackedImage();
-  BackedImage(Device const& device, vk::Extent3D const& extent, vk::Format const& format, vk::ImageTiling const& tiling, vk::ImageUsageFlags const& usage); 
+  BackedImage(Device const& device, vk::Extent3D const& extent, vk::Format const& format, vk::ImageTiling const& tiling, vk::ImageUsageFlags const& usage, uint32_t levels = 1); 
   ~BackedImage();
 
   BackedImage(BackedImage && dev);
@@ -33,6 +33,8 @@ class Instance : public Wrapper<vk::Instance, vk::InstanceCreateInfo> {
   void destroy() override;
   
   bool m_validate;
+  // required for memory budget query
+  bool m_properties_2;
   std::vector<std::string> m_layers;
   DebugReporter m_debug_report;
 };
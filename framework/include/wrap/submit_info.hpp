@@ -19,6 +19,9 @@ class SubmitInfo {
   void setCommandBuffers(std::vector<vk::CommandBuffer> buffers);
   void addWaitSemaphore(vk::Semaphore sema, vk::PipelineStageFlags stage);
   void addSignalSemaphore(vk::Semaphore sema);
+  // timeline semaphores, binary ones in the same submission ignore their values
+  void addWaitSemaphore(vk::Semaphore sema, vk::PipelineStageFlags stage, uint64_t value);
+  void addSignalSemaphore(vk::Semaphore sema, uint64_t value);
 
   // operators from wrapper
   operator vk::SubmitInfo const&() const {
@@ -38,6 +41,13 @@ class SubmitInfo {
   // void destroy() override;
   std::vector<vk::CommandBuffer> m_command_buffers;
   std::vector<vk::Semaphore> m_signal_semas;
+#ifdef VK_KHR_timeline_semaphore
+  // only chained if a timeline semaphore was added
+  VkTimelineSemaphoreSubmitInfoKHR m_info_timeline;
+  bool m_timeline;
+#endif
+  std::vector<uint64_t> m_wait_values;
+  std::vector<uint64_t> m_signal_values;
 
   // vk::Device m_device;
 };
@@ -0,0 +1,40 @@
+#ifndef TIMELINE_SEMAPHORE_HPP
+#define TIMELINE_SEMAPHORE_HPP
+
+#include "wrap/wrapper.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+class Device;
+
+// semaphore with a counter, signaled and waited for with increasing values
+// requires VK_KHR_timeline_semaphore, see Device::supportsTimeline
+using WrapperTimelineSemaphore = Wrapper<vk::Semaphore, vk::SemaphoreCreateInfo>;
+class TimelineSemaphore : public WrapperTimelineSemaphore {
+ public:
+  TimelineSemaphore();
+  TimelineSemaphore(Device const& dev, uint64_t value = 0);
+  TimelineSemaphore(TimelineSemaphore && dev);
+  TimelineSemaphore(TimelineSemaphore const&) = delete;
+  ~TimelineSemaphore();
+  
+  TimelineSemaphore& operator=(TimelineSemaphore const&) = delete;
+  TimelineSemaphore& operator=(TimelineSemaphore&& dev);
+
+  void swap(TimelineSemaphore& dev);
+
+  // value to signal with the next submission, only called by the submitting thread
+  uint64_t next();
+  // value the gpu has reached
+  uint64_t value() const;
+  bool signaled(uint64_t value) const;
+  void wait(uint64_t value) const;
+
+ private:
+  void destroy() override;
+
+  Device const* m_device;
+  uint64_t m_value_submitted;
+};
+
+#endif
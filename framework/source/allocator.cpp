@@ -1,20 +1,40 @@
 #include "allocator.hpp"
 
+#include "memory_backend.hpp"
 #include "wrap/device.hpp"
 
 #include <utility>
 
 Allocator::Allocator()
  :m_device{nullptr}
+ ,m_backend{}
  ,m_type_index{0}
 {}
 
 Allocator::Allocator(Device const& device, uint32_t type_index)
  :m_device{&device}
+ ,m_backend{std::make_shared<DeviceMemoryBackend>(device)}
+ ,m_type_index{type_index}
+{}
+
+Allocator::Allocator(std::shared_ptr<MemoryBackend> const& backend, uint32_t type_index)
+ :m_device{nullptr}
+ ,m_backend{backend}
  ,m_type_index{type_index}
 {}
 
 void Allocator::swap(Allocator& rhs) {
   std::swap(m_device, rhs.m_device);
+  std::swap(m_backend, rhs.m_backend);
   std::swap(m_type_index, rhs.m_type_index);
 }
+
+double Allocator::fragmentation() const {
+  auto bytes_free = bytesReserved() - bytesUsed() - bytesOverhead();
+  if (bytes_free == 0) return 0.0;
+  return 1.0 - double(largestFreeRange()) / double(bytes_free);
+}
+
+uint32_t Allocator::typeIndex() const {
+  return m_type_index;
+}
@@ -1,16 +1,22 @@
 #include "allocator_block.hpp"
 
+#include "memory_backend.hpp"
 #include "wrap/device.hpp"
 #include "wrap/memory_resource.hpp"
 
 #include <vulkan/vulkan.hpp>
 
-#include <cmath>
+#include <algorithm>
 #include <iostream>
+#include <limits>
+
+static const uint32_t NO_BLOCK = std::numeric_limits<uint32_t>::max();
 
 BlockAllocator::BlockAllocator()
  :Allocator{}
  ,m_block_bytes{0}
+ ,m_bytes_used{0}
+ ,m_blocks{}
  ,m_free_ranges{}
  ,m_used_ranges{}
  ,m_ptrs{}
@@ -19,6 +25,18 @@ BlockAllocator::BlockAllocator()
 BlockAllocator::BlockAllocator(Device const& device, uint32_t type_index, uint32_t block_bytes)
  :Allocator{device, type_index}
  ,m_block_bytes{block_bytes}
+ ,m_bytes_used{0}
+ ,m_blocks{}
+ ,m_free_ranges{}
+ ,m_used_ranges{}
+ ,m_ptrs{}
+{}
+
+BlockAllocator::BlockAllocator(std::shared_ptr<MemoryBackend> const& backend, uint32_t type_index, uint32_t block_bytes)
+ :Allocator{backend, type_index}
+ ,m_block_bytes{block_bytes}
+ ,m_bytes_used{0}
+ ,m_blocks{}
  ,m_free_ranges{}
  ,m_used_ranges{}
  ,m_ptrs{}
@@ -31,12 +49,12 @@ BlockAllocator::BlockAllocator(BlockAllocator && rhs)
 }
 
 BlockAllocator::~BlockAllocator() {
-  uint32_t idx_block = 0;
-  for(auto& block : m_blocks) {
+  for(size_t idx_block = 0; idx_block < m_blocks.size(); ++idx_block) {
+    if (!m_blocks[idx_block]) continue;
     if (m_ptrs[idx_block] != nullptr) {
-      block.unmap();
+      m_backend->unmap(m_blocks[idx_block]);
     }
-    ++idx_block;
+    m_backend->free(m_blocks[idx_block]);
   }
 }
 
@@ -48,6 +66,7 @@ BlockAllocator& BlockAllocator::operator=(BlockAllocator&& rhs) {
 void BlockAllocator::swap(BlockAllocator& rhs) {
   Allocator::swap(rhs);
   std::swap(m_block_bytes, rhs.m_block_bytes);
+  std::swap(m_bytes_used, rhs.m_bytes_used);
   std::swap(m_blocks, rhs.m_blocks);
   std::swap(m_free_ranges, rhs.m_free_ranges);
   std::swap(m_used_ranges, rhs.m_used_ranges);
@@ -55,28 +74,64 @@ void BlockAllocator::swap(BlockAllocator& rhs) {
 }
 
 void BlockAllocator::addResource(MemoryResource& resource, range_t const& range) {
-  auto iter_block = m_blocks.begin(); 
-  std::advance(iter_block, range.block);
-  resource.bindTo(*iter_block, range.offset);
+  resource.bindTo(m_blocks[range.block], range.offset);
   resource.setAllocator(*this);
   m_used_ranges.emplace(res_handle_t{resource.handle()}, range);
+  m_bytes_used += range.size;
 }
 
-BlockAllocator::iterator_t BlockAllocator::findMatchingRange(vk::MemoryRequirements const& requirements) {
-  for(auto iter_range = m_free_ranges.begin(); iter_range != m_free_ranges.end(); ++iter_range) {
+BlockAllocator::iterator_t BlockAllocator::findMatchingRange(std::list<range_t>& ranges, vk::MemoryRequirements const& requirements, uint32_t block_excluded) const {
+  for(auto iter_range = ranges.begin(); iter_range != ranges.end(); ++iter_range) {
+    if (iter_range->block == block_excluded) continue;
     // round offset to alignment
-    auto offset_align = requirements.alignment * vk::DeviceSize(std::ceil(float(iter_range->offset) / float(requirements.alignment)));
+    auto offset_align = align_offset(iter_range->offset, requirements.alignment);
+    // padding may exceed range
+    if (offset_align - iter_range->offset > iter_range->size) continue;
     if (requirements.size <= iter_range->size - (offset_align - iter_range->offset)) {
       return iter_range;
     }
   }
-  return m_free_ranges.end();
+  return ranges.end();
 }
 
-void BlockAllocator::addBlock() {
-  m_free_ranges.emplace_back(range_t{uint32_t(m_blocks.size()), 0u, m_block_bytes});
-  m_blocks.emplace_back(Memory(*m_device, m_type_index, m_block_bytes));
-  m_ptrs.emplace_back(nullptr);
+void BlockAllocator::claimRange(std::list<range_t>& ranges, iterator_t iter_range, vk::DeviceSize offset, vk::DeviceSize size) const {
+  // object ends at end of range
+  if (size + offset == iter_range->size + iter_range->offset) {
+    // offset matches exactly, no more free space
+    if (offset == iter_range->offset) {
+      ranges.erase(iter_range);
+    }
+    else {
+      iter_range->size = offset - iter_range->offset;
+    }
+  }
+  // free space at end of range
+  else {
+    // free space in front of object
+    if (offset != iter_range->offset) {
+      // store free front space
+      ranges.emplace_back(iter_range->block, iter_range->offset, offset - iter_range->offset);
+    }
+    // remaining size
+    iter_range->size = (iter_range->size + iter_range->offset) - (offset + size);
+    // new offset
+    iter_range->offset = offset + size;
+  }
+}
+
+uint32_t BlockAllocator::addBlock() {
+  // reuse slot of released block to keep indices of other blocks
+  uint32_t idx_block = 0;
+  while (idx_block < m_blocks.size() && m_blocks[idx_block]) {
+    ++idx_block;
+  }
+  if (idx_block == m_blocks.size()) {
+    m_blocks.emplace_back();
+    m_ptrs.emplace_back(nullptr);
+  }
+  m_blocks[idx_block] = m_backend->allocate(m_type_index, m_block_bytes);
+  m_free_ranges.emplace_back(range_t{idx_block, 0u, m_block_bytes});
+  return idx_block;
 }
 
 void BlockAllocator::allocate(MemoryResource& resource) {
@@ -89,43 +144,25 @@ void BlockAllocator::allocate(MemoryResource& resource) {
   if (requirements.size > m_block_bytes) {
     throw std::runtime_error{"resource size of " + std::to_string(requirements.size) + " larger than block size of " + std::to_string(m_block_bytes)};
   }
-  auto iter_range = findMatchingRange(resource.requirements());
+  auto iter_range = findMatchingRange(m_free_ranges, requirements, NO_BLOCK);
   
   // found matching range
   if (iter_range != m_free_ranges.end()) {
-    auto offset_align = requirements.alignment * vk::DeviceSize(std::ceil(float(iter_range->offset) / float(requirements.alignment)));
-    addResource(resource, range_t{iter_range->block, offset_align, requirements.size});
-    // object ends at end of range
-    if (requirements.size + offset_align == iter_range->size + iter_range->offset) {
-      // offset matches exactly, no more free space
-      if (offset_align == iter_range->offset) {
-        m_free_ranges.erase(iter_range);
-      }
-      else {
-        iter_range->size = offset_align - iter_range->offset;
-      }
-    }
-    // free space at end of range
-    else {
-      // free space in front of object
-      if (offset_align != iter_range->offset) {
-        // store free front space
-        m_free_ranges.emplace_back(iter_range->block, iter_range->offset, offset_align - iter_range->offset);
-      }
-      // remaining size
-      iter_range->size = (iter_range->size + iter_range->offset) - (offset_align + requirements.size);
-      // new offset
-      iter_range->offset = offset_align + requirements.size;
-    }
+    auto offset_align = align_offset(iter_range->offset, requirements.alignment);
+    addResource(resource, range_t{iter_range->block, offset_align, requirements.size, requirements.alignment});
+    claimRange(m_free_ranges, iter_range, offset_align, requirements.size);
     // std::cout << resource.handle() << " allocating range " << iter_range->block << ": " << offset_align << " - " << offset_align + requirements.size << std::endl;
   }
   else {
-    addBlock();
-    addResource(resource, range_t{uint32_t(m_blocks.size()) - 1, 0, requirements.size});
+    auto idx_block = addBlock();
+    addResource(resource, range_t{idx_block, 0, requirements.size, requirements.alignment});
     // update newly added free range
     m_free_ranges.back().offset = requirements.size;
     m_free_ranges.back().size -= requirements.size;
-    // std::cout << resource.handle() << " allocating new range " << m_blocks.size() - 1 << ": " << 0 << " - " << requirements.size << std::endl;
+    if (m_free_ranges.back().size == 0) {
+      m_free_ranges.pop_back();
+    }
+    // std::cout << resource.handle() << " allocating new range " << idx_block << ": " << 0 << " - " << requirements.size << std::endl;
   }
 }
 
@@ -141,6 +178,8 @@ void BlockAllocator::free(MemoryResource& resource) {
   iterator_t iter_range_l = m_free_ranges.end();
   iterator_t iter_range_r = m_free_ranges.end();
   for (auto iter_range = m_free_ranges.begin(); iter_range != m_free_ranges.end(); ++iter_range) {
+    // only merge with ranges in same block
+    if (iter_range->block != range_object.block) continue;
     if (iter_range->offset == range_object.offset + range_object.size) {
       iter_range_r = iter_range;
       if (iter_range_l != m_free_ranges.end()) break;
@@ -171,6 +210,7 @@ void BlockAllocator::free(MemoryResource& resource) {
     m_free_ranges.emplace_back(range_object);
   }
   // remove object from used list
+  m_bytes_used -= range_object.size;
   m_used_ranges.erase(iter_object);
 }
 
@@ -183,8 +223,119 @@ uint8_t* BlockAllocator::map(MemoryResource& resource) {
   // map block if not yet mapped
   uint32_t idx_block = iter_object->second.block; 
   if (m_ptrs[idx_block] == nullptr) {
-    m_ptrs[idx_block] = (uint8_t*)std::next(m_blocks.begin(), idx_block)->map(m_block_bytes, 0);
+    m_ptrs[idx_block] = m_backend->map(m_blocks[idx_block], m_block_bytes, 0);
   }
 
   return m_ptrs[idx_block] + iter_object->second.offset;
 }
+
+std::size_t BlockAllocator::numBlocks() const {
+  return std::size_t(std::count_if(m_blocks.begin(), m_blocks.end(), [](vk::DeviceMemory const& block) {
+    return bool(block);
+  }));
+}
+
+vk::DeviceSize BlockAllocator::bytesReserved() const {
+  return vk::DeviceSize(numBlocks()) * m_block_bytes;
+}
+
+vk::DeviceSize BlockAllocator::bytesUsed() const {
+  return m_bytes_used;
+}
+
+vk::DeviceSize BlockAllocator::largestFreeRange() const {
+  vk::DeviceSize largest = 0;
+  for (auto const& range : m_free_ranges) {
+    largest = std::max(largest, range.size);
+  }
+  return largest;
+}
+
+std::vector<res_handle_t> BlockAllocator::relocationCandidates() const {
+  std::vector<vk::DeviceSize> bytes_block(m_blocks.size(), 0);
+  for (auto const& pair_range : m_used_ranges) {
+    bytes_block[pair_range.second.block] += pair_range.second.size;
+  }
+  // find least occupied block which is not empty
+  uint32_t block_src = NO_BLOCK;
+  for (uint32_t idx_block = 0; idx_block < m_blocks.size(); ++idx_block) {
+    if (bytes_block[idx_block] == 0) continue;
+    if (block_src == NO_BLOCK || bytes_block[idx_block] < bytes_block[block_src]) {
+      block_src = idx_block;
+    }
+  }
+  if (block_src == NO_BLOCK) return {};
+  // keep half a block of slack so that evacuation does not cause a new block right away
+  vk::DeviceSize bytes_free_other = 0;
+  for (auto const& range : m_free_ranges) {
+    if (range.block != block_src) {
+      bytes_free_other += range.size;
+    }
+  }
+  if (bytes_free_other < bytes_block[block_src] + m_block_bytes / 2) return {};
+
+  std::vector<std::pair<res_handle_t, range_t>> ranges_src{};
+  for (auto const& pair_range : m_used_ranges) {
+    if (pair_range.second.block == block_src) {
+      ranges_src.emplace_back(pair_range);
+    }
+  }
+  // place largest first, in the same order as they will be allocated
+  std::sort(ranges_src.begin(), ranges_src.end(), [](std::pair<res_handle_t, range_t> const& a, std::pair<res_handle_t, range_t> const& b) {
+    return a.second.size > b.second.size;
+  });
+  // only worth moving if block can be emptied
+  auto ranges_free = m_free_ranges;
+  for (auto const& pair_range : ranges_src) {
+    vk::MemoryRequirements requirements{};
+    requirements.size = pair_range.second.size;
+    requirements.alignment = pair_range.second.alignment;
+    auto iter_range = findMatchingRange(ranges_free, requirements, block_src);
+    if (iter_range == ranges_free.end()) return {};
+    claimRange(ranges_free, iter_range, align_offset(iter_range->offset, requirements.alignment), requirements.size);
+  }
+
+  std::vector<res_handle_t> candidates{};
+  for (auto const& pair_range : ranges_src) {
+    candidates.emplace_back(pair_range.first);
+  }
+  return candidates;
+}
+
+bool BlockAllocator::allocateElsewhere(MemoryResource& resource, MemoryResource const& previous) {
+  auto iter_previous = m_used_ranges.find(res_handle_t{previous.handle()});
+  if (iter_previous == m_used_ranges.end()) {
+    throw std::runtime_error{"resource not found"};
+  }
+  auto const& requirements = resource.requirements();
+  auto iter_range = findMatchingRange(m_free_ranges, requirements, iter_previous->second.block);
+  if (iter_range == m_free_ranges.end()) return false;
+
+  auto offset_align = align_offset(iter_range->offset, requirements.alignment);
+  addResource(resource, range_t{iter_range->block, offset_align, requirements.size, requirements.alignment});
+  claimRange(m_free_ranges, iter_range, offset_align, requirements.size);
+  return true;
+}
+
+vk::DeviceSize BlockAllocator::releaseEmptyBlocks() {
+  std::vector<bool> used(m_blocks.size(), false);
+  for (auto const& pair_range : m_used_ranges) {
+    used[pair_range.second.block] = true;
+  }
+
+  vk::DeviceSize bytes_freed = 0;
+  for (uint32_t idx_block = 0; idx_block < m_blocks.size(); ++idx_block) {
+    if (used[idx_block] || !m_blocks[idx_block]) continue;
+    if (m_ptrs[idx_block] != nullptr) {
+      m_backend->unmap(m_blocks[idx_block]);
+      m_ptrs[idx_block] = nullptr;
+    }
+    m_backend->free(m_blocks[idx_block]);
+    m_blocks[idx_block] = vk::DeviceMemory{};
+    m_free_ranges.remove_if([idx_block](range_t const& range) {
+      return range.block == idx_block;
+    });
+    bytes_freed += m_block_bytes;
+  }
+  return bytes_freed;
+}
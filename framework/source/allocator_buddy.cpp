@@ -0,0 +1,262 @@
+#include "allocator_buddy.hpp"
+
+#include "memory_backend.hpp"
+#include "wrap/device.hpp"
+#include "wrap/memory_resource.hpp"
+
+#include <algorithm>
+
+// smallest order with 2^order >= size
+static uint32_t order_of(vk::DeviceSize size) {
+  uint32_t order = 0;
+  while ((vk::DeviceSize{1} << order) < size) {
+    ++order;
+  }
+  return order;
+}
+
+BuddyAllocator::BuddyAllocator()
+ :Allocator{}
+ ,m_order_min{0}
+ ,m_order_max{0}
+ ,m_bytes_used{0}
+ ,m_bytes_allocated{0}
+ ,m_blocks{}
+ ,m_free_ranges{}
+ ,m_used_ranges{}
+ ,m_dedicated{}
+ ,m_ptrs{}
+{}
+
+BuddyAllocator::BuddyAllocator(Device const& device, uint32_t type_index, vk::DeviceSize block_bytes, vk::DeviceSize min_bytes)
+ :Allocator{device, type_index}
+ ,m_order_min{order_of(min_bytes)}
+ ,m_order_max{order_of(block_bytes)}
+ ,m_bytes_used{0}
+ ,m_bytes_allocated{0}
+ ,m_blocks{}
+ ,m_free_ranges{}
+ ,m_used_ranges{}
+ ,m_dedicated{}
+ ,m_ptrs{}
+{}
+
+BuddyAllocator::BuddyAllocator(std::shared_ptr<MemoryBackend> const& backend, uint32_t type_index, vk::DeviceSize block_bytes, vk::DeviceSize min_bytes)
+ :Allocator{backend, type_index}
+ ,m_order_min{order_of(min_bytes)}
+ ,m_order_max{order_of(block_bytes)}
+ ,m_bytes_used{0}
+ ,m_bytes_allocated{0}
+ ,m_blocks{}
+ ,m_free_ranges{}
+ ,m_used_ranges{}
+ ,m_dedicated{}
+ ,m_ptrs{}
+{}
+
+BuddyAllocator::BuddyAllocator(BuddyAllocator && rhs)
+ :BuddyAllocator{}
+{
+  swap(rhs);
+}
+
+BuddyAllocator::~BuddyAllocator() {
+  for(size_t idx_block = 0; idx_block < m_blocks.size(); ++idx_block) {
+    if (m_ptrs[idx_block] != nullptr) {
+      m_backend->unmap(m_blocks[idx_block]);
+    }
+    m_backend->free(m_blocks[idx_block]);
+  }
+  for(auto const& pair_dedicated : m_dedicated) {
+    if (pair_dedicated.second.ptr != nullptr) {
+      m_backend->unmap(pair_dedicated.second.memory);
+    }
+    m_backend->free(pair_dedicated.second.memory);
+  }
+}
+
+BuddyAllocator& BuddyAllocator::operator=(BuddyAllocator&& rhs) {
+  swap(rhs);
+  return *this;
+}
+
+void BuddyAllocator::swap(BuddyAllocator& rhs) {
+  Allocator::swap(rhs);
+  std::swap(m_order_min, rhs.m_order_min);
+  std::swap(m_order_max, rhs.m_order_max);
+  std::swap(m_bytes_used, rhs.m_bytes_used);
+  std::swap(m_bytes_allocated, rhs.m_bytes_allocated);
+  std::swap(m_blocks, rhs.m_blocks);
+  std::swap(m_free_ranges, rhs.m_free_ranges);
+  std::swap(m_used_ranges, rhs.m_used_ranges);
+  std::swap(m_dedicated, rhs.m_dedicated);
+  std::swap(m_ptrs, rhs.m_ptrs);
+}
+
+void BuddyAllocator::addBlock() {
+  m_blocks.emplace_back(m_backend->allocate(m_type_index, vk::DeviceSize{1} << m_order_max));
+  m_ptrs.emplace_back(nullptr);
+  // whole block is one free range of maximal order
+  m_free_ranges.emplace_back(std::vector<std::set<vk::DeviceSize>>(m_order_max + 1));
+  m_free_ranges.back()[m_order_max].emplace(0);
+}
+
+bool BuddyAllocator::findRange(uint32_t order, uint32_t& block, vk::DeviceSize& offset) {
+  // prefer smallest range to keep large ones intact
+  for (uint32_t order_range = order; order_range <= m_order_max; ++order_range) {
+    for (uint32_t idx_block = 0; idx_block < m_blocks.size(); ++idx_block) {
+      auto& ranges = m_free_ranges[idx_block][order_range];
+      if (ranges.empty()) continue;
+
+      block = idx_block;
+      offset = *ranges.begin();
+      ranges.erase(ranges.begin());
+      // split until requested order is reached, keep upper halves free
+      for (uint32_t order_split = order_range; order_split > order; --order_split) {
+        m_free_ranges[idx_block][order_split - 1].emplace(offset + (vk::DeviceSize{1} << (order_split - 1)));
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+void BuddyAllocator::allocateDedicated(MemoryResource& resource) {
+  auto const& requirements = resource.requirements();
+  auto memory = m_backend->allocate(m_type_index, requirements.size);
+  resource.bindTo(memory, 0);
+  resource.setAllocator(*this);
+  m_dedicated.emplace(res_handle_t{resource.handle()}, dedicated_t{memory, requirements.size, nullptr});
+  m_bytes_used += requirements.size;
+  m_bytes_allocated += requirements.size;
+}
+
+void BuddyAllocator::allocate(MemoryResource& resource) {
+  auto const& requirements = resource.requirements();
+  // check if block supports requirements
+  if (!index_matches_filter(m_type_index, requirements.memoryTypeBits)) {
+    throw std::runtime_error{"allocator memory type not suitable for object"};
+  }
+  // buddy offsets are aligned to their size
+  auto order = std::max(m_order_min, std::max(order_of(requirements.size), order_of(requirements.alignment)));
+  // larger than half a block, would take a whole block and waste up to half of it
+  // exactly half a block still fits a buddy without waste
+  if (order >= m_order_max) {
+    allocateDedicated(resource);
+    return;
+  }
+
+  uint32_t block = 0;
+  vk::DeviceSize offset = 0;
+  if (!findRange(order, block, offset)) {
+    addBlock();
+    findRange(order, block, offset);
+  }
+
+  resource.bindTo(m_blocks[block], offset);
+  resource.setAllocator(*this);
+  m_used_ranges.emplace(res_handle_t{resource.handle()}, range_t{block, offset, order, requirements.size});
+  m_bytes_used += requirements.size;
+  m_bytes_allocated += vk::DeviceSize{1} << order;
+}
+
+void BuddyAllocator::free(MemoryResource& resource) {
+  auto handle = res_handle_t{resource.handle()};
+  auto iter_dedicated = m_dedicated.find(handle);
+  if (iter_dedicated != m_dedicated.end()) {
+    if (iter_dedicated->second.ptr != nullptr) {
+      m_backend->unmap(iter_dedicated->second.memory);
+    }
+    m_backend->free(iter_dedicated->second.memory);
+    m_bytes_used -= iter_dedicated->second.size;
+    m_bytes_allocated -= iter_dedicated->second.size;
+    m_dedicated.erase(iter_dedicated);
+    return;
+  }
+
+  auto iter_object = m_used_ranges.find(handle);
+  if (iter_object == m_used_ranges.end()) {
+    throw std::runtime_error{"resource not found"};
+  }
+  auto const& range = iter_object->second;
+  auto& ranges_block = m_free_ranges[range.block];
+  auto offset = range.offset;
+  auto order = range.order;
+  // merge with free buddies
+  while (order < m_order_max) {
+    auto offset_buddy = offset ^ (vk::DeviceSize{1} << order);
+    if (ranges_block[order].erase(offset_buddy) == 0) break;
+    offset = std::min(offset, offset_buddy);
+    ++order;
+  }
+  ranges_block[order].emplace(offset);
+
+  m_bytes_used -= range.size;
+  m_bytes_allocated -= vk::DeviceSize{1} << range.order;
+  m_used_ranges.erase(iter_object);
+}
+
+uint8_t* BuddyAllocator::map(MemoryResource& resource) {
+  auto handle = res_handle_t{resource.handle()};
+  auto iter_dedicated = m_dedicated.find(handle);
+  if (iter_dedicated != m_dedicated.end()) {
+    auto& dedicated = iter_dedicated->second;
+    if (dedicated.ptr == nullptr) {
+      dedicated.ptr = m_backend->map(dedicated.memory, dedicated.size, 0);
+    }
+    return dedicated.ptr;
+  }
+
+  auto iter_object = m_used_ranges.find(handle);
+  if (iter_object == m_used_ranges.end()) {
+    throw std::runtime_error{"resource not found"};
+  }
+  // map block if not yet mapped
+  uint32_t idx_block = iter_object->second.block;
+  if (m_ptrs[idx_block] == nullptr) {
+    m_ptrs[idx_block] = m_backend->map(m_blocks[idx_block], vk::DeviceSize{1} << m_order_max, 0);
+  }
+
+  return m_ptrs[idx_block] + iter_object->second.offset;
+}
+
+std::size_t BuddyAllocator::numBlocks() const {
+  return m_blocks.size() + m_dedicated.size();
+}
+
+vk::DeviceSize BuddyAllocator::bytesReserved() const {
+  vk::DeviceSize bytes = vk::DeviceSize(m_blocks.size()) << m_order_max;
+  for (auto const& pair_dedicated : m_dedicated) {
+    bytes += pair_dedicated.second.size;
+  }
+  return bytes;
+}
+
+vk::DeviceSize BuddyAllocator::bytesUsed() const {
+  return m_bytes_used;
+}
+
+vk::DeviceSize BuddyAllocator::largestFreeRange() const {
+  uint32_t order_largest = 0;
+  bool found = false;
+  for (auto const& ranges_block : m_free_ranges) {
+    for (uint32_t order = m_order_max + 1; order > 0; --order) {
+      if (!ranges_block[order - 1].empty()) {
+        if (!found || order - 1 > order_largest) {
+          order_largest = order - 1;
+          found = true;
+        }
+        break;
+      }
+    }
+  }
+  return found ? vk::DeviceSize{1} << order_largest : 0;
+}
+
+vk::DeviceSize BuddyAllocator::bytesOverhead() const {
+  return m_bytes_allocated - m_bytes_used;
+}
+
+std::size_t BuddyAllocator::numDedicated() const {
+  return m_dedicated.size();
+}
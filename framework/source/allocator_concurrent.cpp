@@ -0,0 +1,380 @@
+#include "allocator_concurrent.hpp"
+
+#include "wrap/device.hpp"
+#include "wrap/memory_resource.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+// unique per allocator instance, addresses may be reused
+static uint64_t next_id() {
+  static std::atomic<uint64_t> counter{1};
+  return counter++;
+}
+
+// chunks have no vulkan object, the shared allocator still needs a distinct handle
+static VkBuffer next_chunk_handle() {
+  static std::atomic<uint64_t> counter{1};
+  return (VkBuffer)(counter++);
+}
+
+ConcurrentAllocator::chunk_resource_t::chunk_resource_t(vk::MemoryRequirements const& requirements)
+ :MemoryResource{}
+ ,m_requirements{requirements}
+ ,m_handle{next_chunk_handle()}
+ ,m_memory{}
+ ,m_offset{0}
+{}
+
+ConcurrentAllocator::chunk_resource_t::~chunk_resource_t() {
+  free();
+}
+
+void ConcurrentAllocator::chunk_resource_t::bindTo(vk::DeviceMemory const& memory, vk::DeviceSize const& offset) {
+  m_memory = memory;
+  m_offset = offset;
+}
+
+vk::MemoryRequirements ConcurrentAllocator::chunk_resource_t::requirements() const {
+  return m_requirements;
+}
+
+res_handle_t ConcurrentAllocator::chunk_resource_t::handle() const {
+  return res_handle_t{m_handle};
+}
+
+vk::DeviceMemory const& ConcurrentAllocator::chunk_resource_t::memory() const {
+  return m_memory;
+}
+
+vk::DeviceSize ConcurrentAllocator::chunk_resource_t::offset() const {
+  return m_offset;
+}
+
+ConcurrentAllocator::chunk_t::chunk_t(vk::MemoryRequirements const& requirements)
+ :resource{requirements}
+ ,ptr{nullptr}
+ ,free_ranges{}
+ ,free_sizes{}
+ ,bytes_used{0}
+{
+  addRange(0, requirements.size);
+}
+
+void ConcurrentAllocator::chunk_t::addRange(vk::DeviceSize offset, vk::DeviceSize size) {
+  free_ranges.emplace(offset, size);
+  free_sizes.emplace(size, offset);
+}
+
+void ConcurrentAllocator::chunk_t::removeRange(std::map<vk::DeviceSize, vk::DeviceSize>::iterator iter_range) {
+  auto range_sizes = free_sizes.equal_range(iter_range->second);
+  for (auto iter_size = range_sizes.first; iter_size != range_sizes.second; ++iter_size) {
+    if (iter_size->second == iter_range->first) {
+      free_sizes.erase(iter_size);
+      break;
+    }
+  }
+  free_ranges.erase(iter_range);
+}
+
+ConcurrentAllocator::ConcurrentAllocator()
+ :Allocator{}
+ ,m_id{next_id()}
+ ,m_allocator{}
+ ,m_chunk_bytes{0}
+ ,m_caches{}
+ ,m_mutex_shared{}
+ ,m_mutex_caches{}
+ ,m_bytes_used{0}
+ ,m_num_locks{0}
+ ,m_num_contended{0}
+ ,m_ns_contended{0}
+{}
+
+ConcurrentAllocator::ConcurrentAllocator(std::unique_ptr<Allocator>&& allocator, vk::DeviceSize chunk_bytes)
+ :ConcurrentAllocator{}
+{
+  m_allocator = std::move(allocator);
+  m_chunk_bytes = chunk_bytes;
+  m_type_index = m_allocator->typeIndex();
+}
+
+ConcurrentAllocator::ConcurrentAllocator(ConcurrentAllocator && rhs)
+ :ConcurrentAllocator{}
+{
+  swap(rhs);
+}
+
+ConcurrentAllocator::~ConcurrentAllocator() {
+  // chunks must be returned before shared allocator is destroyed
+  m_caches.clear();
+}
+
+ConcurrentAllocator& ConcurrentAllocator::operator=(ConcurrentAllocator&& rhs) {
+  swap(rhs);
+  return *this;
+}
+
+void ConcurrentAllocator::swap(ConcurrentAllocator& rhs) {
+  Allocator::swap(rhs);
+  // keeps per-thread lookups of caches valid
+  std::swap(m_id, rhs.m_id);
+  std::swap(m_allocator, rhs.m_allocator);
+  std::swap(m_chunk_bytes, rhs.m_chunk_bytes);
+  std::swap(m_caches, rhs.m_caches);
+  // atomics are not swappable
+  m_bytes_used = rhs.m_bytes_used.exchange(m_bytes_used);
+  m_num_locks = rhs.m_num_locks.exchange(m_num_locks);
+  m_num_contended = rhs.m_num_contended.exchange(m_num_contended);
+  m_ns_contended = rhs.m_ns_contended.exchange(m_ns_contended);
+}
+
+std::unique_lock<std::mutex> ConcurrentAllocator::lock(std::mutex& mutex) const {
+  std::unique_lock<std::mutex> lock{mutex, std::try_to_lock};
+  if (&mutex == &m_mutex_shared) {
+    ++m_num_locks;
+  }
+  if (!lock.owns_lock()) {
+    ++m_num_contended;
+    auto start = std::chrono::steady_clock::now();
+    lock.lock();
+    m_ns_contended += uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+  }
+  return lock;
+}
+
+bool ConcurrentAllocator::isShared(vk::MemoryRequirements const& requirements) const {
+  return requirements.size > m_chunk_bytes / 4;
+}
+
+ConcurrentAllocator::cache_t& ConcurrentAllocator::threadCache() {
+  // avoid taking the cache map lock on every operation
+  thread_local std::map<uint64_t, cache_t*> caches_thread{};
+  auto& cache_thread = caches_thread[m_id];
+  if (cache_thread) return *cache_thread;
+
+  auto lock_caches = lock(m_mutex_caches);
+  auto& cache = m_caches[std::this_thread::get_id()];
+  if (!cache) {
+    cache = std::unique_ptr<cache_t>{new cache_t{}};
+  }
+  cache_thread = cache.get();
+  return *cache;
+}
+
+bool ConcurrentAllocator::claimRange(chunk_t& chunk, vk::MemoryRequirements const& requirements, vk::DeviceSize& offset) {
+  // alignment must hold for offset in memory, not in chunk
+  auto offset_chunk = chunk.resource.offset();
+  // smallest range first, larger ones only if alignment padding does not fit
+  for (auto iter_size = chunk.free_sizes.lower_bound(requirements.size); iter_size != chunk.free_sizes.end(); ++iter_size) {
+    auto offset_range = iter_size->second;
+    auto end_range = iter_size->second + iter_size->first;
+    offset = align_offset(offset_chunk + offset_range, requirements.alignment) - offset_chunk;
+    if (offset + requirements.size > end_range) continue;
+
+    chunk.removeRange(chunk.free_ranges.find(offset_range));
+    if (offset > offset_range) {
+      chunk.addRange(offset_range, offset - offset_range);
+    }
+    if (offset + requirements.size < end_range) {
+      chunk.addRange(offset + requirements.size, end_range - offset - requirements.size);
+    }
+    chunk.bytes_used += requirements.size;
+    return true;
+  }
+  return false;
+}
+
+void ConcurrentAllocator::allocate(MemoryResource& resource) {
+  auto const& requirements = resource.requirements();
+  if (!index_matches_filter(m_type_index, requirements.memoryTypeBits)) {
+    throw std::runtime_error{"allocator memory type not suitable for object"};
+  }
+  if (isShared(requirements)) {
+    auto lock_shared = lock(m_mutex_shared);
+    m_allocator->allocate(resource);
+    // route freeing through this allocator to take the lock
+    resource.setAllocator(*this);
+    m_bytes_used += requirements.size;
+    return;
+  }
+
+  auto& cache = threadCache();
+  auto lock_cache = lock(cache.mutex);
+  vk::DeviceSize offset = 0;
+  chunk_t* chunk = nullptr;
+  for (auto& chunk_cache : cache.chunks) {
+    if (claimRange(chunk_cache, requirements, offset)) {
+      chunk = &chunk_cache;
+      break;
+    }
+  }
+  // no chunk with enough space, get new one from shared allocator
+  if (!chunk) {
+    vk::MemoryRequirements reqs_chunk{};
+    reqs_chunk.size = m_chunk_bytes;
+    reqs_chunk.alignment = std::max(requirements.alignment, vk::DeviceSize{256});
+    reqs_chunk.memoryTypeBits = 1u << m_type_index;
+    cache.chunks.emplace_back(reqs_chunk);
+    try {
+      auto lock_shared = lock(m_mutex_shared);
+      m_allocator->allocate(cache.chunks.back().resource);
+    }
+    catch (...) {
+      cache.chunks.pop_back();
+      throw;
+    }
+    chunk = &cache.chunks.back();
+    claimRange(*chunk, requirements, offset);
+  }
+
+  resource.bindTo(chunk->resource.memory(), chunk->resource.offset() + offset);
+  resource.setAllocator(*this);
+  cache.used_ranges.emplace(res_handle_t{resource.handle()}, range_t{chunk, offset, requirements.size});
+  m_bytes_used += requirements.size;
+}
+
+void ConcurrentAllocator::releaseRange(cache_t& cache, std::map<res_handle_t, range_t>::iterator iter_range) {
+  auto range = iter_range->second;
+  cache.used_ranges.erase(iter_range);
+  auto& chunk = *range.chunk;
+  // merge with neighbouring free ranges
+  auto offset = range.offset;
+  auto size = range.size;
+  auto iter_next = chunk.free_ranges.lower_bound(offset);
+  if (iter_next != chunk.free_ranges.begin()) {
+    auto iter_prev = std::prev(iter_next);
+    if (iter_prev->first + iter_prev->second == offset) {
+      offset = iter_prev->first;
+      size += iter_prev->second;
+      chunk.removeRange(iter_prev);
+    }
+  }
+  if (iter_next != chunk.free_ranges.end() && iter_next->first == range.offset + range.size) {
+    size += iter_next->second;
+    chunk.removeRange(iter_next);
+  }
+  chunk.addRange(offset, size);
+  chunk.bytes_used -= range.size;
+  m_bytes_used -= range.size;
+
+  // return empty chunks, but keep one for the next allocation
+  if (chunk.bytes_used == 0 && cache.chunks.size() > 1) {
+    auto iter_chunk = std::find_if(cache.chunks.begin(), cache.chunks.end(), [&chunk](chunk_t const& c) { return &c == &chunk; });
+    auto lock_shared = lock(m_mutex_shared);
+    cache.chunks.erase(iter_chunk);
+  }
+}
+
+void ConcurrentAllocator::free(MemoryResource& resource) {
+  auto const& requirements = resource.requirements();
+  if (isShared(requirements)) {
+    auto lock_shared = lock(m_mutex_shared);
+    m_allocator->free(resource);
+    m_bytes_used -= requirements.size;
+    return;
+  }
+
+  auto handle = res_handle_t{resource.handle()};
+  // usually freed by the allocating thread
+  auto& cache_own = threadCache();
+  {
+    auto lock_cache = lock(cache_own.mutex);
+    auto iter_range = cache_own.used_ranges.find(handle);
+    if (iter_range != cache_own.used_ranges.end()) {
+      releaseRange(cache_own, iter_range);
+      return;
+    }
+  }
+
+  auto lock_caches = lock(m_mutex_caches);
+  for (auto& pair_cache : m_caches) {
+    auto& cache = *pair_cache.second;
+    if (&cache == &cache_own) continue;
+    auto lock_cache = lock(cache.mutex);
+    auto iter_range = cache.used_ranges.find(handle);
+    if (iter_range != cache.used_ranges.end()) {
+      releaseRange(cache, iter_range);
+      return;
+    }
+  }
+  throw std::runtime_error{"resource not found"};
+}
+
+uint8_t* ConcurrentAllocator::map(MemoryResource& resource) {
+  if (isShared(resource.requirements())) {
+    auto lock_shared = lock(m_mutex_shared);
+    return m_allocator->map(resource);
+  }
+
+  auto handle = res_handle_t{resource.handle()};
+  auto lock_caches = lock(m_mutex_caches);
+  for (auto& pair_cache : m_caches) {
+    auto& cache = *pair_cache.second;
+    auto lock_cache = lock(cache.mutex);
+    auto iter_range = cache.used_ranges.find(handle);
+    if (iter_range == cache.used_ranges.end()) continue;
+
+    auto& chunk = *iter_range->second.chunk;
+    if (chunk.ptr == nullptr) {
+      auto lock_shared = lock(m_mutex_shared);
+      chunk.ptr = m_allocator->map(chunk.resource);
+    }
+    return chunk.ptr + iter_range->second.offset;
+  }
+  throw std::runtime_error{"resource not found"};
+}
+
+std::size_t ConcurrentAllocator::numBlocks() const {
+  auto lock_shared = lock(m_mutex_shared);
+  return m_allocator->numBlocks();
+}
+
+vk::DeviceSize ConcurrentAllocator::bytesReserved() const {
+  auto lock_shared = lock(m_mutex_shared);
+  return m_allocator->bytesReserved();
+}
+
+vk::DeviceSize ConcurrentAllocator::bytesUsed() const {
+  return m_bytes_used;
+}
+
+vk::DeviceSize ConcurrentAllocator::largestFreeRange() const {
+  vk::DeviceSize largest = 0;
+  {
+    auto lock_shared = lock(m_mutex_shared);
+    largest = m_allocator->largestFreeRange();
+  }
+  auto lock_caches = lock(m_mutex_caches);
+  for (auto const& pair_cache : m_caches) {
+    auto lock_cache = lock(pair_cache.second->mutex);
+    for (auto const& chunk : pair_cache.second->chunks) {
+      for (auto const& range : chunk.free_ranges) {
+        largest = std::max(largest, range.second);
+      }
+    }
+  }
+  return largest;
+}
+
+vk::DeviceSize ConcurrentAllocator::bytesOverhead() const {
+  auto lock_shared = lock(m_mutex_shared);
+  return m_allocator->bytesOverhead();
+}
+
+std::size_t ConcurrentAllocator::numThreads() const {
+  auto lock_caches = lock(m_mutex_caches);
+  return m_caches.size();
+}
+
+uint64_t ConcurrentAllocator::numLocks() const {
+  return m_num_locks;
+}
+
+uint64_t ConcurrentAllocator::numContended() const {
+  return m_num_contended;
+}
+
+double ConcurrentAllocator::timeContended() const {
+  return double(m_ns_contended) / 1000000.0;
+}
@@ -1,13 +1,17 @@
 #include "allocator_static.hpp"
 
+#include "memory_backend.hpp"
 #include "wrap/device.hpp"
 #include "wrap/memory_resource.hpp"
 
-#include <cmath>
+#include <algorithm>
+#include <cassert>
 
 StaticAllocator::StaticAllocator()
  :Allocator{}
  ,m_block_bytes{0}
+ ,m_bytes_used{0}
+ ,m_block{}
  ,m_free_ranges{}
  ,m_used_ranges{}
  ,m_ptr{nullptr}
@@ -16,7 +20,18 @@ StaticAllocator::StaticAllocator()
 StaticAllocator::StaticAllocator(Device const& device, uint32_t type_index, size_t block_bytes)
  :Allocator{device, type_index}
  ,m_block_bytes{block_bytes}
- ,m_block{device, m_type_index, m_block_bytes}
+ ,m_bytes_used{0}
+ ,m_block{m_backend->allocate(m_type_index, m_block_bytes)}
+ ,m_free_ranges(1, range_t{0u, m_block_bytes})
+ ,m_used_ranges{}
+ ,m_ptr{nullptr}
+{}
+
+StaticAllocator::StaticAllocator(std::shared_ptr<MemoryBackend> const& backend, uint32_t type_index, size_t block_bytes)
+ :Allocator{backend, type_index}
+ ,m_block_bytes{block_bytes}
+ ,m_bytes_used{0}
+ ,m_block{m_backend->allocate(m_type_index, m_block_bytes)}
  ,m_free_ranges(1, range_t{0u, m_block_bytes})
  ,m_used_ranges{}
  ,m_ptr{nullptr}
@@ -30,7 +45,10 @@ StaticAllocator::StaticAllocator(StaticAllocator && rhs)
 
 StaticAllocator::~StaticAllocator() {
   if (m_ptr) {
-    m_block.unmap();
+    m_backend->unmap(m_block);
+  }
+  if (m_block) {
+    m_backend->free(m_block);
   }
 }
 
@@ -42,6 +60,7 @@ StaticAllocator& StaticAllocator::operator=(StaticAllocator&& rhs) {
 void StaticAllocator::swap(StaticAllocator& rhs) {
   Allocator::swap(rhs);
   std::swap(m_block_bytes, rhs.m_block_bytes);
+  std::swap(m_bytes_used, rhs.m_bytes_used);
   std::swap(m_block, rhs.m_block);
   std::swap(m_free_ranges, rhs.m_free_ranges);
   std::swap(m_used_ranges, rhs.m_used_ranges);
@@ -49,15 +68,18 @@ void StaticAllocator::swap(StaticAllocator& rhs) {
 }
 
 void StaticAllocator::addResource(MemoryResource& resource, range_t const& range) {
-  resource.bindTo(m_block.get(), range.offset);
+  resource.bindTo(m_block, range.offset);
   resource.setAllocator(*this);
   m_used_ranges.emplace(res_handle_t{resource.handle()}, range);
+  m_bytes_used += range.size;
 }
 
 StaticAllocator::iterator_t StaticAllocator::findMatchingRange(vk::MemoryRequirements const& requirements) {
   for(auto iter_range = m_free_ranges.begin(); iter_range != m_free_ranges.end(); ++iter_range) {
     // round offset to alignment
-    auto offset_align = requirements.alignment * vk::DeviceSize(std::ceil(float(iter_range->offset) / float(requirements.alignment)));
+    auto offset_align = align_offset(iter_range->offset, requirements.alignment);
+    // padding may exceed range
+    if (offset_align - iter_range->offset > iter_range->size) continue;
     if (requirements.size <= iter_range->size - (offset_align - iter_range->offset)) {
       return iter_range;
     }
@@ -79,7 +101,7 @@ void StaticAllocator::allocate(MemoryResource& resource) {
   
   // found matching range
   if (iter_range != m_free_ranges.end()) {
-    auto offset_align = requirements.alignment * vk::DeviceSize(std::ceil(float(iter_range->offset) / float(requirements.alignment)));
+    auto offset_align = align_offset(iter_range->offset, requirements.alignment);
     addResource(resource, range_t{offset_align, requirements.size});
     // object ends at end of range
     if (requirements.size + offset_align == iter_range->size + iter_range->offset) {
@@ -152,13 +174,14 @@ void StaticAllocator::free(MemoryResource& resource) {
     m_free_ranges.emplace_back(range_object);
   }
   // remove object from used list
+  m_bytes_used -= range_object.size;
   m_used_ranges.erase(iter_object);
 }
 
 
 void StaticAllocator::map() {
   assert(!m_ptr);
-  m_ptr = (uint8_t*)m_block.map(m_block_bytes, 0);
+  m_ptr = m_backend->map(m_block, m_block_bytes, 0);
 }
 
 uint8_t* StaticAllocator::map(MemoryResource& resource) {
@@ -172,3 +195,23 @@ uint8_t* StaticAllocator::map(MemoryResource& resource) {
 
   return m_ptr + iter_object->second.offset;
 }
+
+std::size_t StaticAllocator::numBlocks() const {
+  return m_block ? 1 : 0;
+}
+
+vk::DeviceSize StaticAllocator::bytesReserved() const {
+  return m_block_bytes;
+}
+
+vk::DeviceSize StaticAllocator::bytesUsed() const {
+  return m_bytes_used;
+}
+
+vk::DeviceSize StaticAllocator::largestFreeRange() const {
+  vk::DeviceSize largest = 0;
+  for (auto const& range : m_free_ranges) {
+    largest = std::max(largest, range.size);
+  }
+  return largest;
+}
@@ -3,6 +3,7 @@
 
 #include "wrap/submit_info.hpp"
 #include "frame_resource.hpp"
+#include "memory_telemetry.hpp"
 //dont load gl bindings from glfw
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
@@ -11,34 +12,86 @@
 
 cmdline::parser Application::getParser() {
   cmdline::parser cmd_parse{};
+  cmd_parse.add<int>("defrag", 'f', "defragmentation budget in MB per frame, stalls the gpu when resources move, 0 - disabled", false, 0, cmdline::range(0, 1024));
+  cmd_parse.add<int>("frames", 'n', "frames in flight, more increase throughput and latency, 0 - default of app", false, 0, cmdline::range(0, 16));
+  cmd_parse.add("timeline", 's', "synchronise frames with timeline semaphores instead of fences, if supported");
+  cmd_parse.add<int>("report", 'o', "print time percentiles of the last n seconds, 0 - only at exit", false, 0, cmdline::range(0, 3600));
   return cmd_parse;
 }
 
+uint32_t Application::numFrames(cmdline::parser const& cmd_parse, uint32_t num_default) {
+  auto num_frames = cmd_parse.get<int>("frames");
+  return num_frames > 0 ? uint32_t(num_frames) : num_default;
+}
+
 Application::Application(std::string const& resource_path, Device& device, uint32_t num_frames, cmdline::parser const& cmd_parse)
  :m_device(device)
  ,m_pipeline_cache{m_device}
+ ,m_telemetry{m_statistics}
+ ,m_pacer{}
+ ,m_jobs{JobSystem::numHardwareWorkers()}
  ,m_resource_path{resource_path}
  ,m_resolution{0,0}
+ ,m_defrag_budget{vk::DeviceSize(cmd_parse.get<int>("defrag")) * 1024 * 1024}
+ ,m_report_interval{double(cmd_parse.get<int>("report")) * 1000.0}
+ ,m_timer_report{}
 {
   // cannot initialize in lst, otherwise deleted copy constructor is invoked
   m_frame_resources.resize(num_frames);
   createMemoryPools();
   createCommandPools();
+  if (cmd_parse.exist("timeline")) {
+    if (m_device.supportsTimeline()) {
+      std::cout << "using timeline semaphores" << std::endl;
+      m_timelines.emplace("graphics", TimelineSemaphore{m_device});
+      m_timelines.emplace("transfer", TimelineSemaphore{m_device});
+    }
+    else {
+      std::cout << "timeline semaphores not supported, using fences" << std::endl;
+    }
+  }
 
   m_transferrer = Transferrer{m_device, m_command_pools.at("transfer")};
+
+  m_statistics.addTimer("frame");
+  m_statistics.addAverager("frame_latency");
+  m_statistics.addAverager("pacing_delay");
+  m_timer_report.start();
+}
+
+Application::~Application() {
+  std::cout << std::endl;
+  std::cout << "Frames in flight: " << m_frame_resources.size() << std::endl;
+  auto frame = m_statistics.summary("frame");
+  std::cout << "Frame time: " << frame.mean << " milliseconds, deviation " << frame.deviation << std::endl;
+  std::cout << "Frame time percentiles: p50 " << frame.p50 << ", p95 " << frame.p95 << ", p99 " << frame.p99 << " milliseconds" << std::endl;
+  if (m_pacer.enabled()) {
+    std::cout << "Pacing delay: " << m_statistics.get("pacing_delay") << " milliseconds" << std::endl;
+  }
+  std::cout << "Frame latency: " << m_statistics.get("frame_latency") << " milliseconds, max " << m_statistics.max("frame_latency") << std::endl;
+  std::cout << "Memory statistics, sizes in MB, average and high-water mark:" << std::endl;
+  m_statistics.print(std::cout, "mem_");
 }
 
 FrameResource Application::createFrameResource() {
   auto res = FrameResource{m_device};
   res.addFence("draw");
+  if (!m_timelines.empty()) {
+    res.addTimeline("draw", m_timelines.at("graphics"));
+  }
   res.setCommandBuffer("primary", std::move(m_command_pools.at("graphics").createBuffer(vk::CommandBufferLevel::ePrimary)));
   // record once to prevent validation error when not recorded later
-  res.commandBuffer("primary")->begin(vk::CommandBufferBeginInfo{});
-  res.commandBuffer("primary")->end();
+  res.commandBuffer(frame_handles::primary)->begin(vk::CommandBufferBeginInfo{});
+  res.commandBuffer(frame_handles::primary)->end();
   return res;
 }
 
 void Application::frame() {
+  m_statistics.start(frame_handles::frame);
+  // wait before input is sampled, so that it is more recent when the frame is shown
+  if (m_pacer.enabled()) {
+    m_statistics.add(frame_handles::pacing_delay, m_pacer.wait());
+  }
   // callback
   onFrameBegin();
   // do logic
@@ -47,17 +100,73 @@ void Application::frame() {
   render();
   // callback
   onFrameEnd();
+  if (m_defrag_budget > 0) {
+    defragment(m_defrag_budget);
+  }
+  recordMemoryStatistics();
+  m_jobs.recordStatistics(m_statistics);
+  m_pacer.frameEnd();
+  m_statistics.stop(frame_handles::frame);
+  if (m_report_interval > 0.0 && m_timer_report.durationEnd() >= m_report_interval) {
+    report();
+    m_timer_report.start();
+  }
+}
+
+void Application::report() {
+  auto summaries = m_statistics.snapshot();
+  m_statistics.reset();
+  std::cout << "Time percentiles in milliseconds:" << std::endl;
+  for (auto const& pair_summary : summaries) {
+    // memory is reported at exit
+    if (pair_summary.first.compare(0, 4, "mem_") == 0) continue;
+    auto const& summary = pair_summary.second;
+    std::cout << pair_summary.first << ": p50 " << summary.p50 << ", p95 " << summary.p95 << ", p99 " << summary.p99 << ", max " << summary.max << std::endl;
+  }
+}
+
+void Application::recordMemoryStatistics() {
+  for (auto const& pair_alloc : m_allocators) {
+    m_telemetry.record(pair_alloc.first, pair_alloc.second);
+  }
+  m_telemetry.recordHeaps(m_device);
 }
 
 SubmitInfo Application::createDrawSubmitInfo(FrameResource const& res) const {
   SubmitInfo info{};
-  info.addCommandBuffer(res.command_buffers.at("primary").get());
+  info.addCommandBuffer(res.command_buffers.at(frame_handles::primary).get());
   return info;
 }
 
+void Application::recordLatency(Timer& timer_latency) {
+  m_statistics.add(frame_handles::frame_latency, timer_latency.durationEnd());
+}
+
+void Application::stopWait(std::string const& name) {
+  auto duration = m_statistics.stopValue(name);
+  m_statistics.add(name, duration);
+  m_pacer.addBlocked(duration);
+}
+
+void Application::stopWait(Handle const& handle) {
+  auto duration = m_statistics.stopValue(handle);
+  m_statistics.add(handle, duration);
+  m_pacer.addBlocked(duration);
+}
+
 void Application::submitDraw(FrameResource& res) {
-  res.fence("draw").reset();
-  m_device.getQueue("graphics").submit({createDrawSubmitInfo(res).get()}, res.fence("draw"));
+  submitCompute(res);
+  auto info = createDrawSubmitInfo(res);
+  if (res.hasTimeline(frame_handles::draw)) {
+    auto& point = res.timeline(frame_handles::draw);
+    point.value = point.semaphore->next();
+    info.addSignalSemaphore(point.semaphore->get(), point.value);
+    m_device.getQueue(frame_handles::graphics).submit({info.get()}, nullptr);
+  }
+  else {
+    res.fence(frame_handles::draw).reset();
+    m_device.getQueue(frame_handles::graphics).submit({info.get()}, res.fence(frame_handles::draw));
+  }
 }
 
 // workaround to prevent having to store number of frames as extra member
@@ -79,6 +188,7 @@ void Application::updateShaderPrograms() {
 
 void Application::updateFrameResources() {
   for (auto& res : m_frame_resources) {
+    res.invalidateRecorded();
     updateResourceDescriptors(res);
     updateResourceCommandBuffers(res);
   }
@@ -114,6 +224,98 @@ void Application::createRenderResources() {
   updateFrameResources();
 }
 
+vk::DeviceSize Application::defragment(vk::DeviceSize budget) {
+  // replacements are bound before the gpu is stalled
+  std::vector<std::pair<Buffer*, Buffer>> buffers_moved{};
+  std::vector<std::pair<BackedImage*, BackedImage>> images_moved{};
+  vk::DeviceSize bytes_moved = 0;
+  for (auto& pair_alloc : m_allocators) {
+    auto& allocator = pair_alloc.second;
+    auto candidates = allocator.relocationCandidates();
+    // block can only be emptied if all resources in it can be moved
+    std::vector<Buffer*> buffers{};
+    std::vector<BackedImage*> images{};
+    for (auto const& handle : candidates) {
+      for (auto& pair_buffer : m_buffers) {
+        if (pair_buffer.second.handle() != handle) continue;
+        // content is copied on the gpu
+        auto usage = pair_buffer.second.info().usage;
+        if ((usage & vk::BufferUsageFlagBits::eTransferSrc) && (usage & vk::BufferUsageFlagBits::eTransferDst)) {
+          buffers.emplace_back(&pair_buffer.second);
+        }
+      }
+      for (auto& pair_image : m_images) {
+        if (pair_image.second.handle() != handle) continue;
+        // sampled and storage content would be lost, attachments are in layouts the replacement would not have
+        auto usage_kept = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eColorAttachment
+                        | vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eInputAttachment;
+        if (!(pair_image.second.info().usage & usage_kept)) {
+          images.emplace_back(&pair_image.second);
+        }
+      }
+    }
+    if (buffers.size() + images.size() < candidates.size()) continue;
+
+    for (auto buffer : buffers) {
+      if (bytes_moved >= budget) break;
+      Buffer buffer_new{m_device, buffer->size(), buffer->info().usage};
+      if (!allocator.allocateElsewhere(buffer_new, *buffer)) break;
+      bytes_moved += buffer->requirements().size;
+      buffers_moved.emplace_back(buffer, std::move(buffer_new));
+    }
+    for (auto image : images) {
+      if (bytes_moved >= budget) break;
+      auto const& info = image->info();
+      BackedImage image_new{m_device, info.extent, info.format, info.tiling, info.usage, info.mipLevels};
+      if (!allocator.allocateElsewhere(image_new, *image)) break;
+      bytes_moved += image->requirements().size;
+      images_moved.emplace_back(image, std::move(image_new));
+    }
+  }
+
+  if (bytes_moved > 0) {
+    // old resources may still be in use
+    emptyDrawQueue();
+    m_device->waitIdle();
+    for (auto& move : buffers_moved) {
+      m_transferrer.copyBuffer(*move.first, move.second);
+      // replacement object now holds old buffer
+      move.first->swap(move.second);
+      for (auto& pair_view : m_buffer_views) {
+        if (pair_view.second.buffer() == move.second.get()) {
+          pair_view.second.bindTo(*move.first, pair_view.second.offset());
+        }
+      }
+      // frame resources hold their own views
+      for (auto& res : m_frame_resources) {
+        for (auto& pair_view : res.buffer_views) {
+          if (pair_view.second.buffer() == move.second.get()) {
+            pair_view.second.bindTo(*move.first, pair_view.second.offset());
+          }
+        }
+      }
+    }
+    for (auto& move : images_moved) {
+      move.first->swap(move.second);
+    }
+    // free previous ranges
+    buffers_moved.clear();
+    images_moved.clear();
+  }
+
+  for (auto& pair_alloc : m_allocators) {
+    pair_alloc.second.releaseEmptyBlocks();
+  }
+
+  if (bytes_moved > 0) {
+    // rebind moved resources
+    createFramebuffers();
+    updateDescriptors();
+    updateFrameResources();
+  }
+  return bytes_moved;
+}
+
 void Application::createMemoryPools() {
   // find memory type which supports optimal image and specific depth format
   auto type_img = m_device.suitableMemoryType(vk::Format::eD32Sfloat, vk::ImageTiling::eOptimal, vk::MemoryPropertyFlagBits::eDeviceLocal);
@@ -136,6 +338,11 @@ glm::u32vec2 const& Application::resolution() const {
   return m_resolution;
 }
 
+uint32_t Application::transferQueueFamily() const {
+  // submitted together with draw buffer
+  return m_device.getQueueIndex("graphics");
+}
+
 std::string const& Application::resourcePath() const {
   return m_resource_path;
 }
@@ -16,6 +16,8 @@
 cmdline::parser ApplicationWin::getParser() {
   cmdline::parser cmd_parse{Application::getParser()};
   cmd_parse.add("present", 'p', "present mode", false, std::string{"fifo"}, cmdline::oneof<std::string>("fifo", "mailbox", "immediate"));
+  cmd_parse.add("pacing", 'l', "low latency, delay frames to finish just before presentation");
+  cmd_parse.add<int>("rate", 'r', "target frame rate with pacing in mailbox and immediate mode, 0 - refresh rate", false, 0, cmdline::range(0, 1000));
   return cmd_parse;
 }
 
@@ -29,6 +31,21 @@ ApplicationWin::ApplicationWin(std::string const& resource_path, Device& device,
 
   createSwapChain(surf, cmd_parse, image_count);
 
+  if (cmd_parse.exist("pacing")) {
+    // fifo is paced by vblank
+    double period = 0.0;
+    if (cmd_parse.get<std::string>("present") != "fifo") {
+      int rate = cmd_parse.get<int>("rate");
+      if (rate == 0) {
+        auto monitor = glfwGetWindowMonitor(&surf.window());
+        auto mode = glfwGetVideoMode(monitor ? monitor : glfwGetPrimaryMonitor());
+        rate = mode ? mode->refreshRate : 60;
+      }
+      period = 1000.0 / double(rate);
+    }
+    m_pacer = FramePacer{period};
+  }
+
   m_statistics.addTimer("fence_acquire");
   m_statistics.addTimer("queue_present");
 }
@@ -66,12 +83,12 @@ FrameResource ApplicationWin::createFrameResource() {
 
 void ApplicationWin::acquireImage(FrameResource& res) {
   // wait for last acquisition until acquiring again
-  m_statistics.start("fence_acquire");
-  res.fence("acquire").wait();
-  m_statistics.stop("fence_acquire");
+  m_statistics.start(frame_handles::fence_acquire);
+  res.fence(frame_handles::acquire).wait();
+  stopWait(frame_handles::fence_acquire);
 
-  res.fence("acquire").reset();
-  auto result = m_device->acquireNextImageKHR(m_swap_chain, 1000, res.semaphore("acquire"), res.fence("acquire"), &res.image);
+  res.fence(frame_handles::acquire).reset();
+  auto result = m_device->acquireNextImageKHR(m_swap_chain, 1000, res.semaphore(frame_handles::acquire), res.fence(frame_handles::acquire), &res.image);
   if (result == vk::Result::eErrorOutOfDateKHR) {
       // handle swapchain recreation
       // recreateSwapChain();
@@ -87,24 +104,25 @@ void ApplicationWin::acquireImage(FrameResource& res) {
 }
 
 void ApplicationWin::presentFrame(FrameResource& res) {
-  presentFrame(res, m_device.getQueue("present"));
+  presentFrame(res, m_device.getQueue(frame_handles::present));
 }
 
 void ApplicationWin::presentFrame(FrameResource& res, vk::Queue const& queue) {
-  m_statistics.start("queue_present");
+  m_statistics.start(frame_handles::queue_present);
   
   vk::PresentInfoKHR presentInfo{};
   presentInfo.waitSemaphoreCount = 1;
-  presentInfo.pWaitSemaphores = &res.semaphore("draw");
+  presentInfo.pWaitSemaphores = &res.semaphore(frame_handles::draw);
 
   presentInfo.swapchainCount = 1;
   presentInfo.pSwapchains = &m_swap_chain.get();
   presentInfo.pImageIndices = &res.image;
 
   // do wait before present to prevent cpu stalling
-  m_device.getQueue("present").waitIdle();
+  m_device.getQueue(frame_handles::present).waitIdle();
   queue.presentKHR(presentInfo);
-  m_statistics.stop("queue_present");
+  stopWait(frame_handles::queue_present);
+  recordLatency(res.timer_latency);
 }
 
 void ApplicationWin::resize(std::size_t width, std::size_t height) {
@@ -143,15 +161,15 @@ glm::u32vec2 ApplicationWin::queryResolution() const {
 
 SubmitInfo ApplicationWin::createDrawSubmitInfo(FrameResource const& res) const {
   SubmitInfo info = Application::createDrawSubmitInfo(res);
-  info.addWaitSemaphore(res.semaphore("acquire"), vk::PipelineStageFlagBits::eColorAttachmentOutput);
-  info.addSignalSemaphore(res.semaphore("draw"));
+  info.addWaitSemaphore(res.semaphore(frame_handles::acquire), vk::PipelineStageFlagBits::eColorAttachmentOutput);
+  info.addSignalSemaphore(res.semaphore(frame_handles::draw));
   return info;
 }
 
 void ApplicationWin::presentCommands(FrameResource& res, ImageLayers const& view, vk::ImageLayout const& layout) {
-  res.command_buffers.at("primary").transitionLayout(res.target_region, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
-  res.command_buffers.at("primary").copyImage(view, layout, res.target_region, vk::ImageLayout::eTransferDstOptimal);
-  res.command_buffers.at("primary").transitionLayout(res.target_region, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::ePresentSrcKHR);
+  res.command_buffers.at(frame_handles::primary).transitionLayout(res.target_region, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
+  res.command_buffers.at(frame_handles::primary).copyImage(view, layout, res.target_region, vk::ImageLayout::eTransferDstOptimal);
+  res.command_buffers.at(frame_handles::primary).transitionLayout(res.target_region, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::ePresentSrcKHR);
 }
 
 void ApplicationWin::keyCallbackSelf(int key, int scancode, int action, int mods) {
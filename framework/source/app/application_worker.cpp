@@ -5,6 +5,7 @@
 #include "wrap/submit_info.hpp"
 
 #include "frame_resource.hpp"
+#include "memory_telemetry.hpp"
 
 #include "cmdline.h"
 //dont load gl bindings from glfw
@@ -24,6 +25,11 @@ cmdline::parser ApplicationWorker::getParser() {
 ApplicationWorker::ApplicationWorker(std::string const& resource_path, Device& device, Surface const& surf, uint32_t image_count, cmdline::parser const& cmd_parse)
  :Application{resource_path, device, image_count - 1, cmd_parse}
  ,m_ptr_buff_transfer{nullptr}
+ ,m_views_readback{}
+ ,m_slot_next{0}
+ ,m_slots_recorded{}
+ ,m_readbacks{}
+ ,m_atom_invalidate{0}
  ,m_should_close{false}
 {
   // receive resolution
@@ -44,25 +50,39 @@ ApplicationWorker::~ApplicationWorker() {
 }
 
 void ApplicationWorker::createSendBuffer() {
-  // create upload buffer;
-  m_buffers["transfer"] = Buffer{m_device, resolution().x * resolution().y * sizeof(glm::u8vec4) * m_frame_resources.size(), vk::BufferUsageFlagBits::eTransferDst};
+  vk::DeviceSize size_frame = resolution().x * resolution().y * sizeof(glm::u8vec4);
+  auto num_slots = m_frame_resources.size() + 1;
+  // create readback buffer;
+  m_buffers["transfer"] = Buffer{m_device, size_frame * num_slots, vk::BufferUsageFlagBits::eTransferDst};
   
-  auto mem_type = this->m_device.findMemoryType(this->m_buffers.at("transfer").requirements().memoryTypeBits 
-                              , vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+  auto type_bits = this->m_buffers.at("transfer").requirements().memoryTypeBits;
+  // cached memory is much faster to read, but may need invalidation
+  uint32_t mem_type = 0;
+  try {
+    mem_type = this->m_device.findMemoryType(type_bits, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCached);
+  }
+  catch (std::runtime_error const&) {
+    mem_type = this->m_device.findMemoryType(type_bits, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+  }
+  auto flags_mem = m_device.physical().getMemoryProperties().memoryTypes[mem_type].propertyFlags;
+  m_atom_invalidate = 0;
+  if (!(flags_mem & vk::MemoryPropertyFlagBits::eHostCoherent)) {
+    m_atom_invalidate = m_device.physical().getProperties().limits.nonCoherentAtomSize;
+  }
   m_allocator = StaticAllocator(this->m_device, mem_type, this->m_buffers.at("transfer").requirements().size);
   m_allocator.allocate(this->m_buffers.at("transfer"));
 
   m_ptr_buff_transfer = m_allocator.map(m_buffers.at("transfer"));
-}
 
-void ApplicationWorker::updateFrameResources() {
-  for (auto& res : this->m_frame_resources) {
-    this->updateResourceDescriptors(res);
-    this->updateResourceCommandBuffers(res);
-    // update view into transfer buffer
-    res.buffer_views["transfer"] = BufferView{resolution().x * resolution().y * sizeof(glm::u8vec4), vk::BufferUsageFlagBits::eTransferDst};
-    res.buffer_views.at("transfer").bindTo(this->m_buffers.at("transfer"));
+  m_views_readback.clear();
+  for (std::size_t i = 0; i < num_slots; ++i) {
+    m_views_readback.emplace_back(BufferView{size_frame, vk::BufferUsageFlagBits::eTransferDst});
+    m_views_readback.back().bindTo(this->m_buffers.at("transfer"));
   }
+  m_slot_next = 0;
+  m_slots_recorded = std::vector<uint32_t>(m_frame_resources.size(), 0);
+  // frames of previous resolution are not sent
+  m_readbacks = std::queue<readback_t>{};
 }
 
 void ApplicationWorker::acquireImage(FrameResource& res) {
@@ -70,19 +90,40 @@ void ApplicationWorker::acquireImage(FrameResource& res) {
 }
 
 void ApplicationWorker::presentCommands(FrameResource& res, ImageLayers const& view, vk::ImageLayout const& layout) {
-  res.command_buffers.at("primary").copyImageToBuffer(view, layout, res.buffer_views.at("transfer"));
+  // slot is not sent before next frame is recorded
+  m_slots_recorded[res.index] = m_slot_next;
+  res.command_buffers.at(frame_handles::primary).copyImageToBuffer(view, layout, m_views_readback[m_slot_next]);
+  m_slot_next = (m_slot_next + 1) % uint32_t(m_views_readback.size());
 }
 
 void ApplicationWorker::presentFrame(FrameResource& res) {
-  // make sure drawing is done
-  this->m_statistics.start("fence_draw");
-  res.fence("draw").wait();
-  this->m_statistics.stop("fence_draw");
-  this->m_statistics.start("present");
+  m_readbacks.emplace(readback_t{res.index, m_slots_recorded[res.index], res.timer_latency});
+  // send previous frame while this one is drawn, the first frame is sent twice
+  auto& readback = m_readbacks.front();
+  // resource was recorded again, so the frame must be finished
+  bool finished = m_readbacks.size() > 1 && m_readbacks.back().resource == readback.resource;
+  auto& res_readback = m_frame_resources[readback.resource];
+  if (!finished && !res_readback.finished(frame_handles::draw)) {
+    this->m_statistics.start(frame_handles::fence_draw);
+    res_readback.wait(frame_handles::draw);
+    this->stopWait(frame_handles::fence_draw);
+  }
+  this->m_statistics.start(frame_handles::present);
+  auto const& view = m_views_readback[readback.slot];
+  if (m_atom_invalidate > 0) {
+    auto offset = view.offset() / m_atom_invalidate * m_atom_invalidate;
+    auto end = (view.offset() + view.size() + m_atom_invalidate - 1) / m_atom_invalidate * m_atom_invalidate;
+    auto size = end < m_allocator.bytesReserved() ? end - offset : VK_WHOLE_SIZE;
+    m_device->invalidateMappedMemoryRanges({vk::MappedMemoryRange{m_allocator.mem(), offset, size}});
+  }
   // write data to presenter
-  int size = int(res.buffer_views.at("transfer").size());
-  MPI::COMM_WORLD.Gather(m_ptr_buff_transfer + res.buffer_views.at("transfer").offset(), size, MPI::BYTE, nullptr, size, MPI::BYTE, 0);
-  this->m_statistics.stop("present");
+  int size = int(view.size());
+  MPI::COMM_WORLD.Gather(m_ptr_buff_transfer + view.offset(), size, MPI::BYTE, nullptr, size, MPI::BYTE, 0);
+  this->m_statistics.stop(frame_handles::present);
+  if (m_readbacks.size() > 1) {
+    recordLatency(readback.timer_latency);
+    m_readbacks.pop();
+  }
 }
 
 void ApplicationWorker::onResize() {
@@ -119,6 +160,11 @@ void ApplicationWorker::onFrameEnd() {
   m_should_close = flag > 0;
 }
 
+void ApplicationWorker::recordMemoryStatistics() {
+  Application::recordMemoryStatistics();
+  m_telemetry.record("transfer", m_allocator);
+}
+
 bool ApplicationWorker::shouldClose() const{
   return m_should_close;
 }
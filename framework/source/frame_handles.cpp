@@ -0,0 +1,24 @@
+#include "frame_handles.hpp"
+
+namespace frame_handles {
+  Handle const primary{"primary"};
+  Handle const transfer{"transfer"};
+  Handle const draw{"draw"};
+  Handle const acquire{"acquire"};
+  Handle const graphics{"graphics"};
+  Handle const present{"present"};
+
+  Handle const frame{"frame"};
+  Handle const frame_latency{"frame_latency"};
+  Handle const pacing_delay{"pacing_delay"};
+  Handle const record{"record"};
+  Handle const frame_draw{"frame_draw"};
+  Handle const frame_transfer{"frame_transfer"};
+  Handle const fence_draw{"fence_draw"};
+  Handle const fence_transfer{"fence_transfer"};
+  Handle const fence_acquire{"fence_acquire"};
+  Handle const sema_draw{"sema_draw"};
+  Handle const sema_present{"sema_present"};
+  Handle const sema_transfer{"sema_transfer"};
+  Handle const queue_present{"queue_present"};
+}
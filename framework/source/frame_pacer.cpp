@@ -0,0 +1,96 @@
+#include "frame_pacer.hpp"
+
+#include <algorithm>
+#include <thread>
+
+// slack left to absorb variance, in ms
+const double MARGIN_MIN = 0.5;
+const double MARGIN_RELATIVE = 0.1;
+// sleep is imprecise, remainder is spent yielding
+const std::chrono::microseconds SPIN_DURATION{1000};
+
+static void sleep_until(std::chrono::steady_clock::time_point const& time) {
+  auto time_sleep = time - SPIN_DURATION;
+  if (std::chrono::steady_clock::now() < time_sleep) {
+    std::this_thread::sleep_until(time_sleep);
+  }
+  while (std::chrono::steady_clock::now() < time) {
+    std::this_thread::yield();
+  }
+}
+
+static double to_ms(std::chrono::steady_clock::duration const& duration) {
+  return double(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()) / 1000.0 / 1000.0;
+}
+
+static std::chrono::steady_clock::duration to_duration(double ms) {
+  return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>{ms});
+}
+
+FramePacer::FramePacer()
+ :m_enabled{false}
+ ,m_period{0.0}
+ ,m_history{0}
+ ,m_slacks{}
+ ,m_delay{0.0}
+ ,m_blocked{0.0}
+ ,m_time_start{}
+{}
+
+FramePacer::FramePacer(double period, std::size_t history)
+ :FramePacer{}
+{
+  m_enabled = true;
+  m_period = period;
+  m_history = std::max(history, std::size_t{1});
+}
+
+double FramePacer::wait() {
+  if (!m_enabled) return 0.0;
+
+  auto time_begin = clock_type::now();
+  // move predicted blocking before the frame
+  auto time_next = time_begin + to_duration(m_delay);
+  // limit frame rate to target period
+  if (m_period > 0.0 && m_time_start != clock_type::time_point{}) {
+    time_next = std::max(time_next, m_time_start + to_duration(m_period));
+  }
+  sleep_until(time_next);
+
+  m_time_start = clock_type::now();
+  return to_ms(m_time_start - time_begin);
+}
+
+void FramePacer::addBlocked(double duration) {
+  m_blocked += duration;
+}
+
+void FramePacer::frameEnd() {
+  if (!m_enabled) return;
+
+  auto slack = m_delay + m_blocked;
+  auto margin = std::max(MARGIN_MIN, slack * MARGIN_RELATIVE);
+  if (m_blocked < margin * 0.5) {
+    // frame took longer than predicted, back off quickly
+    m_slacks.clear();
+    m_delay *= 0.5;
+  }
+  else {
+    m_slacks.push_back(slack);
+    if (m_slacks.size() > m_history) {
+      m_slacks.pop_front();
+    }
+    // smallest recent slack is safe for all recent frames
+    auto slack_min = *std::min_element(m_slacks.begin(), m_slacks.end());
+    m_delay = std::max(0.0, slack_min - margin);
+  }
+  m_blocked = 0.0;
+}
+
+bool FramePacer::enabled() const {
+  return m_enabled;
+}
+
+double FramePacer::delay() const {
+  return m_delay;
+}
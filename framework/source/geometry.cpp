@@ -1,6 +1,7 @@
 #include "geometry.hpp"
 
 #include "wrap/device.hpp"
+#include "geometry_buffer.hpp"
 #include "transferrer.hpp"
 #include "wrap/vertex_info.hpp"
 
@@ -9,6 +10,8 @@
 Geometry::Geometry()
  :m_model{}
  ,m_buffer{}
+ ,m_storage{nullptr}
+ ,m_handle{0}
 {}
 
 Geometry::Geometry(Geometry && dev)
@@ -18,9 +21,9 @@ Geometry::Geometry(Geometry && dev)
 }
 
 Geometry::Geometry(Transferrer& transferrer, vertex_data const& model)
- :m_model{model}
- ,m_buffer{}
+ :Geometry{}
 {
+  m_model = model;
   // create one buffer to store all data
   m_view_vertices = BufferView{m_model.vertex_num * m_model.vertex_bytes, vk::BufferUsageFlagBits::eVertexBuffer};
   m_view_indices = BufferView{uint32_t(m_model.indices.size() * vertex_data::INDEX.size), vk::BufferUsageFlagBits::eIndexBuffer};
@@ -43,6 +46,20 @@ Geometry::Geometry(Transferrer& transferrer, vertex_data const& model)
   }
 }
 
+Geometry::Geometry(GeometryBuffer& storage, vertex_data const& model)
+ :Geometry{}
+{
+  m_model = model;
+  m_handle = storage.store(m_model);
+  m_storage = &storage;
+}
+
+Geometry::~Geometry() {
+  if (m_storage) {
+    m_storage->free(m_handle);
+  }
+}
+
  Geometry& Geometry::operator=(Geometry&& dev) {
   swap(dev);
   return *this;
@@ -57,17 +74,25 @@ Geometry::Geometry(Transferrer& transferrer, vertex_data const& model)
 
   std::swap(m_view_vertices, dev.m_view_vertices);
   std::swap(m_view_indices, dev.m_view_indices);
+  std::swap(m_storage, dev.m_storage);
+  std::swap(m_handle, dev.m_handle);
 }
 
 vk::Buffer const& Geometry::buffer() const {
-  return m_buffer;
+  return vertices().buffer();
 }
 
-BufferView const& Geometry::vertices() const {
+BufferRegion const& Geometry::vertices() const {
+  if (m_storage) {
+    return m_storage->vertices(m_handle);
+  }
   return m_view_vertices;
 }
 
-BufferView const& Geometry::indices() const {
+BufferRegion const& Geometry::indices() const {
+  if (m_storage) {
+    return m_storage->indices(m_handle);
+  }
   return m_view_indices;
 }
 
@@ -89,10 +114,10 @@ uint32_t Geometry::numVertices() const {
 }
 // for drawing from shared index buffer
 uint32_t Geometry::indexOffset() const {
-  return 0;
+  return uint32_t(indices().offset() / vertex_data::INDEX.size);
 }
 
-// for drawing from shared vertex buffer
+// for drawing from shared vertex buffer, offsets are multiples of the stride
 uint32_t Geometry::vertexOffset() const {
-  return 0;
+  return uint32_t(vertices().offset() / m_model.vertex_bytes);
 }
@@ -0,0 +1,187 @@
+#include "geometry_buffer.hpp"
+
+#include "wrap/device.hpp"
+#include "transferrer.hpp"
+#include "vertex_data.hpp"
+
+#include <algorithm>
+
+GeometryBuffer::GeometryBuffer()
+ :m_transferrer{nullptr}
+ ,m_page_bytes{0}
+ ,m_pages{}
+ ,m_slots{}
+ ,m_next_handle{0}
+ ,m_bytes_used{0}
+ ,m_mutex{}
+{}
+
+GeometryBuffer::GeometryBuffer(Transferrer& transferrer, vk::DeviceSize page_bytes)
+ :GeometryBuffer{}
+{
+  m_transferrer = &transferrer;
+  m_page_bytes = page_bytes;
+}
+
+GeometryBuffer::GeometryBuffer(GeometryBuffer && rhs)
+ :GeometryBuffer{}
+{
+  swap(rhs);
+}
+
+GeometryBuffer& GeometryBuffer::operator=(GeometryBuffer&& rhs) {
+  swap(rhs);
+  return *this;
+}
+
+void GeometryBuffer::swap(GeometryBuffer& rhs) {
+  std::swap(m_transferrer, rhs.m_transferrer);
+  std::swap(m_page_bytes, rhs.m_page_bytes);
+  std::swap(m_pages, rhs.m_pages);
+  std::swap(m_slots, rhs.m_slots);
+  std::swap(m_next_handle, rhs.m_next_handle);
+  std::swap(m_bytes_used, rhs.m_bytes_used);
+}
+
+std::unique_ptr<GeometryBuffer::page_t> GeometryBuffer::createPage(vk::DeviceSize size) const {
+  auto const& device = m_transferrer->device();
+  std::unique_ptr<page_t> page{new page_t{}};
+  page->buffer = Buffer{device, size, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst};
+  auto mem_type = device.findMemoryType(page->buffer.requirements().memoryTypeBits
+                                           , vk::MemoryPropertyFlagBits::eDeviceLocal);
+  page->allocator = StaticAllocator{device, mem_type, page->buffer.requirements().size};
+  page->allocator.allocate(page->buffer);
+  page->free_ranges.emplace(0, size);
+  return page;
+}
+
+bool GeometryBuffer::claimRange(page_t& page, vk::DeviceSize size, vk::DeviceSize alignment, vk::DeviceSize& offset) {
+  for (auto iter_range = page.free_ranges.begin(); iter_range != page.free_ranges.end(); ++iter_range) {
+    auto offset_range = iter_range->first;
+    auto end_range = iter_range->first + iter_range->second;
+    offset = align_offset(offset_range, alignment);
+    if (offset + size > end_range) continue;
+
+    page.free_ranges.erase(iter_range);
+    if (offset > offset_range) {
+      page.free_ranges.emplace(offset_range, offset - offset_range);
+    }
+    if (offset + size < end_range) {
+      page.free_ranges.emplace(offset + size, end_range - offset - size);
+    }
+    return true;
+  }
+  return false;
+}
+
+void GeometryBuffer::releaseRange(page_t& page, vk::DeviceSize offset, vk::DeviceSize size) {
+  auto iter_next = page.free_ranges.lower_bound(offset);
+  auto end = offset + size;
+  // merge with neighbouring free ranges
+  if (iter_next != page.free_ranges.end() && iter_next->first == end) {
+    end += iter_next->second;
+    iter_next = page.free_ranges.erase(iter_next);
+  }
+  if (iter_next != page.free_ranges.begin()) {
+    auto iter_prev = std::prev(iter_next);
+    if (iter_prev->first + iter_prev->second == offset) {
+      offset = iter_prev->first;
+      page.free_ranges.erase(iter_prev);
+    }
+  }
+  page.free_ranges.emplace(offset, end - offset);
+}
+
+void GeometryBuffer::setRegions(slot_t& slot, vk::DeviceSize bytes_vertices, vk::DeviceSize bytes_indices) const {
+  auto const& buffer = m_pages[slot.page]->buffer.get();
+  slot.vertices = BufferRegion{buffer, bytes_vertices, slot.offset};
+  // indices follow vertices
+  slot.indices = BufferRegion{buffer, bytes_indices, slot.offset + align_offset(bytes_vertices, vertex_data::INDEX.size)};
+}
+
+uint32_t GeometryBuffer::store(vertex_data const& model) {
+  auto bytes_vertices = vk::DeviceSize{model.vertex_num} * model.vertex_bytes;
+  auto bytes_indices = vk::DeviceSize(model.indices.size()) * vertex_data::INDEX.size;
+
+  slot_t slot{};
+  // must be multiple of stride and index size
+  slot.alignment = model.vertex_bytes % vertex_data::INDEX.size == 0 ? model.vertex_bytes : model.vertex_bytes * vertex_data::INDEX.size;
+  slot.size = align_offset(bytes_vertices, vertex_data::INDEX.size) + bytes_indices;
+
+  uint32_t handle = 0;
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    bool found = false;
+    for (size_t idx_page = 0; idx_page < m_pages.size() && !found; ++idx_page) {
+      if (!m_pages[idx_page]) continue;
+      if (claimRange(*m_pages[idx_page], slot.size, slot.alignment, slot.offset)) {
+        slot.page = idx_page;
+        found = true;
+      }
+    }
+    // add page, reusing slot of released one
+    if (!found) {
+      auto iter_page = std::find(m_pages.begin(), m_pages.end(), nullptr);
+      slot.page = size_t(iter_page - m_pages.begin());
+      if (iter_page == m_pages.end()) {
+        m_pages.emplace_back(nullptr);
+      }
+      m_pages[slot.page] = createPage(std::max(m_page_bytes, slot.size));
+      claimRange(*m_pages[slot.page], slot.size, slot.alignment, slot.offset);
+    }
+    setRegions(slot, bytes_vertices, bytes_indices);
+
+    handle = m_next_handle++;
+    m_slots.emplace(handle, slot);
+    m_bytes_used += slot.size;
+  }
+  // range is owned exclusively, upload without lock
+  m_transferrer->uploadBufferDataAsync(model.data.data(), slot.vertices);
+  if (!model.indices.empty()) {
+    m_transferrer->uploadBufferDataAsync(model.indices.data(), slot.indices);
+  }
+  return handle;
+}
+
+void GeometryBuffer::free(uint32_t handle) {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  auto iter_slot = m_slots.find(handle);
+  if (iter_slot == m_slots.end()) {
+    throw std::runtime_error{"geometry " + std::to_string(handle) + " not found"};
+  }
+  auto const& slot = iter_slot->second;
+  releaseRange(*m_pages[slot.page], slot.offset, slot.size);
+  m_bytes_used -= slot.size;
+  m_slots.erase(iter_slot);
+}
+
+BufferRegion const& GeometryBuffer::vertices(uint32_t handle) const {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  return m_slots.at(handle).vertices;
+}
+
+BufferRegion const& GeometryBuffer::indices(uint32_t handle) const {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  return m_slots.at(handle).indices;
+}
+
+std::size_t GeometryBuffer::numPages() const {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  return std::size_t(std::count_if(m_pages.begin(), m_pages.end(), [](std::unique_ptr<page_t> const& page) { return bool(page); }));
+}
+
+vk::DeviceSize GeometryBuffer::bytesReserved() const {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  vk::DeviceSize bytes = 0;
+  for (auto const& page : m_pages) {
+    if (page) {
+      bytes += page->buffer.size();
+    }
+  }
+  return bytes;
+}
+
+vk::DeviceSize GeometryBuffer::bytesUsed() const {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  return m_bytes_used;
+}
@@ -1,6 +1,7 @@
 #include "geometry_lod.hpp"
 
 #include "wrap/device.hpp"
+#include "wrap/command_buffer.hpp"
 #include "wrap/vertex_info.hpp"
 #include "camera.hpp"
 #include "geometry_loader.hpp"
@@ -103,7 +104,8 @@ void GeometryLod::createStagingBuffers() {
 }
 
 void GeometryLod::createDrawingBuffers() {
-  m_buffer = Buffer{*m_device, m_size_node * m_num_slots, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst};
+  // written by transfer queue, owned by graphics queue otherwise
+  m_buffer = Buffer{*m_device, m_size_node * m_num_slots, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::SharingMode::eExclusive};
   auto requirements_draw = m_buffer.requirements();
   // per-buffer offset
   auto offset_draw = requirements_draw.alignment * vk::DeviceSize(std::ceil(float(m_size_node) / float(requirements_draw.alignment)));
@@ -114,7 +116,7 @@ void GeometryLod::createDrawingBuffers() {
   // total buffer size
   requirements_draw.size = m_size_node + offset_draw * (m_num_slots - 1) + size_drawbuff + size_levelbuff * 2;
   std::cout << "LOD drawing buffer size is " << requirements_draw.size / 1024 / 1024 << " MB for " << m_num_nodes << " nodes" << std::endl;
-  m_buffer = Buffer{*m_device, requirements_draw.size, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eStorageBuffer};
+  m_buffer = Buffer{*m_device, requirements_draw.size, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eStorageBuffer, vk::SharingMode::eExclusive};
 
   auto mem_type = m_device->findMemoryType(m_buffer.requirements().memoryTypeBits 
                                            , vk::MemoryPropertyFlagBits::eDeviceLocal);
@@ -135,7 +137,14 @@ void GeometryLod::createDrawingBuffers() {
 void GeometryLod::nodeToSlotImmediate(std::size_t idx_node, std::size_t idx_slot) {
   // get next staging slot
   std::memcpy(m_ptr_mem_stage + m_db_views_stage.back()[0].offset(), m_nodes[idx_node].data(), m_size_node);
-  m_transferrer->copyBuffer(m_db_views_stage.back()[0], m_buffer_views[idx_slot]);
+  auto const& command_buffer = m_transferrer->beginSingleTimeCommands();
+  command_buffer.copyBuffer(m_db_views_stage.back()[0], m_buffer_views[idx_slot]);
+  // transferrer submits to the transfer queue
+  auto family = m_device->getQueueIndex("transfer");
+  command_buffer.releaseBuffer(m_buffer_views[idx_slot], family, m_device->getQueueIndex("graphics"), vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite);
+  m_transferrer->endSingleTimeCommands();
+  auto const& view = m_buffer_views[idx_slot];
+  m_regions_released.emplace_back(family, BufferRegion{view.buffer(), view.size(), view.offset()});
   // update slot occupation
   m_slots[idx_slot] = idx_node;
 }
@@ -154,6 +163,14 @@ std::size_t GeometryLod::sizeNode() const {
   return m_size_node;
 }
 
+StaticAllocator const& GeometryLod::allocatorDraw() const {
+  return m_allocator_draw;
+}
+
+StaticAllocator const& GeometryLod::allocatorStage() const {
+  return m_allocator_stage;
+}
+
 void GeometryLod::performUploads() {
   // auto start = std::chrono::steady_clock::now();
   for(std::size_t i = 0; i < m_node_uploads.size(); ++i) {
@@ -171,14 +188,14 @@ void GeometryLod::performUploads() {
 }
 
 void GeometryLod::performCopies() {
-  vk::CommandBuffer const& commandBuffer = m_transferrer->beginSingleTimeCommands();
-  performCopiesCommand(commandBuffer);
+  auto const& commandBuffer = m_transferrer->beginSingleTimeCommands();
+  performCopiesCommand(commandBuffer, m_device->getQueueIndex("transfer"));
   m_transferrer->endSingleTimeCommands();
 
   m_node_uploads.clear();
 }
 
-void GeometryLod::performCopiesCommand(vk::CommandBuffer const& command_buffer) {
+void GeometryLod::performCopiesCommand(CommandBuffer const& command_buffer, uint32_t family) {
   if (m_node_uploads.empty()) return;
   // memory transfer to staging is finished
   m_db_views_stage.swap();
@@ -188,8 +205,43 @@ void GeometryLod::performCopiesCommand(vk::CommandBuffer const& command_buffer)
     std::size_t idx_slot = m_node_uploads[i].second;
     copies_nodes.emplace_back(m_db_views_stage.front()[i].offset(), m_buffer_views[idx_slot].offset(), m_size_node);
   }
-  command_buffer.copyBuffer(m_buffer_stage, m_buffer, copies_nodes);
+  command_buffer->copyBuffer(m_buffer_stage, m_buffer, copies_nodes);
+
+  // slots are not used by the previous cut, so they are written without acquiring them first
+  auto family_draw = m_device->getQueueIndex("graphics");
+  for (auto const& upload : m_node_uploads) {
+    auto const& view = m_buffer_views[upload.second];
+    command_buffer.releaseBuffer(view, family, family_draw, vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite);
+    m_regions_released.emplace_back(family, BufferRegion{view.buffer(), view.size(), view.offset()});
+  }
+
+  // std::cout << "uploading " << m_node_uploads.size() << " nodes with "<< float(m_node_uploads.size() * m_size_node) / 1024.0f / 1024.0f << " MB" << std::endl;
+  m_node_uploads.clear();
+}
 
+void GeometryLod::updateDrawCommands(CommandBuffer const& command_buffer) {
+  auto family_draw = m_device->getQueueIndex("graphics");
+  for (auto const& region : m_regions_released) {
+    command_buffer.acquireBuffer(region.second, region.first, family_draw, vk::PipelineStageFlagBits::eVertexInput, vk::AccessFlagBits::eVertexAttributeRead);
+  }
+  m_regions_released.clear();
+
+  // previous frames must be done reading
+  command_buffer.bufferBarrier(m_view_draw_commands, 
+    vk::PipelineStageFlagBits::eDrawIndirect, vk::AccessFlags{}, 
+    vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite
+  );
+  command_buffer.bufferBarrier(m_view_levels, 
+    vk::PipelineStageFlagBits::eFragmentShader, vk::AccessFlags{}, 
+    vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite
+  );
+  // upload draw instructions
+  command_buffer->updateBuffer(
+    m_view_draw_commands.buffer(),
+    m_view_draw_commands.offset(),
+    numNodes() * sizeof(vk::DrawIndirectCommand),
+    drawCommands().data()
+  );
 
   std::vector<float> levels(m_num_slots + 1, 0.0f);
   float depth = float(m_bvh.get_depth());
@@ -200,25 +252,12 @@ void GeometryLod::performCopiesCommand(vk::CommandBuffer const& command_buffer)
   uint32_t verts_per_node = uint32_t(m_buffer_views[1].offset() / m_model.vertex_bytes);
   std::memcpy(levels.data(), &verts_per_node, sizeof(std::uint32_t));
   // upload mode levels
-  command_buffer.updateBuffer(
+  command_buffer->updateBuffer(
     m_view_levels.buffer(),
     m_view_levels.offset(),
     m_view_levels.size(),
     levels.data()
   );
-
-  // std::cout << "uploading " << m_node_uploads.size() << " nodes with "<< float(m_node_uploads.size() * m_size_node) / 1024.0f / 1024.0f << " MB" << std::endl;
-  m_node_uploads.clear();
-}
-
-void GeometryLod::updateDrawCommands(vk::CommandBuffer const& command_buffer) {
-  // upload draw instructions
-  command_buffer.updateBuffer(
-    m_view_draw_commands.buffer(),
-    m_view_draw_commands.offset(),
-    numNodes() * sizeof(vk::DrawIndirectCommand),
-    drawCommands().data()
-  );
 }
 
 void GeometryLod::updateDrawCommands() {
@@ -278,6 +317,7 @@ void GeometryLod::updateDrawCommands() {
   std::swap(m_active_slots, dev.m_active_slots);
   std::swap(m_slots, dev.m_slots);
   std::swap(m_node_uploads, dev.m_node_uploads);
+  std::swap(m_regions_released, dev.m_regions_released);
   std::swap(m_commands_draw, dev.m_commands_draw);
   
   std::swap(m_view_levels, dev.m_view_levels);
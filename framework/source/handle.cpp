@@ -0,0 +1,62 @@
+#include "handle.hpp"
+
+#include <deque>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+const uint32_t INDEX_INVALID = ~0u;
+
+struct registry_t {
+  std::mutex mutex;
+  std::map<std::string, uint32_t> indices;
+  // stable references for name()
+  std::deque<std::string> names;
+};
+
+registry_t& registry() {
+  static registry_t registry{};
+  return registry;
+}
+}
+
+Handle::Handle()
+ :m_index{INDEX_INVALID}
+{}
+
+Handle::Handle(std::string const& name)
+ :Handle{}
+{
+  auto& reg = registry();
+  std::lock_guard<std::mutex> lock{reg.mutex};
+  auto iter = reg.indices.find(name);
+  if (iter == reg.indices.end()) {
+    iter = reg.indices.emplace(name, uint32_t(reg.names.size())).first;
+    reg.names.emplace_back(name);
+  }
+  m_index = iter->second;
+}
+
+uint32_t Handle::index() const {
+  return m_index;
+}
+
+std::string const& Handle::name() const {
+  if (!valid()) {
+    throw std::runtime_error{"handle is invalid"};
+  }
+  auto& reg = registry();
+  std::lock_guard<std::mutex> lock{reg.mutex};
+  return reg.names[m_index];
+}
+
+bool Handle::valid() const {
+  return m_index != INDEX_INVALID;
+}
+
+uint32_t Handle::count() {
+  auto& reg = registry();
+  std::lock_guard<std::mutex> lock{reg.mutex};
+  return uint32_t(reg.names.size());
+}
@@ -0,0 +1,68 @@
+#include "host_resource.hpp"
+
+#include <atomic>
+
+// unique fake handle for every resource
+static VkBuffer next_handle() {
+  static std::atomic<uint64_t> counter{1};
+  return (VkBuffer)(counter++);
+}
+
+HostResource::HostResource()
+ :MemoryResource{}
+ ,m_requirements{}
+ ,m_handle{VK_NULL_HANDLE}
+ ,m_memory{}
+ ,m_offset{0}
+{}
+
+HostResource::HostResource(vk::MemoryRequirements const& requirements)
+ :HostResource{}
+{
+  m_requirements = requirements;
+  m_handle = next_handle();
+}
+
+HostResource::HostResource(HostResource && rhs)
+ :HostResource{}
+{
+  swap(rhs);
+}
+
+HostResource::~HostResource() {
+  free();
+}
+
+HostResource& HostResource::operator=(HostResource&& rhs) {
+  swap(rhs);
+  return *this;
+}
+
+void HostResource::swap(HostResource& rhs) {
+  MemoryResource::swap(rhs);
+  std::swap(m_requirements, rhs.m_requirements);
+  std::swap(m_handle, rhs.m_handle);
+  std::swap(m_memory, rhs.m_memory);
+  std::swap(m_offset, rhs.m_offset);
+}
+
+void HostResource::bindTo(vk::DeviceMemory const& memory, vk::DeviceSize const& offset) {
+  m_memory = memory;
+  m_offset = offset;
+}
+
+vk::MemoryRequirements HostResource::requirements() const {
+  return m_requirements;
+}
+
+res_handle_t HostResource::handle() const {
+  return res_handle_t{m_handle};
+}
+
+vk::DeviceMemory const& HostResource::memory() const {
+  return m_memory;
+}
+
+vk::DeviceSize HostResource::offset() const {
+  return m_offset;
+}
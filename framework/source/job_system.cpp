@@ -0,0 +1,287 @@
+#include "job_system.hpp"
+
+#include "statistics.hpp"
+#include "wrap/timer.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <thread>
+
+struct JobSystem::workers_t {
+  struct queue_t {
+    std::mutex mutex;
+    std::deque<job_t> jobs;
+  };
+
+  workers_t(std::size_t num_workers)
+   :queues{}
+   ,threads{}
+   ,running{true}
+   ,num_queued{0}
+   ,num_sleeping{0}
+   ,mutex_sleep{}
+   ,condition_sleep{}
+   ,mutex_samples{}
+   ,samples{}
+   ,statistics{nullptr}
+   ,handles_stats{}
+  {
+    // last queue is filled by threads outside of the system
+    for (std::size_t i = 0; i < num_workers + 1; ++i) {
+      queues.emplace_back(new queue_t{});
+    }
+    for (std::size_t i = 0; i < num_workers; ++i) {
+      threads.emplace_back(&workers_t::loop, this, i);
+    }
+  }
+
+  ~workers_t() {
+    {
+      std::lock_guard<std::mutex> lock{mutex_sleep};
+      running = false;
+    }
+    condition_sleep.notify_all();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  std::size_t queueIndex() const;
+  void schedule(job_t&& job);
+  // returns false if no job was found
+  bool runOne();
+  void execute(job_t& job);
+  void finish(JobGroup& group);
+  void loop(std::size_t idx_worker);
+
+  std::vector<std::unique_ptr<queue_t>> queues;
+  std::vector<std::thread> threads;
+  std::atomic<bool> running;
+  std::atomic<std::size_t> num_queued;
+  std::atomic<std::size_t> num_sleeping;
+  std::mutex mutex_sleep;
+  std::condition_variable condition_sleep;
+  // name and duration of finished jobs
+  std::mutex mutex_samples;
+  std::vector<std::pair<std::string, double>> samples;
+  // averagers of job names, registered in the statistics samples were last recorded to
+  Statistics* statistics;
+  std::map<std::string, Handle> handles_stats;
+};
+
+namespace {
+// workers of the system the current thread belongs to
+thread_local void const* t_workers = nullptr;
+thread_local std::size_t t_idx_worker = 0;
+}
+
+std::size_t JobSystem::workers_t::queueIndex() const {
+  return t_workers == this ? t_idx_worker : queues.size() - 1;
+}
+
+void JobSystem::workers_t::schedule(job_t&& job) {
+  {
+    auto& queue = *queues[queueIndex()];
+    std::lock_guard<std::mutex> lock{queue.mutex};
+    queue.jobs.emplace_back(std::move(job));
+  }
+  // seq_cst pairs with sleeping, worker sees job or scheduler sees sleeper
+  ++num_queued;
+  if (num_sleeping.load() > 0) {
+    std::lock_guard<std::mutex> lock{mutex_sleep};
+    condition_sleep.notify_one();
+  }
+}
+
+bool JobSystem::workers_t::runOne() {
+  job_t job{};
+  bool found = false;
+  auto idx_own = queueIndex();
+  // newest own job is most likely in cache
+  {
+    auto& queue = *queues[idx_own];
+    std::lock_guard<std::mutex> lock{queue.mutex};
+    if (!queue.jobs.empty()) {
+      job = std::move(queue.jobs.back());
+      queue.jobs.pop_back();
+      found = true;
+    }
+  }
+  // steal oldest jobs of others
+  for (std::size_t i = 1; i < queues.size() && !found; ++i) {
+    auto& queue = *queues[(idx_own + i) % queues.size()];
+    std::lock_guard<std::mutex> lock{queue.mutex};
+    if (!queue.jobs.empty()) {
+      job = std::move(queue.jobs.front());
+      queue.jobs.pop_front();
+      found = true;
+    }
+  }
+  if (!found) return false;
+
+  --num_queued;
+  execute(job);
+  return true;
+}
+
+void JobSystem::workers_t::execute(job_t& job) {
+  Timer timer{};
+  timer.start();
+  try {
+    job.func();
+  }
+  catch (...) {
+    std::lock_guard<std::mutex> lock{job.group->m_mutex};
+    if (!job.group->m_error) {
+      job.group->m_error = std::current_exception();
+    }
+  }
+  if (!job.name.empty()) {
+    auto duration = timer.durationEnd();
+    std::lock_guard<std::mutex> lock{mutex_samples};
+    samples.emplace_back(std::move(job.name), duration);
+  }
+  finish(*job.group);
+}
+
+void JobSystem::workers_t::finish(JobGroup& group) {
+  std::vector<job_t> continuations{};
+  {
+    // waiter may destroy group once lock is released
+    std::lock_guard<std::mutex> lock{group.m_mutex};
+    if (--group.m_pending == 0) {
+      std::swap(continuations, group.m_continuations);
+    }
+  }
+  for (auto& job : continuations) {
+    schedule(std::move(job));
+  }
+}
+
+void JobSystem::workers_t::loop(std::size_t idx_worker) {
+  t_workers = this;
+  t_idx_worker = idx_worker;
+  while (running) {
+    if (runOne()) continue;
+
+    std::unique_lock<std::mutex> lock{mutex_sleep};
+    ++num_sleeping;
+    condition_sleep.wait(lock, [this]{return num_queued.load() > 0 || !running;});
+    --num_sleeping;
+  }
+}
+
+JobSystem::JobSystem()
+ :JobSystem{0}
+{}
+
+JobSystem::JobSystem(std::size_t num_workers)
+ :m_workers{new workers_t{num_workers}}
+{}
+
+JobSystem::JobSystem(JobSystem && rhs)
+ :JobSystem{}
+{
+  swap(rhs);
+}
+
+JobSystem::~JobSystem() {}
+
+JobSystem& JobSystem::operator=(JobSystem&& rhs) {
+  swap(rhs);
+  return *this;
+}
+
+void JobSystem::swap(JobSystem& rhs) {
+  std::swap(m_workers, rhs.m_workers);
+}
+
+void JobSystem::run(JobGroup& group, std::function<void()> const& job, std::string const& name) {
+  ++group.m_pending;
+  m_workers->schedule(job_t{job, &group, name});
+}
+
+void JobSystem::runAfter(JobGroup& dependency, JobGroup& group, std::function<void()> const& job, std::string const& name) {
+  ++group.m_pending;
+  {
+    std::lock_guard<std::mutex> lock{dependency.m_mutex};
+    if (dependency.m_pending > 0) {
+      dependency.m_continuations.emplace_back(job_t{job, &group, name});
+      return;
+    }
+  }
+  m_workers->schedule(job_t{job, &group, name});
+}
+
+void JobSystem::parallelFor(std::size_t begin, std::size_t end, std::function<void(std::size_t)> const& func, std::size_t grain, std::string const& name) {
+  JobGroup group{};
+  grain = std::max(grain, std::size_t{1});
+  for (std::size_t first = begin; first < end; first += grain) {
+    auto last = std::min(first + grain, end);
+    run(group, [&func, first, last]() {
+      for (auto i = first; i < last; ++i) {
+        func(i);
+      }
+    }, name);
+  }
+  wait(group);
+}
+
+void JobSystem::wait(JobGroup& group) const {
+  // help instead of blocking, prevents deadlocks when waiting inside jobs
+  while (group.m_pending > 0) {
+    if (!m_workers->runOne()) {
+      std::this_thread::yield();
+    }
+  }
+  std::exception_ptr error{};
+  {
+    // finishing thread releases lock after last access to group
+    std::lock_guard<std::mutex> lock{group.m_mutex};
+    std::swap(error, group.m_error);
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+std::size_t JobSystem::numWorkers() const {
+  return m_workers->threads.size();
+}
+
+void JobSystem::recordStatistics(Statistics& statistics) const {
+  std::vector<std::pair<std::string, double>> samples{};
+  {
+    std::lock_guard<std::mutex> lock{m_workers->mutex_samples};
+    std::swap(samples, m_workers->samples);
+  }
+  auto& handles = m_workers->handles_stats;
+  if (m_workers->statistics != &statistics) {
+    m_workers->statistics = &statistics;
+    handles.clear();
+  }
+  for (auto const& sample : samples) {
+    auto iter = handles.find(sample.first);
+    if (iter == handles.end()) {
+      iter = handles.emplace(sample.first, statistics.addAverager("job_" + sample.first)).first;
+    }
+    statistics.add(iter->second, sample.second);
+  }
+}
+
+std::size_t JobSystem::numHardwareWorkers() {
+  return std::size_t(std::max(1u, std::thread::hardware_concurrency()) - 1);
+}
+
+JobGroup::JobGroup()
+ :m_pending{0}
+ ,m_continuations{}
+ ,m_error{}
+ ,m_mutex{}
+{}
+
+bool JobGroup::finished() const {
+  return m_pending == 0;
+}
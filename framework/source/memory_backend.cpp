@@ -0,0 +1,69 @@
+#include "memory_backend.hpp"
+
+#include "wrap/device.hpp"
+
+#include <stdexcept>
+
+DeviceMemoryBackend::DeviceMemoryBackend(Device const& device)
+ :m_device{device.get()}
+{}
+
+vk::DeviceMemory DeviceMemoryBackend::allocate(uint32_t type_index, vk::DeviceSize const& size) {
+  vk::MemoryAllocateInfo info{};
+  info.allocationSize = size;
+  info.memoryTypeIndex = type_index;
+  return m_device.allocateMemory(info);
+}
+
+void DeviceMemoryBackend::free(vk::DeviceMemory const& memory) {
+  m_device.freeMemory(memory);
+}
+
+uint8_t* DeviceMemoryBackend::map(vk::DeviceMemory const& memory, vk::DeviceSize const& size, vk::DeviceSize const& offset) {
+  return (uint8_t*)m_device.mapMemory(memory, offset, size);
+}
+
+void DeviceMemoryBackend::unmap(vk::DeviceMemory const& memory) {
+  m_device.unmapMemory(memory);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+HostMemoryBackend::HostMemoryBackend()
+ :m_next_handle{1}
+ ,m_blocks{}
+{}
+
+vk::DeviceMemory HostMemoryBackend::allocate(uint32_t type_index, vk::DeviceSize const& size) {
+  // handles only need to be unique, they are never dereferenced
+  auto handle = (VkDeviceMemory)(m_next_handle++);
+  m_blocks.emplace(handle, block_t{size, std::vector<uint8_t>{}});
+  return vk::DeviceMemory{handle};
+}
+
+void HostMemoryBackend::free(vk::DeviceMemory const& memory) {
+  if (m_blocks.erase(VkDeviceMemory(memory)) == 0) {
+    throw std::runtime_error{"memory block not allocated by backend"};
+  }
+}
+
+uint8_t* HostMemoryBackend::map(vk::DeviceMemory const& memory, vk::DeviceSize const& size, vk::DeviceSize const& offset) {
+  auto iter_block = m_blocks.find(VkDeviceMemory(memory));
+  if (iter_block == m_blocks.end()) {
+    throw std::runtime_error{"memory block not allocated by backend"};
+  }
+  auto& block = iter_block->second;
+  if (offset + size > block.size) {
+    throw std::out_of_range{"mapped range exceeds memory block"};
+  }
+  if (block.data.empty()) {
+    block.data.resize(size_t(block.size));
+  }
+  return block.data.data() + offset;
+}
+
+void HostMemoryBackend::unmap(vk::DeviceMemory const&) {}
+
+std::size_t HostMemoryBackend::numBlocks() const {
+  return m_blocks.size();
+}
@@ -0,0 +1,69 @@
+#include "memory_telemetry.hpp"
+
+#include "allocator.hpp"
+#include "allocator_concurrent.hpp"
+#include "statistics.hpp"
+#include "wrap/device.hpp"
+
+static double to_mb(vk::DeviceSize bytes) {
+  return double(bytes) / 1024.0 / 1024.0;
+}
+
+static const std::vector<std::string> METRICS_MEMORY{"reserved", "used", "overhead", "largest_free", "blocks", "fragmentation"};
+static const std::vector<std::string> METRICS_CONTENTION{"shared_locks", "contended_locks", "lock_wait"};
+
+MemoryTelemetry::MemoryTelemetry(Statistics& stats)
+ :m_stats{&stats}
+ ,m_allocators{}
+ ,m_contention{}
+ ,m_heaps{}
+{}
+
+std::vector<Handle> const& MemoryTelemetry::handles(std::map<void const*, source_t>& sources, void const* source, std::string const& name, std::vector<std::string> const& metrics) {
+  auto& entry = sources[source];
+  // another allocator may have been created at the address
+  if (entry.handles.empty() || entry.name != name) {
+    entry.name = name;
+    entry.handles.clear();
+    for (auto const& metric : metrics) {
+      entry.handles.emplace_back(m_stats->addAverager("mem_" + name + "_" + metric));
+    }
+  }
+  return entry.handles;
+}
+
+void MemoryTelemetry::record(std::string const& name, Allocator const& allocator) {
+  auto const& ids = handles(m_allocators, &allocator, name, METRICS_MEMORY);
+  m_stats->add(ids[0], to_mb(allocator.bytesReserved()));
+  m_stats->add(ids[1], to_mb(allocator.bytesUsed()));
+  m_stats->add(ids[2], to_mb(allocator.bytesOverhead()));
+  m_stats->add(ids[3], to_mb(allocator.largestFreeRange()));
+  m_stats->add(ids[4], double(allocator.numBlocks()));
+  m_stats->add(ids[5], allocator.fragmentation());
+}
+
+void MemoryTelemetry::recordContention(std::string const& name, ConcurrentAllocator const& allocator) {
+  auto const& ids = handles(m_contention, &allocator, name, METRICS_CONTENTION);
+  m_stats->add(ids[0], double(allocator.numLocks()));
+  m_stats->add(ids[1], double(allocator.numContended()));
+  m_stats->add(ids[2], allocator.timeContended());
+}
+
+void MemoryTelemetry::recordHeaps(Device const& device) {
+  auto heaps = device.memoryHeaps();
+  // heaps of a device do not change
+  if (m_heaps.size() != heaps.size() * 3) {
+    m_heaps.clear();
+    for (size_t i = 0; i < heaps.size(); ++i) {
+      auto prefix = "mem_heap" + std::to_string(i) + (heaps[i].device_local ? "_device_" : "_host_");
+      m_heaps.emplace_back(m_stats->addAverager(prefix + "size"));
+      m_heaps.emplace_back(m_stats->addAverager(prefix + "budget"));
+      m_heaps.emplace_back(m_stats->addAverager(prefix + "usage"));
+    }
+  }
+  for (size_t i = 0; i < heaps.size(); ++i) {
+    m_stats->add(m_heaps[i * 3], to_mb(heaps[i].size));
+    m_stats->add(m_heaps[i * 3 + 1], to_mb(heaps[i].budget));
+    m_stats->add(m_heaps[i * 3 + 2], to_mb(heaps[i].usage));
+  }
+}
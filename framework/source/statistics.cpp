@@ -0,0 +1,316 @@
+#include "statistics.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+const uint32_t SLOT_INVALID = ~0u;
+const uint64_t GENERATION_NONE = ~uint64_t{0};
+
+std::atomic<uint64_t> s_num_instances{0};
+// shard of the instance the thread recorded to last
+thread_local uint64_t t_id = 0;
+thread_local void* t_shard = nullptr;
+
+double to_ms(std::chrono::steady_clock::duration const& duration) {
+  return double(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()) / 1000.0 / 1000.0;
+}
+
+// only the owning thread writes, so no read-modify-write is needed
+template<typename T>
+void store_relaxed(std::atomic<T>& value, T const& value_new) {
+  value.store(value_new, std::memory_order_relaxed);
+}
+
+template<typename T>
+T load_relaxed(std::atomic<T> const& value) {
+  return value.load(std::memory_order_relaxed);
+}
+}
+
+// samples of one metric recorded by one thread in the current period
+struct Statistics::metric_t {
+  metric_t()
+   :generation{GENERATION_NONE}
+   ,sum{0.0}
+   ,sum_squares{0.0}
+   ,min{0.0}
+   ,max{0.0}
+   ,time_start{}
+  {
+    for (auto& bucket : buckets) {
+      store_relaxed(bucket, uint32_t{0});
+    }
+  }
+
+  std::atomic<uint64_t> generation;
+  std::array<std::atomic<uint32_t>, Histogram::NUM_BUCKETS> buckets;
+  std::atomic<double> sum;
+  std::atomic<double> sum_squares;
+  std::atomic<double> min;
+  std::atomic<double> max;
+  // only accessed by the owning thread
+  std::chrono::steady_clock::time_point time_start;
+};
+
+struct Statistics::shard_t {
+  shard_t(std::size_t capacity)
+   :owner{std::this_thread::get_id()}
+   ,metrics(capacity)
+  {
+    for (auto& metric : metrics) {
+      store_relaxed(metric, static_cast<metric_t*>(nullptr));
+    }
+  }
+
+  ~shard_t() {
+    for (auto& metric : metrics) {
+      delete load_relaxed(metric);
+    }
+  }
+
+  // a thread reusing the id of a finished one takes over its shard
+  std::thread::id owner;
+  // allocated on first sample of the slot
+  std::vector<std::atomic<metric_t*>> metrics;
+};
+
+Statistics::Statistics(std::size_t capacity)
+ :m_capacity{capacity}
+ ,m_id{++s_num_instances}
+ ,m_mutex{}
+ ,m_slots{}
+ ,m_totals{}
+ ,m_shards{}
+ ,m_tables{}
+ ,m_table{nullptr}
+ ,m_generation{0}
+{
+  m_tables.emplace_back(new std::vector<uint32_t>{});
+  m_table.store(m_tables.back().get());
+}
+
+Statistics::~Statistics() {}
+
+Handle Statistics::addTimer(std::string const& name) {
+  return addAverager(name);
+}
+
+Handle Statistics::addAverager(std::string const& name) {
+  Handle handle{name};
+  std::lock_guard<std::mutex> lock{m_mutex};
+  if (m_slots.find(name) != m_slots.end()) return handle;
+  if (m_slots.size() >= m_capacity) {
+    throw std::runtime_error{"statistics capacity of " + std::to_string(m_capacity) + " exceeded by '" + name + "'"};
+  }
+  auto slot_new = uint32_t(m_slots.size());
+  // readers may still use the current table, so it is copied
+  std::unique_ptr<std::vector<uint32_t>> table{new std::vector<uint32_t>{*m_table.load()}};
+  if (table->size() <= handle.index()) {
+    table->resize(handle.index() + 1, SLOT_INVALID);
+  }
+  (*table)[handle.index()] = slot_new;
+  m_slots.emplace(name, slot_new);
+  m_totals.emplace_back();
+  m_tables.emplace_back(std::move(table));
+  m_table.store(m_tables.back().get(), std::memory_order_release);
+  return handle;
+}
+
+void Statistics::start(std::string const& name) {
+  metric(slotLocked(name)).time_start = std::chrono::steady_clock::now();
+}
+
+void Statistics::start(Handle const& handle) {
+  metric(slot(handle)).time_start = std::chrono::steady_clock::now();
+}
+
+void Statistics::stop(std::string const& name) {
+  auto& acc = metric(slotLocked(name));
+  record(acc, to_ms(std::chrono::steady_clock::now() - acc.time_start));
+}
+
+void Statistics::stop(Handle const& handle) {
+  auto& acc = metric(slot(handle));
+  record(acc, to_ms(std::chrono::steady_clock::now() - acc.time_start));
+}
+
+double Statistics::stopValue(std::string const& name) {
+  return to_ms(std::chrono::steady_clock::now() - metric(slotLocked(name)).time_start);
+}
+
+double Statistics::stopValue(Handle const& handle) {
+  return to_ms(std::chrono::steady_clock::now() - metric(slot(handle)).time_start);
+}
+
+void Statistics::add(std::string const& name, double value) {
+  record(metric(slotLocked(name)), value);
+}
+
+void Statistics::add(Handle const& handle, double value) {
+  record(metric(slot(handle)), value);
+}
+
+void Statistics::record(metric_t& acc, double value) {
+  auto generation = m_generation.load(std::memory_order_relaxed);
+  if (load_relaxed(acc.generation) != generation) {
+    for (auto& bucket : acc.buckets) {
+      store_relaxed(bucket, uint32_t{0});
+    }
+    store_relaxed(acc.sum, 0.0);
+    store_relaxed(acc.sum_squares, 0.0);
+    store_relaxed(acc.min, std::numeric_limits<double>::max());
+    store_relaxed(acc.max, std::numeric_limits<double>::lowest());
+    // readers only merge accumulators of the current period
+    acc.generation.store(generation, std::memory_order_release);
+  }
+  auto& bucket = acc.buckets[Histogram::bucket(value)];
+  store_relaxed(bucket, load_relaxed(bucket) + 1);
+  store_relaxed(acc.sum, load_relaxed(acc.sum) + value);
+  store_relaxed(acc.sum_squares, load_relaxed(acc.sum_squares) + value * value);
+  if (value < load_relaxed(acc.min)) {
+    store_relaxed(acc.min, value);
+  }
+  if (value > load_relaxed(acc.max)) {
+    store_relaxed(acc.max, value);
+  }
+}
+
+uint32_t Statistics::slot(Handle const& handle) const {
+  auto const& table = *m_table.load(std::memory_order_acquire);
+  if (handle.index() >= table.size() || table[handle.index()] == SLOT_INVALID) {
+    throw std::out_of_range{"statistic '" + handle.name() + "' does not exist"};
+  }
+  return table[handle.index()];
+}
+
+uint32_t Statistics::slot(std::string const& name) const {
+  auto iter = m_slots.find(name);
+  if (iter == m_slots.end()) {
+    throw std::out_of_range{"statistic '" + name + "' does not exist"};
+  }
+  return iter->second;
+}
+
+uint32_t Statistics::slotLocked(std::string const& name) const {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  return slot(name);
+}
+
+Statistics::metric_t& Statistics::metric(uint32_t slot) {
+  if (t_id != m_id) {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    shard_t* shard = nullptr;
+    for (auto const& shard_other : m_shards) {
+      if (shard_other->owner == std::this_thread::get_id()) {
+        shard = shard_other.get();
+      }
+    }
+    if (!shard) {
+      m_shards.emplace_back(new shard_t{m_capacity});
+      shard = m_shards.back().get();
+    }
+    t_id = m_id;
+    t_shard = shard;
+  }
+  auto& slot_metric = static_cast<shard_t*>(t_shard)->metrics[slot];
+  auto acc = load_relaxed(slot_metric);
+  if (!acc) {
+    acc = new metric_t{};
+    slot_metric.store(acc, std::memory_order_release);
+  }
+  return *acc;
+}
+
+Histogram Statistics::collect(uint32_t slot) const {
+  Histogram histogram{};
+  auto generation = m_generation.load(std::memory_order_relaxed);
+  for (auto const& shard : m_shards) {
+    auto acc = shard->metrics[slot].load(std::memory_order_acquire);
+    if (!acc || acc->generation.load(std::memory_order_acquire) != generation) continue;
+    // owner may be writing, fields can be one sample apart
+    for (uint32_t i = 0; i < Histogram::NUM_BUCKETS; ++i) {
+      auto count = load_relaxed(acc->buckets[i]);
+      histogram.m_buckets[i] += count;
+      histogram.m_count += count;
+    }
+    histogram.m_sum += load_relaxed(acc->sum);
+    histogram.m_sum_squares += load_relaxed(acc->sum_squares);
+    histogram.m_min = std::min(histogram.m_min, load_relaxed(acc->min));
+    histogram.m_max = std::max(histogram.m_max, load_relaxed(acc->max));
+  }
+  return histogram;
+}
+
+Statistics::summary_t Statistics::summarize(Histogram const& histogram) {
+  return summary_t{histogram.count(), histogram.mean(), std::sqrt(histogram.variance()), histogram.min(), histogram.max(), histogram.percentile(50.0), histogram.percentile(95.0), histogram.percentile(99.0)};
+}
+
+Statistics::summary_t Statistics::summary(std::string const& name) const {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  auto idx = slot(name);
+  auto histogram = collect(idx);
+  histogram.merge(m_totals[idx]);
+  return summarize(histogram);
+}
+
+double Statistics::get(std::string const& name) const {
+  return summary(name).mean;
+}
+
+double Statistics::max(std::string const& name) const {
+  return summary(name).max;
+}
+
+double Statistics::variance(std::string const& name) const {
+  auto deviation = summary(name).deviation;
+  return deviation * deviation;
+}
+
+double Statistics::percentile(std::string const& name, double percent) const {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  auto idx = slot(name);
+  auto histogram = collect(idx);
+  histogram.merge(m_totals[idx]);
+  return histogram.percentile(percent);
+}
+
+bool Statistics::contains(std::string const& name) const {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  return m_slots.find(name) != m_slots.end();
+}
+
+std::map<std::string, Statistics::summary_t> Statistics::snapshot() const {
+  std::map<std::string, summary_t> summaries{};
+  std::lock_guard<std::mutex> lock{m_mutex};
+  for (auto const& pair_slot : m_slots) {
+    auto histogram = collect(pair_slot.second);
+    if (histogram.count() > 0) {
+      summaries.emplace(pair_slot.first, summarize(histogram));
+    }
+  }
+  return summaries;
+}
+
+void Statistics::reset() {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  for (auto const& pair_slot : m_slots) {
+    m_totals[pair_slot.second].merge(collect(pair_slot.second));
+  }
+  m_generation.fetch_add(1);
+}
+
+void Statistics::print(std::ostream& os, std::string const& prefix) const {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  for (auto const& pair_slot : m_slots) {
+    if (pair_slot.first.compare(0, prefix.size(), prefix) != 0) continue;
+    auto histogram = collect(pair_slot.second);
+    histogram.merge(m_totals[pair_slot.second]);
+    os << pair_slot.first << ": " << histogram.mean() << ", max " << histogram.max() << std::endl;
+  }
+}
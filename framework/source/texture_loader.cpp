@@ -13,8 +13,14 @@
 
 #include <gli/load.hpp>
  
+#include <atomic>
 #include <cstdint> 
+#include <cstdio>
 #include <cstring> 
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
 #include <stdexcept> 
 
 static std::string file_extension(const std::string& path) {
@@ -24,15 +30,137 @@ static std::string file_extension(const std::string& path) {
   return std::string{};
 }
 
+static std::vector<uint8_t> read_file(std::string const& file_path) {
+  std::ifstream file{file_path, std::ios::binary | std::ios::ate};
+  if (!file) {
+    throw std::runtime_error{"failed to open file " + file_path};
+  }
+  std::vector<uint8_t> file_data(std::size_t(file.tellg()));
+  file.seekg(0);
+  file.read(reinterpret_cast<char*>(file_data.data()), std::streamsize(file_data.size()));
+  return file_data;
+}
+
+// decoded textures cache, levels are stored consecutively after the header and level sizes
+const uint32_t CACHE_MAGIC = 0x43584554;
+// increase when layout or decoding changes
+const uint32_t CACHE_VERSION = 1;
+// start of level data, allows mapping the file and using levels in place
+const std::size_t CACHE_ALIGNMENT = 16;
+
+struct cache_header {
+  uint32_t magic;
+  uint32_t version;
+  // of source file content
+  uint64_t hash;
+  uint32_t format;
+  uint32_t width;
+  uint32_t height;
+  uint32_t depth;
+  uint32_t num_levels;
+  uint32_t padding;
+};
+
+// fnv-1a
+static uint64_t hash_bytes(std::vector<uint8_t> const& bytes) {
+  uint64_t hash = 14695981039346656037ull;
+  for (auto byte : bytes) {
+    hash ^= byte;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+static std::size_t cache_data_offset(uint32_t num_levels) {
+  auto size = sizeof(cache_header) + num_levels * sizeof(uint64_t);
+  return (size + CACHE_ALIGNMENT - 1) / CACHE_ALIGNMENT * CACHE_ALIGNMENT;
+}
+
+// returns false if the file is missing or belongs to other content
+static bool read_cache(std::string const& cache_path, uint64_t hash, pixel_data& pixels) {
+  std::ifstream file{cache_path, std::ios::binary | std::ios::ate};
+  if (!file) return false;
+  auto file_size = std::size_t(file.tellg());
+  file.seekg(0);
+
+  cache_header header{};
+  if (file_size < sizeof(header) || !file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+  if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION || header.hash != hash || header.num_levels == 0) return false;
+  if (file_size < cache_data_offset(header.num_levels)) return false;
+
+  std::vector<uint64_t> level_sizes(header.num_levels);
+  file.read(reinterpret_cast<char*>(level_sizes.data()), std::streamsize(level_sizes.size() * sizeof(uint64_t)));
+  std::vector<std::size_t> level_bytes{};
+  std::size_t size = 0;
+  for (auto level_size : level_sizes) {
+    level_bytes.emplace_back(std::size_t(level_size));
+    size += std::size_t(level_size);
+  }
+  if (file_size != cache_data_offset(header.num_levels) + size) return false;
+
+  // levels are read at once without conversion
+  std::vector<uint8_t> texture_data(size);
+  file.seekg(std::streamoff(cache_data_offset(header.num_levels)));
+  if (!file.read(reinterpret_cast<char*>(texture_data.data()), std::streamsize(size))) return false;
+
+  pixels = pixel_data{texture_data, level_bytes, vk::Format(header.format), header.width, header.height, header.depth};
+  return true;
+}
+
+// failure only disables caching of this texture
+static void write_cache(std::string const& cache_path, uint64_t hash, pixel_data const& pixels) {
+  // unique name, textures with equal content may be written concurrently
+  // by this or another process sharing the cache, the random id tells processes apart
+  static const auto process_id = std::random_device{}();
+  static std::atomic<uint32_t> num_written{0};
+  auto temp_path = cache_path + "." + std::to_string(process_id) + "." + std::to_string(num_written++) + ".tmp";
+  {
+    std::ofstream file{temp_path, std::ios::binary};
+    if (!file) return;
+
+    cache_header header{};
+    header.magic = CACHE_MAGIC;
+    header.version = CACHE_VERSION;
+    header.hash = hash;
+    header.format = uint32_t(pixels.format);
+    header.width = pixels.extent.width;
+    header.height = pixels.extent.height;
+    header.depth = pixels.extent.depth;
+    header.num_levels = pixels.levels();
+    file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+
+    std::vector<uint64_t> level_sizes(pixels.level_bytes.begin(), pixels.level_bytes.end());
+    file.write(reinterpret_cast<char const*>(level_sizes.data()), std::streamsize(level_sizes.size() * sizeof(uint64_t)));
+    std::vector<char> padding(cache_data_offset(header.num_levels) - sizeof(header) - level_sizes.size() * sizeof(uint64_t), 0);
+    file.write(padding.data(), std::streamsize(padding.size()));
+    file.write(reinterpret_cast<char const*>(pixels.pixels.data()), std::streamsize(pixels.size()));
+    if (!file) {
+      file.close();
+      std::remove(temp_path.c_str());
+      return;
+    }
+  }
+  // readers never see partially written files
+  if (std::rename(temp_path.c_str(), cache_path.c_str()) != 0) {
+    std::remove(temp_path.c_str());
+  }
+}
+
+static std::string to_hex(uint64_t value) {
+  std::ostringstream stream{};
+  stream << std::hex << std::setw(16) << std::setfill('0') << value;
+  return stream.str();
+}
+
 namespace texture_loader {
-pixel_data stb(std::string const& file_path) {
+pixel_data stb(std::vector<uint8_t> const& file_data, std::string const& file_path) {
     // match to opengl representation
   stbi_set_flip_vertically_on_load(true);
   uint8_t* data_ptr;
   int width = 0;
   int height = 0;
   int format = STBI_default;
-  data_ptr = stbi_load(file_path.c_str(), &width, &height, &format, STBI_rgb_alpha);
+  data_ptr = stbi_load_from_memory(file_data.data(), int(file_data.size()), &width, &height, &format, STBI_rgb_alpha);
 
   if(!data_ptr) {
     throw std::logic_error(std::string{"stb_image: "} + file_path + " - " + stbi_failure_reason());
@@ -79,21 +207,38 @@ pixel_data gli(std::string const& file_path) {
   auto gli_format = tex.format();
   auto format_ptr = reinterpret_cast<vk::Format*>(&gli_format);
 
-  std::vector<uint8_t> texture_data(tex.size(tex.base_level()));
-  // copy data to vector
-  std::memcpy(texture_data.data(), tex.data(), texture_data.size());
+  // copy all levels of first layer and face
+  std::vector<uint8_t> texture_data{};
+  std::vector<std::size_t> level_bytes{};
+  for (auto level = tex.base_level(); level <= tex.max_level(); ++level) {
+    auto data_ptr = static_cast<uint8_t const*>(tex.data(0, 0, level));
+    texture_data.insert(texture_data.end(), data_ptr, data_ptr + tex.size(level));
+    level_bytes.emplace_back(tex.size(level));
+  }
 
-  return pixel_data{texture_data, *format_ptr, uint32_t(tex.extent().x), uint32_t(tex.extent().y)};
+  return pixel_data{texture_data, level_bytes, *format_ptr, uint32_t(tex.extent().x), uint32_t(tex.extent().y)};
 }
 
-pixel_data file(std::string const& file_path) {
+pixel_data file(std::string const& file_path, std::string const& cache_dir) {
   auto extension = file_extension(file_path);
   if (extension == "dds" || extension == "ktx") {
     return gli(file_path);
   }
-  else {
-    return stb(file_path);
+
+  auto file_data = read_file(file_path);
+  if (cache_dir.empty()) {
+    return stb(file_data, file_path);
+  }
+  // identified by content, renamed or moved files still hit
+  auto hash = hash_bytes(file_data);
+  auto cache_path = cache_dir + to_hex(hash) + ".tex";
+  pixel_data pixels{};
+  if (read_cache(cache_path, hash, pixels)) {
+    return pixels;
   }
+  pixels = stb(file_data, file_path);
+  write_cache(cache_path, hash, pixels);
+  return pixels;
 };
 
 }
\ No newline at end of file
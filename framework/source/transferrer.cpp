@@ -3,24 +3,98 @@
 #include "wrap/memory.hpp"
 #include "wrap/device.hpp"
 #include "wrap/buffer.hpp"
+#include "wrap/fence.hpp"
+#include "wrap/image.hpp"
 #include "wrap/image_res.hpp"
 #include "wrap/buffer_view.hpp"
 #include "wrap/command_pool.hpp"
 #include "wrap/command_buffer.hpp"
 #include "allocator_static.hpp"
+#include "frame_handles.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <deque>
 #include <iostream>
+#include <string>
+#include <vector>
+
+vk::AccessFlags layout_to_access(vk::ImageLayout const& layout);
+
+// persistently mapped staging memory, shared by all batches
+const vk::DeviceSize RING_BYTES = 64 * 1024 * 1024;
+// larger uploads are split, batches holding more are submitted while recording
+const vk::DeviceSize CHUNK_BYTES = RING_BYTES / 4;
+// satisfies texel size of all formats
+const vk::DeviceSize STAGE_ALIGNMENT = 16;
+
+struct stage_t {
+  // destroy buffer before allocator
+  std::unique_ptr<StaticAllocator> allocator;
+  std::unique_ptr<Buffer> buffer;
+  uint8_t* ptr;
+};
+
+static stage_t create_stage(Device const& device, vk::DeviceSize size) {
+  stage_t stage{};
+  stage.buffer = std::unique_ptr<Buffer>{new Buffer{device, size, vk::BufferUsageFlagBits::eTransferSrc}};
+
+  auto mem_type = device.findMemoryType(stage.buffer->requirements().memoryTypeBits
+                              , vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+  stage.allocator = std::unique_ptr<StaticAllocator>{new StaticAllocator{device, mem_type, stage.buffer->requirements().size}};
+  stage.allocator->allocate(*stage.buffer);
+  stage.ptr = stage.allocator->map(*stage.buffer);
+  return stage;
+}
+
+// commands submitted together, staging ring is reclaimed when the fence signaled
+struct Transferrer::batch_t {
+  CommandBuffer command_buffer;
+  Fence fence;
+  vk::DeviceSize bytes_staged;
+  // ring position after last staged data
+  uint64_t ring_end;
+  transfer_token_t token;
+};
+
+struct Transferrer::batches_t {
+  std::mutex mutex;
+  std::unique_ptr<batch_t> recording;
+  // submitted, in submission order
+  std::deque<std::unique_ptr<batch_t>> pending;
+  std::vector<std::unique_ptr<batch_t>> free;
+  transfer_token_t token_next;
+  transfer_token_t token_complete;
+  std::size_t num_submits;
+  stage_t ring;
+  // total bytes, position is modulo ring size
+  uint64_t ring_written;
+  uint64_t ring_released;
+  std::size_t num_stalls;
+  // for commands not supported by the transfer queue, destroy pool last
+  std::unique_ptr<CommandPool> pool_graphics;
+  CommandBuffer command_buffer_graphics;
+  Fence fence_graphics;
+};
 
 Transferrer::Transferrer()
  :m_device{nullptr}
-{}
+ ,m_pool{nullptr}
+ ,m_batches{new batches_t{}}
+{
+  m_batches->token_next = 1;
+  m_batches->token_complete = 0;
+  m_batches->num_submits = 0;
+  m_batches->ring_written = 0;
+  m_batches->ring_released = 0;
+  m_batches->num_stalls = 0;
+}
 
 Transferrer::Transferrer(Device const& device, CommandPool& pool)
  :Transferrer{}
  {
   m_device = &device;
-  // create buffer for onetime commands
-  m_command_buffer_help = pool.createBuffer(vk::CommandBufferLevel::ePrimary);
+  m_pool = &pool;
  }
 
 Transferrer::Transferrer(Transferrer && dev)
@@ -29,6 +103,13 @@ Transferrer::Transferrer(Transferrer && dev)
   swap(dev);
  }
 
+Transferrer::~Transferrer() {
+  // command buffers and staging memory must not be in use when destroyed
+  if (m_device) {
+    waitAll();
+  }
+}
+
 Transferrer& Transferrer::operator=(Transferrer&& dev) {
   swap(dev);
   return *this;
@@ -37,43 +118,304 @@ Transferrer& Transferrer::operator=(Transferrer&& dev) {
 void Transferrer::swap(Transferrer& dev) {
   // WrapperDevice::swap(dev);
   std::swap(m_device, dev.m_device);
-  std::swap(m_command_buffer_help, dev.m_command_buffer_help);
-  std::swap(m_buffer_stage, dev.m_buffer_stage);
-  std::swap(m_allocator_stage, dev.m_allocator_stage);
+  std::swap(m_pool, dev.m_pool);
+  std::swap(m_batches, dev.m_batches);
 }
 
-void Transferrer::adjustStagingPool(vk::DeviceSize const& size) {
-  if (!m_buffer_stage || m_buffer_stage->size() < size) {
-    // create new staging buffer
-    m_buffer_stage = std::unique_ptr<Buffer>{new Buffer{*m_device, size, vk::BufferUsageFlagBits::eTransferSrc}};
-    
-    auto mem_type = m_device->findMemoryType(m_buffer_stage->requirements().memoryTypeBits 
-                                , vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
-    m_allocator_stage = std::unique_ptr<StaticAllocator>{new StaticAllocator{*m_device, mem_type, m_buffer_stage->requirements().size}};
-    m_allocator_stage->allocate(*m_buffer_stage);
+Transferrer::batch_t& Transferrer::recordingBatch() const {
+  auto& batches = *m_batches;
+  if (!batches.recording) {
+    if (batches.free.empty()) {
+      std::unique_ptr<batch_t> batch{new batch_t{}};
+      batch->command_buffer = m_pool->createBuffer(vk::CommandBufferLevel::ePrimary);
+      batch->fence = Fence{*m_device};
+      batches.free.emplace_back(std::move(batch));
+    }
+    batches.recording = std::move(batches.free.back());
+    batches.free.pop_back();
+
+    auto& batch = *batches.recording;
+    batch.token = batches.token_next++;
+    batch.bytes_staged = 0;
+    batch.ring_end = 0;
+    batch.command_buffer.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+    // order after transfers of previous batches
+    vk::MemoryBarrier barrier{};
+    barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+    barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite;
+    batch.command_buffer->pipelineBarrier(
+      vk::PipelineStageFlagBits::eTransfer,
+      vk::PipelineStageFlagBits::eTransfer,
+      vk::DependencyFlags{},
+      {barrier},
+      {},
+      {}
+    );
   }
+  return *batches.recording;
 }
 
-void Transferrer::uploadImageData(void const* data_ptr, vk::DeviceSize data_size, ImageLayers const& image, vk::ImageLayout const& newLayout) {
-  { //lock staging memory
-    std::lock_guard<std::mutex> lock{m_mutex_staging};
-    adjustStagingPool(data_size);
-    std::memcpy(m_allocator_stage->map(*m_buffer_stage), data_ptr, data_size);
-    transitionToLayout(image, vk::ImageLayout::eTransferDstOptimal);
-    copyBufferToImage(*m_buffer_stage, image, vk::ImageLayout::eTransferDstOptimal);
+BufferRegion Transferrer::stage(void const* data_ptr, vk::DeviceSize size) const {
+  auto& batches = *m_batches;
+  if (!batches.ring.buffer) {
+    batches.ring = create_stage(*m_device, RING_BYTES);
+  }
+  auto ring_size = batches.ring.buffer->size();
+  if (size > ring_size) {
+    throw std::runtime_error{"staging size " + std::to_string(size) + " exceeds ring size"};
+  }
+
+  vk::DeviceSize offset = 0;
+  uint64_t end = 0;
+  while (true) {
+    // start at ring begin when nothing is in flight
+    if (batches.ring_written == batches.ring_released) {
+      batches.ring_written = align_offset(batches.ring_written, ring_size);
+      batches.ring_released = batches.ring_written;
+    }
+    auto pos = batches.ring_written % ring_size;
+    offset = align_offset(pos, STAGE_ALIGNMENT);
+    // ranges must be contiguous, skip rest of ring
+    if (offset + size > ring_size) {
+      offset = 0;
+      end = batches.ring_written + (ring_size - pos) + size;
+    }
+    else {
+      end = batches.ring_written + (offset - pos) + size;
+    }
+    if (end - batches.ring_released <= ring_size) break;
+
+    // reclaim range of oldest batch
+    ++batches.num_stalls;
+    if (batches.pending.empty()) {
+      flushLocked();
+    }
+    retire(batches.pending.front()->token);
   }
+  batches.ring_written = end;
+  std::memcpy(batches.ring.ptr + offset, data_ptr, size);
 
-  transitionToLayout(image, vk::ImageLayout::eTransferDstOptimal, newLayout);
+  auto& batch = recordingBatch();
+  batch.ring_end = end;
+  batch.bytes_staged += size;
+  return BufferRegion{batches.ring.buffer->get(), size, offset};
 }
 
-void Transferrer::uploadBufferData(void const* data_ptr, BufferRegion const& buffer_view) {
-  { //lock staging memory and buffer
-    std::lock_guard<std::mutex> lock{m_mutex_staging};
-    adjustStagingPool(buffer_view.size());
-    std::memcpy(m_allocator_stage->map(*m_buffer_stage), data_ptr, buffer_view.size());
+transfer_token_t Transferrer::finishRecord(batch_t& batch) const {
+  auto token = batch.token;
+  if (batch.bytes_staged >= CHUNK_BYTES) {
+    flushLocked();
+  }
+  return token;
+}
 
-    copyBuffer(BufferRegion{m_buffer_stage->get(), buffer_view.size()}, buffer_view);
+transfer_token_t Transferrer::flushLocked() const {
+  auto& batches = *m_batches;
+  if (!batches.recording) {
+    // last submitted batch
+    return batches.token_next - 1;
   }
+  auto& batch = *batches.recording;
+  batch.command_buffer.end();
+  batch.fence.reset();
+
+  vk::SubmitInfo submitInfo{};
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers = &batch.command_buffer.get();
+  m_device->getQueue(frame_handles::transfer).submit({submitInfo}, batch.fence);
+  ++batches.num_submits;
+
+  batches.pending.emplace_back(std::move(batches.recording));
+  return batch.token;
+}
+
+void Transferrer::retire(transfer_token_t token) const {
+  auto& batches = *m_batches;
+  while (!batches.pending.empty()) {
+    auto& batch = *batches.pending.front();
+    if (batch.token <= token) {
+      batch.fence.wait();
+    }
+    else if (!batch.fence.signaled()) {
+      break;
+    }
+    batch.command_buffer->reset({});
+    batches.ring_released = std::max(batches.ring_released, batch.ring_end);
+    batches.token_complete = batch.token;
+    batches.free.emplace_back(std::move(batches.pending.front()));
+    batches.pending.pop_front();
+  }
+}
+
+static void record_mipmaps(CommandBuffer const& command_buffer, Image const& image, vk::ImageLayout const& layout_base, vk::ImageLayout const& layout_new) {
+  auto num_levels = image.info().mipLevels;
+  auto img = image.range().image();
+
+  vk::ImageMemoryBarrier barrier{};
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = img;
+  barrier.subresourceRange = image.range();
+  barrier.subresourceRange.levelCount = 1;
+
+  for (uint32_t level = 1; level < num_levels; ++level) {
+    // previous level was written by upload or blit
+    auto barrier_src = barrier;
+    barrier_src.subresourceRange.baseMipLevel = level - 1;
+    barrier_src.oldLayout = level == 1 ? layout_base : vk::ImageLayout::eTransferDstOptimal;
+    barrier_src.newLayout = vk::ImageLayout::eTransferSrcOptimal;
+    barrier_src.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+    barrier_src.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+    auto barrier_dst = barrier;
+    barrier_dst.subresourceRange.baseMipLevel = level;
+    barrier_dst.oldLayout = vk::ImageLayout::eUndefined;
+    barrier_dst.newLayout = vk::ImageLayout::eTransferDstOptimal;
+    barrier_dst.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+    command_buffer->pipelineBarrier(
+      vk::PipelineStageFlagBits::eTransfer,
+      vk::PipelineStageFlagBits::eTransfer,
+      vk::DependencyFlags{},
+      {},
+      {},
+      {barrier_src, barrier_dst}
+    );
+
+    auto layers_src = image.layers(level - 1);
+    auto layers_dst = image.layers(level);
+    vk::ImageBlit blit{};
+    blit.srcSubresource = layers_src;
+    blit.srcOffsets[1] = vk::Offset3D{int32_t(layers_src.extent().width), int32_t(layers_src.extent().height), int32_t(layers_src.extent().depth)};
+    blit.dstSubresource = layers_dst;
+    blit.dstOffsets[1] = vk::Offset3D{int32_t(layers_dst.extent().width), int32_t(layers_dst.extent().height), int32_t(layers_dst.extent().depth)};
+    command_buffer->blitImage(img, vk::ImageLayout::eTransferSrcOptimal, img, vk::ImageLayout::eTransferDstOptimal, {blit}, vk::Filter::eLinear);
+  }
+
+  // all but the last level were blit sources
+  std::vector<vk::ImageMemoryBarrier> barriers{};
+  if (num_levels > 1) {
+    barriers.emplace_back(barrier);
+    barriers.back().subresourceRange.levelCount = num_levels - 1;
+    barriers.back().oldLayout = vk::ImageLayout::eTransferSrcOptimal;
+    barriers.back().srcAccessMask = vk::AccessFlagBits::eTransferRead;
+  }
+  barriers.emplace_back(barrier);
+  barriers.back().subresourceRange.baseMipLevel = num_levels - 1;
+  barriers.back().oldLayout = num_levels > 1 ? vk::ImageLayout::eTransferDstOptimal : layout_base;
+  barriers.back().srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+  for (auto& barrier_level : barriers) {
+    barrier_level.newLayout = layout_new;
+    barrier_level.dstAccessMask = layout_to_access(layout_new);
+  }
+  command_buffer->pipelineBarrier(
+    vk::PipelineStageFlagBits::eTransfer,
+    vk::PipelineStageFlagBits::eAllCommands,
+    vk::DependencyFlags{},
+    {},
+    {},
+    barriers
+  );
+}
+
+transfer_token_t Transferrer::uploadBufferDataAsync(void const* data_ptr, BufferRegion const& buffer_view) {
+  std::lock_guard<std::mutex> lock{m_batches->mutex};
+  auto data = static_cast<uint8_t const*>(data_ptr);
+  transfer_token_t token = 0;
+  // stream through ring
+  for (vk::DeviceSize offset = 0; offset < buffer_view.size(); offset += CHUNK_BYTES) {
+    auto size = std::min(CHUNK_BYTES, buffer_view.size() - offset);
+    auto region_stage = stage(data + offset, size);
+    auto& batch = recordingBatch();
+    batch.command_buffer.copyBuffer(region_stage, BufferRegion{buffer_view.buffer(), size, buffer_view.offset() + offset});
+    token = finishRecord(batch);
+  }
+  return token;
+}
+
+transfer_token_t Transferrer::uploadImageDataAsync(void const* data_ptr, vk::DeviceSize data_size, ImageLayers const& image, vk::Format const& format, vk::ImageLayout const& newLayout) {
+  std::lock_guard<std::mutex> lock{m_batches->mutex};
+  recordingBatch().command_buffer.transitionLayout(image, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
+
+  auto data = static_cast<uint8_t const*>(data_ptr);
+  auto const& extent = image.extent();
+  // stream large 2d images in chunks of rows, others at once
+  // compressed images are split at block rows, which hold the data of several texel rows
+  auto rows_block = block_height(format);
+  uint32_t num_rows = extent.depth == 1 && data_size > CHUNK_BYTES ? (extent.height + rows_block - 1) / rows_block : 1;
+  auto bytes_row = data_size / num_rows;
+  auto rows_chunk = uint32_t(std::max(vk::DeviceSize{1}, CHUNK_BYTES / bytes_row));
+  for (uint32_t row = 0; row < num_rows; row += rows_chunk) {
+    auto rows = std::min(num_rows - row, rows_chunk);
+    auto region_stage = stage(data + row * bytes_row, rows * bytes_row);
+    auto copy = buffer_image_copy(region_stage, image);
+    if (num_rows > 1) {
+      // last block row may be partial
+      copy.imageOffset.y += int32_t(row * rows_block);
+      copy.imageExtent.height = std::min(rows * rows_block, extent.height - row * rows_block);
+    }
+    auto& batch = recordingBatch();
+    batch.command_buffer->copyBufferToImage(region_stage.buffer(), image.image(), vk::ImageLayout::eTransferDstOptimal, {copy});
+    finishRecord(batch);
+  }
+
+  auto& batch = recordingBatch();
+  batch.command_buffer.transitionLayout(image, vk::ImageLayout::eTransferDstOptimal, newLayout);
+  return finishRecord(batch);
+}
+
+transfer_token_t Transferrer::copyBufferAsync(BufferRegion const& src, BufferRegion const& dst) const {
+  std::lock_guard<std::mutex> lock{m_batches->mutex};
+  auto& batch = recordingBatch();
+  batch.command_buffer.copyBuffer(src, dst);
+  return finishRecord(batch);
+}
+
+transfer_token_t Transferrer::transitionToLayoutAsync(ImageRange const& img, vk::ImageLayout const& oldLayout, vk::ImageLayout const& newLayout) const {
+  std::lock_guard<std::mutex> lock{m_batches->mutex};
+  auto& batch = recordingBatch();
+  batch.command_buffer.transitionLayout(img, oldLayout, newLayout);
+  return finishRecord(batch);
+}
+
+transfer_token_t Transferrer::flush() const {
+  std::lock_guard<std::mutex> lock{m_batches->mutex};
+  return flushLocked();
+}
+
+bool Transferrer::isComplete(transfer_token_t token) const {
+  std::lock_guard<std::mutex> lock{m_batches->mutex};
+  retire(0);
+  return token <= m_batches->token_complete;
+}
+
+void Transferrer::wait(transfer_token_t token) const {
+  std::lock_guard<std::mutex> lock{m_batches->mutex};
+  if (m_batches->recording && token >= m_batches->recording->token) {
+    flushLocked();
+  }
+  retire(token);
+}
+
+void Transferrer::waitAll() const {
+  std::lock_guard<std::mutex> lock{m_batches->mutex};
+  retire(flushLocked());
+}
+
+std::size_t Transferrer::numSubmits() const {
+  std::lock_guard<std::mutex> lock{m_batches->mutex};
+  return m_batches->num_submits;
+}
+
+std::size_t Transferrer::numStagingStalls() const {
+  std::lock_guard<std::mutex> lock{m_batches->mutex};
+  return m_batches->num_stalls;
+}
+
+void Transferrer::uploadImageData(void const* data_ptr, vk::DeviceSize data_size, ImageLayers const& image, vk::Format const& format, vk::ImageLayout const& newLayout) {
+  wait(uploadImageDataAsync(data_ptr, data_size, image, format, newLayout));
+}
+
+void Transferrer::uploadBufferData(void const* data_ptr, BufferRegion const& buffer_view) {
+  wait(uploadBufferDataAsync(data_ptr, buffer_view));
 }
 
 void Transferrer::copyBuffer(BufferRegion const& src, BufferRegion const& dst) const {
@@ -107,35 +449,55 @@ void Transferrer::transitionToLayout(ImageRange const& img, vk::ImageLayout cons
   endSingleTimeCommands();
 }
 
-CommandBuffer const& Transferrer::beginSingleTimeCommands() const {
-  m_mutex_single_command.lock();
-  vk::CommandBufferBeginInfo beginInfo{};
-  beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
-
-  m_command_buffer_help->begin(beginInfo);
-
-  return m_command_buffer_help;
-}
+void Transferrer::generateMipmaps(std::vector<Image const*> const& images, vk::ImageLayout const& layout_base, vk::ImageLayout const& newLayout) const {
+  if (images.empty()) return;
+  std::lock_guard<std::mutex> lock{m_batches->mutex};
+  // base levels must be uploaded, queues are only ordered by the fence
+  retire(flushLocked());
 
-void Transferrer::endSingleTimeCommands() const {
-  m_command_buffer_help->end();
+  auto& batches = *m_batches;
+  if (!batches.pool_graphics) {
+    batches.pool_graphics = std::unique_ptr<CommandPool>{new CommandPool{*m_device, m_device->getQueueIndex("graphics"), vk::CommandPoolCreateFlagBits::eResetCommandBuffer | vk::CommandPoolCreateFlagBits::eTransient}};
+    batches.command_buffer_graphics = batches.pool_graphics->createBuffer(vk::CommandBufferLevel::ePrimary);
+    batches.fence_graphics = Fence{*m_device};
+  }
+  auto& command_buffer = batches.command_buffer_graphics;
+  command_buffer.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+  for (auto image : images) {
+    record_mipmaps(command_buffer, *image, layout_base, newLayout);
+  }
+  command_buffer.end();
 
+  batches.fence_graphics.reset();
   vk::SubmitInfo submitInfo{};
   submitInfo.commandBufferCount = 1;
-  submitInfo.pCommandBuffers = &m_command_buffer_help.get();
+  submitInfo.pCommandBuffers = &command_buffer.get();
+  m_device->getQueue(frame_handles::graphics).submit({submitInfo}, batches.fence_graphics);
+  ++batches.num_submits;
+  batches.fence_graphics.wait();
+  command_buffer->reset({});
+}
 
-  m_device->getQueue("transfer").submit({submitInfo}, nullptr);
-  m_device->getQueue("transfer").waitIdle();
-  m_command_buffer_help->reset({});
+CommandBuffer const& Transferrer::beginSingleTimeCommands() const {
+  m_batches->mutex.lock();
+  // commands may depend on recorded ones, which are only ordered by the next batch
+  flushLocked();
+  return recordingBatch().command_buffer;
+}
+
+void Transferrer::endSingleTimeCommands() const {
+  retire(flushLocked());
 
-  m_mutex_single_command.unlock();
+  m_batches->mutex.unlock();
 }
 
 void Transferrer::deallocate() {
-  m_buffer_stage.reset();
-  m_allocator_stage.reset();
+  std::lock_guard<std::mutex> lock{m_batches->mutex};
+  retire(flushLocked());
+  // recreated on next upload
+  m_batches->ring = stage_t{};
 }
 
 Device const& Transferrer::device() const {
   return *m_device;
-}
+}
\ No newline at end of file
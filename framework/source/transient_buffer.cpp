@@ -0,0 +1,77 @@
+#include "transient_buffer.hpp"
+
+#include "wrap/device.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+TransientBuffer::TransientBuffer()
+ :m_allocator{}
+ ,m_buffer{}
+ ,m_ptr{nullptr}
+ ,m_offset{0}
+ ,m_alignment{1}
+{}
+
+TransientBuffer::TransientBuffer(Device const& device, vk::DeviceSize size, vk::BufferUsageFlags const& usage)
+ :TransientBuffer{}
+{
+  m_buffer = Buffer{device, size, usage};
+  auto mem_type = device.findMemoryType(m_buffer.requirements().memoryTypeBits
+                              , vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+  m_allocator = std::unique_ptr<StaticAllocator>{new StaticAllocator{device, mem_type, m_buffer.requirements().size}};
+  m_allocator->allocate(m_buffer);
+  // stays mapped for whole lifetime
+  m_ptr = m_allocator->map(m_buffer);
+
+  auto limits = device.physical().getProperties().limits;
+  m_alignment = std::max(limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment);
+}
+
+TransientBuffer::TransientBuffer(TransientBuffer && rhs)
+ :TransientBuffer{}
+{
+  swap(rhs);
+}
+
+TransientBuffer& TransientBuffer::operator=(TransientBuffer&& rhs) {
+  swap(rhs);
+  return *this;
+}
+
+void TransientBuffer::swap(TransientBuffer& rhs) {
+  std::swap(m_allocator, rhs.m_allocator);
+  std::swap(m_buffer, rhs.m_buffer);
+  std::swap(m_ptr, rhs.m_ptr);
+  std::swap(m_offset, rhs.m_offset);
+  std::swap(m_alignment, rhs.m_alignment);
+}
+
+transient_alloc_t TransientBuffer::allocate(vk::DeviceSize size) {
+  return allocate(size, m_alignment);
+}
+
+transient_alloc_t TransientBuffer::allocate(vk::DeviceSize size, vk::DeviceSize alignment) {
+  auto offset = align_offset(m_offset, std::max(alignment, m_alignment));
+  if (offset + size > m_buffer.size()) {
+    throw std::length_error{"transient buffer of size " + std::to_string(m_buffer.size()) + " exhausted"};
+  }
+  m_offset = offset + size;
+  return transient_alloc_t{m_ptr + offset, BufferRegion{m_buffer.get(), size, offset}, uint32_t(offset)};
+}
+
+void TransientBuffer::reset() {
+  m_offset = 0;
+}
+
+Buffer const& TransientBuffer::buffer() const {
+  return m_buffer;
+}
+
+vk::DeviceSize TransientBuffer::size() const {
+  return m_buffer.size();
+}
+
+vk::DeviceSize TransientBuffer::used() const {
+  return m_offset;
+}
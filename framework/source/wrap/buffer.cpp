@@ -48,7 +48,7 @@ Buffer::Buffer(Buffer && buffer)
   swap(buffer);
 }
 
-Buffer::Buffer(Device const& device, vk::DeviceSize const& size, vk::BufferUsageFlags const& usage)
+Buffer::Buffer(Device const& device, vk::DeviceSize const& size, vk::BufferUsageFlags const& usage, vk::SharingMode const& sharing)
  :Buffer{}
 {
   m_device = device.get();
@@ -56,7 +56,7 @@ Buffer::Buffer(Device const& device, vk::DeviceSize const& size, vk::BufferUsage
   m_info.size = size;
   m_info.usage = usage;
   auto queueFamilies = device.ownerIndices();
-  if (queueFamilies.size() > 1) {
+  if (queueFamilies.size() > 1 && sharing == vk::SharingMode::eConcurrent) {
     m_info.sharingMode = vk::SharingMode::eConcurrent;
     m_info.queueFamilyIndexCount = std::uint32_t(queueFamilies.size());
     m_info.pQueueFamilyIndices = queueFamilies.data();
@@ -65,9 +65,14 @@ void CommandBuffer::bindPipeline(Pipeline const& pipeline) {
 
 void CommandBuffer::bindGeometry(Geometry const& geometry) {
   assert(m_recording);
-  get().bindVertexBuffers(0, {geometry.vertices().buffer()}, {geometry.vertices().offset()});
-  if (geometry.numIndices() > 0) {
-    get().bindIndexBuffer(geometry.indices().buffer(), geometry.indices().offset(), vk::IndexType::eUint32);
+  // buffers are bound from start, draws use element offsets
+  if (geometry.vertices().buffer() != m_session.buffer_vertices) {
+    get().bindVertexBuffers(0, {geometry.vertices().buffer()}, {0});
+    m_session.buffer_vertices = geometry.vertices().buffer();
+  }
+  if (geometry.numIndices() > 0 && geometry.indices().buffer() != m_session.buffer_indices) {
+    get().bindIndexBuffer(geometry.indices().buffer(), 0, vk::IndexType::eUint32);
+    m_session.buffer_indices = geometry.indices().buffer();
   }
 
   m_session.geometry = &geometry;
@@ -195,6 +200,48 @@ void CommandBuffer::bufferBarrier(BufferRegion const& region, vk::PipelineStageF
   );
 }
 
+void CommandBuffer::releaseBuffer(BufferRegion const& region, uint32_t family_src, uint32_t family_dst, vk::PipelineStageFlags stage_src, vk::AccessFlags const& acc_src) const {
+  if (family_src == family_dst) return;
+  vk::BufferMemoryBarrier barrier{};
+  barrier.buffer = region.buffer();
+  barrier.size = region.size();
+  barrier.offset = region.offset();
+  // visibility is established by the acquire
+  barrier.srcAccessMask = acc_src;
+  barrier.srcQueueFamilyIndex = family_src;
+  barrier.dstQueueFamilyIndex = family_dst;
+
+  get().pipelineBarrier(
+    stage_src,
+    vk::PipelineStageFlagBits::eBottomOfPipe,
+    vk::DependencyFlags{},
+    {},
+    {barrier},
+    {}
+  );
+}
+
+void CommandBuffer::acquireBuffer(BufferRegion const& region, uint32_t family_src, uint32_t family_dst, vk::PipelineStageFlags stage_dst, vk::AccessFlags const& acc_dst) const {
+  if (family_src == family_dst) return;
+  vk::BufferMemoryBarrier barrier{};
+  barrier.buffer = region.buffer();
+  barrier.size = region.size();
+  barrier.offset = region.offset();
+  // availability was established by the release
+  barrier.dstAccessMask = acc_dst;
+  barrier.srcQueueFamilyIndex = family_src;
+  barrier.dstQueueFamilyIndex = family_dst;
+
+  get().pipelineBarrier(
+    vk::PipelineStageFlagBits::eTopOfPipe,
+    stage_dst,
+    vk::DependencyFlags{},
+    {},
+    {barrier},
+    {}
+  );
+}
+
 void CommandBuffer::pushConstants(vk::ShaderStageFlags stage, uint32_t offset, uint32_t size, const void* pValues) {
   get().pushConstants(m_session.pipe_layout, stage, offset, size, pValues);
 }
@@ -59,10 +59,10 @@ void DescriptorSet::bind(uint32_t binding, uint32_t index_base, vk::ArrayProxy<B
   m_device.updateDescriptorSets({info_write}, 0);
 }
 
-void DescriptorSet::bind(uint32_t binding, uint32_t index_base, vk::ArrayProxy<BufferView const> const& views, vk::DescriptorType const& type) const {
+void DescriptorSet::bind(uint32_t binding, uint32_t index_base, vk::ArrayProxy<BufferRegion const> const& regions, vk::DescriptorType const& type) const {
   std::vector<vk::DescriptorBufferInfo> infos{};
-  for(auto const& view : views) {
-    infos.emplace_back(view.buffer(), view.offset(), view.size());
+  for(auto const& region : regions) {
+    infos.emplace_back(region.buffer(), region.offset(), region.size());
   }
 
   vk::WriteDescriptorSet descriptorWrite{};
@@ -4,16 +4,18 @@
 
 #include <vulkan/vulkan.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <vector>
 #include <set>
 
-uint32_t find_queue_family(vk::PhysicalDevice device, vk::QueueFlags const& flags) {
+// prefers a family without the excluded capabilities, which is dedicated to the work
+uint32_t find_queue_family(vk::PhysicalDevice device, vk::QueueFlags const& flags, vk::QueueFlags const& excluded) {
   auto queue_families = device.getQueueFamilyProperties();
   // find optimal queue
   for (size_t i = 0; i < queue_families.size(); ++i) {
-    // flags must be identical
-    if (queue_families[i].queueCount > 0 && queue_families[i].queueFlags == flags) {
+    // other flags like sparse binding do not matter
+    if (queue_families[i].queueCount > 0 && (queue_families[i].queueFlags & flags) == flags && !(queue_families[i].queueFlags & excluded)) {
         return uint32_t(i);
     }
   }
@@ -33,6 +35,14 @@ Device::Device()
  ,m_queue_indices{}
  ,m_queues{}
  ,m_extensions{}
+ ,m_indirect_first_instance{false}
+#ifdef VK_EXT_memory_budget
+ ,m_query_budget{nullptr}
+#endif
+#ifdef VK_KHR_timeline_semaphore
+ ,m_wait_semaphores{nullptr}
+ ,m_semaphore_value{nullptr}
+#endif
 {}
 
 Device::Device(vk::PhysicalDevice const& phys_dev, QueueFamilyIndices const& queues, std::vector<const char*> const& deviceExtensions)
@@ -44,7 +54,9 @@ Device::Device(vk::PhysicalDevice const& phys_dev, QueueFamilyIndices const& que
   if (queues.presentFamily >= 0) {
     m_queue_indices.emplace("present", queues.presentFamily);
   }
-  m_queue_indices.emplace("transfer", find_queue_family(physical(), vk::QueueFlagBits::eTransfer));
+  m_queue_indices.emplace("transfer", find_queue_family(physical(), vk::QueueFlagBits::eTransfer, vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute));
+  // dedicated family if available, for compute overlapping graphics work
+  m_queue_indices.emplace("compute", find_queue_family(physical(), vk::QueueFlagBits::eCompute, vk::QueueFlagBits::eGraphics));
   // m_queue_indices.emplace("transfer", queues.graphicsFamily);
 
   std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos;
@@ -54,6 +66,7 @@ Device::Device(vk::PhysicalDevice const& phys_dev, QueueFamilyIndices const& que
   }
   // reserve enough space for all queues
   std::vector<float> queue_priorities(m_queue_indices.size(), 1.0f);
+  auto queue_families = phys_dev.getQueueFamilyProperties();
   for (int queueFamily : uniqueQueueFamilies) {
     uint num = 0;
     for(auto const& index : m_queue_indices) {
@@ -61,6 +74,8 @@ Device::Device(vk::PhysicalDevice const& phys_dev, QueueFamilyIndices const& que
         ++num;
       }      
     }
+    // names share queues if the family has fewer
+    num = std::min(num, queue_families[queueFamily].queueCount);
     vk::DeviceQueueCreateInfo queueCreateInfo{};
     queueCreateInfo.queueFamilyIndex = queueFamily;
     queueCreateInfo.queueCount = num;
@@ -76,21 +91,46 @@ Device::Device(vk::PhysicalDevice const& phys_dev, QueueFamilyIndices const& que
   deviceFeatures.wideLines = true;
   deviceFeatures.independentBlend = true;
   deviceFeatures.multiDrawIndirect = true;
+  // instance offsets in indirect draws, optional
+  m_indirect_first_instance = bool(phys_dev.getFeatures().drawIndirectFirstInstance);
+  deviceFeatures.drawIndirectFirstInstance = m_indirect_first_instance;
   m_info.pQueueCreateInfos = queueCreateInfos.data();
   m_info.queueCreateInfoCount = uint32_t(queueCreateInfos.size());
   m_info.pEnabledFeatures = &deviceFeatures;
 
   m_info.enabledExtensionCount = uint32_t(deviceExtensions.size());
   m_info.ppEnabledExtensionNames = deviceExtensions.data();
+#ifdef VK_KHR_timeline_semaphore
+  // extension is only added by instance if feature is available
+  VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timeline_features{};
+  timeline_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+  timeline_features.timelineSemaphore = VK_TRUE;
+  bool timeline = false;
+  for (auto const& extension : deviceExtensions) {
+    if (std::string{extension} == VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME) {
+      timeline = true;
+      m_info.pNext = &timeline_features;
+    }
+  }
+#endif
 
   m_object = phys_dev.createDevice(info());
+#ifdef VK_KHR_timeline_semaphore
+  // features are local
+  m_info.pNext = nullptr;
+  if (timeline) {
+    m_wait_semaphores = PFN_vkWaitSemaphoresKHR(get().getProcAddr("vkWaitSemaphoresKHR"));
+    m_semaphore_value = PFN_vkGetSemaphoreCounterValueKHR(get().getProcAddr("vkGetSemaphoreCounterValueKHR"));
+  }
+#endif
 
   std::map<int, uint> num_used{};
   for(auto const& index : m_queue_indices) {
     if(num_used.find(index.second) == num_used.end()) {
       num_used.emplace(index.second, 0);
     }
-    m_queues.emplace(index.first, get().getQueue(index.second, num_used.at(index.second)));
+    auto idx_queue = std::min(num_used.at(index.second), queue_families[index.second].queueCount - 1);
+    m_queues.emplace(index.first, get().getQueue(index.second, idx_queue));
     ++num_used.at(index.second);
   }
   // hack to keep compatibility with worker apps that wait on present queue
@@ -137,6 +177,50 @@ void Device::destroy() {
   std::swap(m_queues, dev.m_queues);
   std::swap(m_queue_indices, dev.m_queue_indices);
   std::swap(m_extensions, dev.m_extensions);
+  std::swap(m_indirect_first_instance, dev.m_indirect_first_instance);
+#ifdef VK_EXT_memory_budget
+  std::swap(m_query_budget, dev.m_query_budget);
+#endif
+#ifdef VK_KHR_timeline_semaphore
+  std::swap(m_wait_semaphores, dev.m_wait_semaphores);
+  std::swap(m_semaphore_value, dev.m_semaphore_value);
+#endif
+}
+
+std::vector<heap_budget_t> Device::memoryHeaps() const {
+  auto properties = physical().getMemoryProperties();
+  std::vector<heap_budget_t> heaps{};
+  for (uint32_t i = 0; i < properties.memoryHeapCount; ++i) {
+    auto const& heap = properties.memoryHeaps[i];
+    heaps.emplace_back(heap_budget_t{heap.size, heap.size, 0, bool(heap.flags & vk::MemoryHeapFlagBits::eDeviceLocal)});
+  }
+#ifdef VK_EXT_memory_budget
+  if (m_query_budget != nullptr) {
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{};
+    budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    VkPhysicalDeviceMemoryProperties2KHR properties_2{};
+    properties_2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR;
+    properties_2.pNext = &budget;
+    m_query_budget(physical(), &properties_2);
+    for (size_t i = 0; i < heaps.size(); ++i) {
+      heaps[i].budget = budget.heapBudget[i];
+      heaps[i].usage = budget.heapUsage[i];
+    }
+  }
+#endif
+  return heaps;
+}
+
+bool Device::supportsTimeline() const {
+#ifdef VK_KHR_timeline_semaphore
+  return m_wait_semaphores != nullptr;
+#else
+  return false;
+#endif
+}
+
+bool Device::supportsIndirectFirstInstance() const {
+  return m_indirect_first_instance;
 }
 
 vk::PhysicalDevice const& Device::physical() const {
@@ -146,6 +230,9 @@ vk::PhysicalDevice const& Device::physical() const {
 vk::Queue const& Device::getQueue(std::string const& name) const {
   return m_queues.at(name);
 }
+vk::Queue const& Device::getQueue(Handle const& handle) const {
+  return m_queues.at(handle);
+}
 uint32_t Device::getQueueIndex(std::string const& name) const {
   return m_queue_indices.at(name);
 }
@@ -39,6 +39,10 @@ void Fence::reset() {
   m_device.resetFences(get());
 }
 
+bool Fence::signaled() const {
+  return m_device.getFenceStatus(get()) == vk::Result::eSuccess;
+}
+
 Fence& Fence::operator=(Fence&& Fence) {
   swap(Fence);
   return *this;
@@ -5,6 +5,7 @@
 #include "wrap/device.hpp"
 #include "wrap/memory.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 bool is_depth(vk::Format const& format) {
@@ -18,6 +19,34 @@ bool has_stencil(vk::Format const& format) {
   return format == vk::Format::eD32SfloatS8Uint || format == vk::Format::eD24UnormS8Uint;
 }
 
+uint32_t block_height(vk::Format const& format) {
+  auto value = static_cast<VkFormat>(format);
+  // bc, etc2 and eac use 4x4 blocks
+  if (value >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && value <= VK_FORMAT_EAC_R11G11_SNORM_BLOCK) {
+    return 4;
+  }
+  if (value >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK && value <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK) {
+    // unorm and srgb variant of each block size
+    static const uint32_t heights[] = {4, 4, 5, 5, 6, 5, 6, 8, 5, 6, 8, 10, 10, 12};
+    return heights[(value - VK_FORMAT_ASTC_4x4_UNORM_BLOCK) / 2];
+  }
+#ifdef VK_IMG_format_pvrtc
+  if (value >= VK_FORMAT_PVRTC1_2BPP_UNORM_BLOCK_IMG && value <= VK_FORMAT_PVRTC2_4BPP_SRGB_BLOCK_IMG) {
+    return 4;
+  }
+#endif
+  return 1;
+}
+
+uint32_t mip_levels(vk::Extent3D const& extent) {
+  auto size = std::max(std::max(extent.width, extent.height), extent.depth);
+  uint32_t levels = 1;
+  while (size >>= 1) {
+    ++levels;
+  }
+  return levels;
+}
+
 vk::Format findSupportedFormat(vk::PhysicalDevice const& physicalDevice, std::vector<vk::Format> const& candidates, vk::ImageTiling const& tiling, vk::FormatFeatureFlags const& features) {
   // prefer optimal tiling
   for (auto const& format : candidates) {
@@ -4,6 +4,7 @@
 #include "wrap/device.hpp"
 #include "wrap/memory.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 BackedImage::BackedImage()
@@ -18,7 +19,7 @@ BackedImage::BackedImage(BackedImage && dev)
   swap(dev);
 }
 
-BackedImage::BackedImage(Device const& device,  vk::Extent3D const& extent, vk::Format const& format, vk::ImageTiling const& tiling, vk::ImageUsageFlags const& usage) 
+BackedImage::BackedImage(Device const& device,  vk::Extent3D const& extent, vk::Format const& format, vk::ImageTiling const& tiling, vk::ImageUsageFlags const& usage, uint32_t levels) 
  :BackedImage{}
 {  
   m_device = device.get();
@@ -36,7 +37,7 @@ BackedImage::BackedImage(Device const& device,  vk::Extent3D const& extent, vk::
   }
 
   m_info.extent = extent;
-  m_info.mipLevels = 1;
+  m_info.mipLevels = levels;
   m_info.arrayLayers = 1;
   m_info.format = format;
   m_info.tiling = tiling;
@@ -125,5 +126,8 @@ BackedImage::operator ImageLayers() const {
 
 ImageLayers BackedImage::layers(uint32_t level) const {
   vk::ImageSubresourceLayers layers{format_to_aspect(format()), level, 0, m_info.arrayLayers};
-  return ImageLayers{get(), layers, extent()};
+  // each level halves the extent
+  auto const& extent_base = extent();
+  vk::Extent3D extent_level{std::max(extent_base.width >> level, 1u), std::max(extent_base.height >> level, 1u), std::max(extent_base.depth >> level, 1u)};
+  return ImageLayers{get(), layers, extent_level};
 }
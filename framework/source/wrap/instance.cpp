@@ -90,6 +90,7 @@ bool isDeviceSuitable(vk::PhysicalDevice const& device, vk::SurfaceKHR const& su
 Instance::Instance()
  :Wrapper<vk::Instance, vk::InstanceCreateInfo>{}
  // ,m_validate{validate}
+ ,m_properties_2{false}
  ,m_layers{"VK_LAYER_LUNARG_standard_validation"}
 {}
 
@@ -124,6 +125,15 @@ void Instance::create(bool validate) {
   }
 
   auto extensions = getRequiredExtensions(validate);
+#ifdef VK_EXT_memory_budget
+  // optional, only used for memory telemetry
+  for (auto const& extension : vk::enumerateInstanceExtensionProperties()) {
+    if (std::string{extension.extensionName} == VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) {
+      extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+      m_properties_2 = true;
+    }
+  }
+#endif
   createInfo.enabledExtensionCount = uint32_t(extensions.size());
   createInfo.ppEnabledExtensionNames = extensions.data();
 
@@ -163,7 +173,35 @@ Device Instance::createLogicalDevice(std::vector<const char*> const& deviceExten
 
   auto const& phys_device = pickPhysicalDevice(deviceExtensions, surface);
   QueueFamilyIndices indices = findQueueFamilies(phys_device, surface);
+#ifdef VK_EXT_memory_budget
+  auto extensions = deviceExtensions;
+  bool budget = m_properties_2 && checkDeviceExtensionSupport(phys_device, {VK_EXT_MEMORY_BUDGET_EXTENSION_NAME});
+  if (budget) {
+    extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+  }
+#ifdef VK_KHR_timeline_semaphore
+  // optional, replaces fences for frame synchronisation
+  if (m_properties_2 && checkDeviceExtensionSupport(phys_device, {VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME})) {
+    VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timeline{};
+    timeline.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+    VkPhysicalDeviceFeatures2KHR features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+    features.pNext = &timeline;
+    auto query_features = PFN_vkGetPhysicalDeviceFeatures2KHR(get().getProcAddr("vkGetPhysicalDeviceFeatures2KHR"));
+    query_features(phys_device, &features);
+    if (timeline.timelineSemaphore) {
+      extensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+    }
+  }
+#endif
+  Device device{phys_device, indices, extensions};
+  if (budget) {
+    device.m_query_budget = PFN_vkGetPhysicalDeviceMemoryProperties2KHR(get().getProcAddr("vkGetPhysicalDeviceMemoryProperties2KHR"));
+  }
+  return device;
+#else
   return Device{phys_device, indices, deviceExtensions};
+#endif
 }
 
 void Instance::destroy() { 
@@ -30,6 +30,9 @@ Sampler::Sampler(Device const& device, vk::Filter const& filter, vk::SamplerAddr
   m_info.addressModeV = address;
   m_info.addressModeW = address;
   m_info.maxAnisotropy = 1.0;
+  // sample all levels of the image
+  m_info.minLod = 0.0f;
+  m_info.maxLod = VK_LOD_CLAMP_NONE;
   m_object = device->createSampler(m_info);
 }
 
@@ -34,6 +34,13 @@ vk::ShaderStageFlagBits execution_to_stage(spv::ExecutionModel const& model) {
   }
 }
 
+// spirv has no notion of dynamic offsets, mark by block name suffix
+static bool is_dynamic(std::string const& block_name) {
+  std::string const suffix{"Dynamic"};
+  return block_name.size() > suffix.size()
+      && block_name.compare(block_name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
 void layout_module_t::add_resource(std::string const& name, unsigned set, unsigned binding, unsigned num, vk::DescriptorType const& type) {
   if (sets.size() <= set) {
     sets.resize(set + 1);
@@ -56,7 +63,9 @@ layout_module_t::layout_module_t(spirv_cross::Compiler const& comp)
     std::string name{};
     // get the type name from buffers, they dont require instance names
     if (type == vk::DescriptorType::eStorageBuffer
-     || type  == vk::DescriptorType::eUniformBuffer) {
+     || type == vk::DescriptorType::eStorageBufferDynamic
+     || type == vk::DescriptorType::eUniformBuffer
+     || type == vk::DescriptorType::eUniformBufferDynamic) {
       name = comp.get_name(resource.base_type_id);
     }
     else {
@@ -80,11 +89,21 @@ layout_module_t::layout_module_t(spirv_cross::Compiler const& comp)
   }
 
   for (auto const& resource : resources.uniform_buffers) {
-    add_func(resource, vk::DescriptorType::eUniformBuffer);
+    if (is_dynamic(comp.get_name(resource.base_type_id))) {
+      add_func(resource, vk::DescriptorType::eUniformBufferDynamic);
+    }
+    else {
+      add_func(resource, vk::DescriptorType::eUniformBuffer);
+    }
   }
 
   for (auto const& resource : resources.storage_buffers) {
-    add_func(resource, vk::DescriptorType::eStorageBuffer);
+    if (is_dynamic(comp.get_name(resource.base_type_id))) {
+      add_func(resource, vk::DescriptorType::eStorageBufferDynamic);
+    }
+    else {
+      add_func(resource, vk::DescriptorType::eStorageBuffer);
+    }
   }
   for (auto const& resource : resources.subpass_inputs) {
     add_func(resource, vk::DescriptorType::eInputAttachment);
@@ -110,7 +129,7 @@ layout_module_t::layout_module_t(spirv_cross::Compiler const& comp)
       push_constant.stageFlags = stage;
     }
   }
-  // TODO: implement support for dynamic buffer offsets and texel buffers
+  // TODO: implement support for texel buffers
 
 }
 // check if descriptor is contained
@@ -2,7 +2,15 @@
 
 SubmitInfo::SubmitInfo()
  :m_info{}
-{}
+#ifdef VK_KHR_timeline_semaphore
+ ,m_info_timeline{}
+ ,m_timeline{false}
+#endif
+{
+#ifdef VK_KHR_timeline_semaphore
+  m_info_timeline.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+#endif
+}
 
 SubmitInfo::SubmitInfo(SubmitInfo && rhs)
  :SubmitInfo{}
@@ -11,10 +19,17 @@ SubmitInfo::SubmitInfo(SubmitInfo && rhs)
 }
 
 SubmitInfo::SubmitInfo(SubmitInfo const& rhs)
- :m_wait_semas{rhs.m_wait_semas}
- ,m_wait_stages{rhs.m_wait_stages}
- ,m_signal_semas{rhs.m_signal_semas}
+ :SubmitInfo{}
 {
+  m_wait_semas = rhs.m_wait_semas;
+  m_wait_stages = rhs.m_wait_stages;
+  m_command_buffers = rhs.m_command_buffers;
+  m_signal_semas = rhs.m_signal_semas;
+  m_wait_values = rhs.m_wait_values;
+  m_signal_values = rhs.m_signal_values;
+#ifdef VK_KHR_timeline_semaphore
+  m_timeline = rhs.m_timeline;
+#endif
   updatePtrs();
 }
 
@@ -33,6 +48,13 @@ void SubmitInfo::updatePtrs() {
 
   m_info.pSignalSemaphores = m_signal_semas.data();
   m_info.signalSemaphoreCount = uint32_t(m_signal_semas.size());
+#ifdef VK_KHR_timeline_semaphore
+  m_info_timeline.pWaitSemaphoreValues = m_wait_values.data();
+  m_info_timeline.waitSemaphoreValueCount = uint32_t(m_wait_values.size());
+  m_info_timeline.pSignalSemaphoreValues = m_signal_values.data();
+  m_info_timeline.signalSemaphoreValueCount = uint32_t(m_signal_values.size());
+  m_info.pNext = m_timeline ? &m_info_timeline : nullptr;
+#endif
 }
 
 void SubmitInfo::setCommandBuffers(std::vector<vk::CommandBuffer> buffers) {
@@ -47,19 +69,42 @@ void SubmitInfo::addCommandBuffer(vk::CommandBuffer buffer) {
 }
 
 void SubmitInfo::addWaitSemaphore(vk::Semaphore sema, vk::PipelineStageFlags stage) {
+  addWaitSemaphore(sema, stage, 0);
+}
+
+void SubmitInfo::addSignalSemaphore(vk::Semaphore sema) {
+  addSignalSemaphore(sema, 0);
+}
+
+void SubmitInfo::addWaitSemaphore(vk::Semaphore sema, vk::PipelineStageFlags stage, uint64_t value) {
   m_wait_semas.emplace_back(sema);
   m_wait_stages.emplace_back(stage);
+  m_wait_values.emplace_back(value);
+#ifdef VK_KHR_timeline_semaphore
+  m_timeline = m_timeline || value > 0;
+#endif
   updatePtrs();
 }
 
-void SubmitInfo::addSignalSemaphore(vk::Semaphore sema) {
+void SubmitInfo::addSignalSemaphore(vk::Semaphore sema, uint64_t value) {
   m_signal_semas.emplace_back(sema);
+  m_signal_values.emplace_back(value);
+#ifdef VK_KHR_timeline_semaphore
+  m_timeline = m_timeline || value > 0;
+#endif
   updatePtrs();
 }
 
 void SubmitInfo::swap(SubmitInfo& rhs) {
   std::swap(m_wait_semas, rhs.m_wait_semas);
   std::swap(m_wait_stages, rhs.m_wait_stages);
+  std::swap(m_command_buffers, rhs.m_command_buffers);
   std::swap(m_signal_semas, rhs.m_signal_semas);
+  std::swap(m_wait_values, rhs.m_wait_values);
+  std::swap(m_signal_values, rhs.m_signal_values);
+#ifdef VK_KHR_timeline_semaphore
+  std::swap(m_timeline, rhs.m_timeline);
+#endif
   updatePtrs();
+  rhs.updatePtrs();
 }
\ No newline at end of file
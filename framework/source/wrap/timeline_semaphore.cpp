@@ -0,0 +1,86 @@
+#include "wrap/timeline_semaphore.hpp"
+
+#include "wrap/device.hpp"
+
+TimelineSemaphore::TimelineSemaphore()
+ :WrapperTimelineSemaphore{}
+ ,m_device{nullptr}
+ ,m_value_submitted{0}
+{}
+
+TimelineSemaphore::TimelineSemaphore(TimelineSemaphore && semaphore)
+ :TimelineSemaphore{}
+{
+  swap(semaphore);
+}
+
+TimelineSemaphore::TimelineSemaphore(Device const& device, uint64_t value)
+ :TimelineSemaphore{}
+{
+  if (!device.supportsTimeline()) {
+    throw std::runtime_error{"timeline semaphores not supported"};
+  }
+  m_device = &device;
+  m_value_submitted = value;
+#ifdef VK_KHR_timeline_semaphore
+  VkSemaphoreTypeCreateInfoKHR info_type{};
+  info_type.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+  info_type.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+  info_type.initialValue = value;
+  vk::SemaphoreCreateInfo info{};
+  info.pNext = &info_type;
+  m_object = device->createSemaphore(info);
+#endif
+}
+
+TimelineSemaphore::~TimelineSemaphore() {
+  cleanup();
+}
+
+void TimelineSemaphore::destroy() {
+  (*m_device)->destroySemaphore(get());
+}
+
+uint64_t TimelineSemaphore::next() {
+  return ++m_value_submitted;
+}
+
+uint64_t TimelineSemaphore::value() const {
+  uint64_t value = 0;
+#ifdef VK_KHR_timeline_semaphore
+  if (m_device->m_semaphore_value(static_cast<VkDevice>(m_device->get()), static_cast<VkSemaphore>(get()), &value) != VK_SUCCESS) {
+    throw std::runtime_error{"could not query timeline value"};
+  }
+#endif
+  return value;
+}
+
+bool TimelineSemaphore::signaled(uint64_t value) const {
+  return this->value() >= value;
+}
+
+void TimelineSemaphore::wait(uint64_t value) const {
+#ifdef VK_KHR_timeline_semaphore
+  auto semaphore = static_cast<VkSemaphore>(get());
+  VkSemaphoreWaitInfoKHR info{};
+  info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+  info.semaphoreCount = 1;
+  info.pSemaphores = &semaphore;
+  info.pValues = &value;
+  if (m_device->m_wait_semaphores(static_cast<VkDevice>(m_device->get()), &info, 100000000) != VK_SUCCESS) {
+    assert(0);
+    throw std::runtime_error{"waited too long for timeline"};
+  }
+#endif
+}
+
+TimelineSemaphore& TimelineSemaphore::operator=(TimelineSemaphore&& semaphore) {
+  swap(semaphore);
+  return *this;
+}
+
+void TimelineSemaphore::swap(TimelineSemaphore& semaphore) {
+  WrapperTimelineSemaphore::swap(semaphore);
+  std::swap(m_device, semaphore.m_device);
+  std::swap(m_value_submitted, semaphore.m_value_submitted);
+}
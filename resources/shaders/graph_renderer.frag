@@ -42,9 +42,8 @@ layout(set = 2, binding = BIND_METAL) uniform sampler2D metalnessTextures[75];
 layout(set = 2, binding = BIND_ROUGH) uniform sampler2D normalTextures[75];
 layout(set = 2, binding = 4) uniform sampler2D roughnessTextures[75];
 
-layout(push_constant) uniform PushFragment {
-  layout(offset = 4) uint index;
-} material;
+// forwarded by vertex shader, from push constant or instance attribute
+layout(location = 3) flat in uint frag_Material;
 
 layout(location = 0) out vec4 out_Color;
 layout(location = 1) out vec4 out_Position;
@@ -56,7 +55,7 @@ vec3 perturb_normal(sampler2D normalMap, vec3 N, vec3 p, vec2 texcoord);
 void main() {
   out_Position = vec4(frag_Position, 1.0);
   // color
-  int index_diff = materials[material.index].index_diff;
+  int index_diff = materials[frag_Material].index_diff;
   if (index_diff >= 0) {
     out_Color = texture(diffuseTextures[index_diff], frag_Texcoord);
     if (out_Color.a < 1.0) {
@@ -64,10 +63,10 @@ void main() {
     }
   }
   else {
-    out_Color.rgb = materials[material.index].diffuse.rgb;
+    out_Color.rgb = materials[frag_Material].diffuse.rgb;
   }
   // normal
-  int index_norm = materials[material.index].index_norm;
+  int index_norm = materials[frag_Material].index_norm;
   if (index_norm >= 0) {
     vec3 V = normalize((inverse(ViewMatrix) * vec4(0.0, 0.0, 0.0, 1.0)).xyz -
       frag_Position);
@@ -89,24 +88,24 @@ void main() {
   }
   // metalness
   #ifndef ADDNA
-  int index_metal = materials[material.index].index_metal;
+  int index_metal = materials[frag_Material].index_metal;
   if (index_metal >= 0) {
     out_Color.a = texture(metalnessTextures[index_metal], frag_Texcoord).r;
   }
   else {
-    out_Color.a = materials[material.index].metalness;
+    out_Color.a = materials[frag_Material].metalness;
   }
   #else
     out_Color.a = 0.0;
   #endif
   #ifndef ADDNA
     // roughness
-    int index_rough = materials[material.index].index_rough;
+    int index_rough = materials[frag_Material].index_rough;
     if (index_rough >= 0) {
         out_Normal.a = texture(normalTextures[index_norm], frag_Texcoord).a;
     }
     else {
-        out_Normal.a = materials[material.index].roughness;
+        out_Normal.a = materials[frag_Material].roughness;
     }
   #endif
     if (out_Normal.a <= 0.0 ) {
@@ -16,6 +16,7 @@ layout(set = 1, binding = 0) buffer Transforms {
 
 layout(push_constant) uniform PushVertex {
   uint index;
+  uint material;
 } transform;
 
 out gl_PerVertex {
@@ -25,6 +26,7 @@ out gl_PerVertex {
 layout(location = 0) out vec3 frag_Position;
 layout(location = 1) out vec3 frag_Normal;
 layout(location = 2) out vec2 frag_Texcoord;
+layout(location = 3) flat out uint frag_Material;
 
 void main() {
   mat4 modelView = ViewMatrix * ModelMatrices[transform.index];
@@ -33,4 +35,5 @@ void main() {
   frag_Normal =  normalize((transpose(inverse(ModelMatrices[transform.index])) *
     vec4(in_Normal, 0.0)).xyz);
   frag_Texcoord = in_TexCoord;
+  frag_Material = transform.material;
 }
\ No newline at end of file
@@ -0,0 +1,36 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec3 in_Position;
+layout(location = 1) in vec3 in_Normal;
+layout(location = 2) in vec2 in_TexCoord;
+// per instance transform and material index
+layout(location = 3) in uvec2 in_Instance;
+
+layout(set = 0, binding = 0) uniform Camera {
+  mat4 ViewMatrix;
+  mat4 ProjectionMatrix;
+};
+
+layout(set = 1, binding = 0) buffer Transforms {
+  mat4[] ModelMatrices;
+};
+
+out gl_PerVertex {
+  vec4 gl_Position;
+};
+
+layout(location = 0) out vec3 frag_Position;
+layout(location = 1) out vec3 frag_Normal;
+layout(location = 2) out vec2 frag_Texcoord;
+layout(location = 3) flat out uint frag_Material;
+
+void main() {
+  mat4 modelView = ViewMatrix * ModelMatrices[in_Instance.x];
+  gl_Position =  ProjectionMatrix * modelView * vec4(in_Position, 1.0);
+  frag_Position = (ModelMatrices[in_Instance.x] * vec4(in_Position, 1.0)).xyz;
+  frag_Normal =  normalize((transpose(inverse(ModelMatrices[in_Instance.x])) *
+    vec4(in_Normal, 0.0)).xyz);
+  frag_Texcoord = in_TexCoord;
+  frag_Material = in_Instance.y;
+}
\ No newline at end of file
@@ -5,7 +5,7 @@ layout(location = 0) in vec3 in_Position;
 layout(location = 1) in vec3 in_Normal;
 layout(location = 2) in vec2 in_TexCoord;
 
-layout(set = 0, binding = 0) uniform MatrixBuffer {
+layout(set = 0, binding = 0) uniform MatrixBufferDynamic {
     mat4 ViewMatrix;
     mat4 ProjectionMatrix;
     mat4 ModelMatrix;
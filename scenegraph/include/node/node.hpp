@@ -4,6 +4,7 @@
 #include "visit/visitor_node.hpp"
 #include "bbox.hpp"
 
+#include <cstdint>
 #include <string>
 #include <glm/mat4x4.hpp>
 #include <vector>
@@ -26,6 +27,8 @@ public:
 	glm::mat4 const& getLocal() const;
 	Bbox getBox() const;
 	Node* getParent() const;
+	// changes when nodes are added to or removed from the subtree
+	uint32_t getVersion() const;
 
 	std::vector<Node*> getChildren();
 	Node* getChild(std::string const& name);
@@ -47,8 +50,11 @@ public:
 	std::vector<std::unique_ptr<Node>>::iterator findChild(std::string const& name);
 	void setBox(Bbox const& box);
 	void setParent(Node* const p);
+	// increments version of this node and its ancestors
+	void changed();
 
 	Node* m_parent;
+	uint32_t m_version;
 	std::string m_name;
 	glm::fmat4 m_world;
 	Bbox m_box;
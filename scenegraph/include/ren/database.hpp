@@ -7,6 +7,7 @@
 #include <vulkan/vulkan.hpp>
 
 #include <map>
+#include <mutex>
 
 class Device;
 class Image;
@@ -33,12 +34,16 @@ class Database {
   virtual void store(std::string const& name, T&& resource);
   bool contains(std::string const& tex_path);
   virtual size_t size() const;
+  // derived databases may use another allocator
+  virtual Allocator const& allocator() const;
  protected:
   Device const* m_device;
   Transferrer* m_transferrer;
   BlockAllocator m_allocator;
 
   std::map<std::string, T> m_resources;
+  // guards m_resources, allows storing from loader threads
+  mutable std::mutex m_mutex;
 
   const static size_t SIZE_RESOURCE;
 };
@@ -84,16 +89,19 @@ void Database<T>::swap(Database& rhs) {
 
 template<typename T>
 T const& Database<T>::get(std::string const& tex_path) {
+  std::lock_guard<std::mutex> lock{m_mutex};
   return m_resources.at(tex_path);
 }
 
 template<typename T>
 bool Database<T>::contains(std::string const& tex_path) {
+  std::lock_guard<std::mutex> lock{m_mutex};
   return m_resources.find(tex_path) != m_resources.end();
 }
 
 template<typename T>
 void Database<T>::store(std::string const& name, T&& resource) {
+  std::lock_guard<std::mutex> lock{m_mutex};
   if (m_resources.find(name) != m_resources.end()) {
     throw std::runtime_error{"key already in use"};
   }
@@ -112,9 +120,15 @@ void Database<T>::set(std::string const& name, T&& resource) {
 
 template<typename T>
 size_t Database<T>::size() const {
+  std::lock_guard<std::mutex> lock{m_mutex};
   return m_resources.size();  
 }
 
+template<typename T>
+Allocator const& Database<T>::allocator() const {
+  return m_allocator;
+}
+
 // template<typename T>
 // void Database<T>::store(std::string const& path) {
 //   throw std::exception{};
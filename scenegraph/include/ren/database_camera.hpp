@@ -36,6 +36,10 @@ class CameraDatabase : public Database<Camera> {
   Buffer const& buffer() const {
     return m_buffer;
   }
+
+  StaticAllocator const& allocator() const override {
+    return m_allocator;
+  }
   
  private:
   std::map<std::string, size_t> m_indices;
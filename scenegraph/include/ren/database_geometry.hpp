@@ -3,6 +3,7 @@
 
 #include "ren/database.hpp"
 #include "geometry.hpp"
+#include "geometry_buffer.hpp"
 
 #include <vulkan/vulkan.hpp>
 
@@ -18,12 +19,22 @@ class GeometryDatabase : public Database<Geometry> {
   GeometryDatabase(Transferrer& transferrer);
   GeometryDatabase(GeometryDatabase && dev);
   GeometryDatabase(GeometryDatabase const&) = delete;
+  ~GeometryDatabase();
   
   GeometryDatabase& operator=(GeometryDatabase const&) = delete;
   GeometryDatabase& operator=(GeometryDatabase&& dev);
 
-  // void swap(GeometryDatabase& dev);
+  void swap(GeometryDatabase& dev);
+
+  using Database::store;
+  // packs geometry into the shared buffers
+  void store(std::string const& name, vertex_data const& model);
+  void release(std::string const& name);
+
+  GeometryBuffer const& storage() const;
   // void store(std::string const& tex_path) override;
+ private:
+  GeometryBuffer m_storage;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -34,6 +34,10 @@ class LightDatabase : public Database<light_t> {
   Buffer const& buffer() const {
     return m_buffer;
   }
+
+  StaticAllocator const& allocator() const override {
+    return m_allocator;
+  }
   size_t size() const override {
     return m_indices.size();
   }
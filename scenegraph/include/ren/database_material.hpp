@@ -33,6 +33,10 @@ class MaterialDatabase : public Database<material_t> {
     return m_buffer;
   }
 
+  StaticAllocator const& allocator() const override {
+    return m_allocator;
+  }
+
   std::map<std::string, std::map<std::string, int32_t>> const& mapping() const {
     return m_tex_mapping;
   }
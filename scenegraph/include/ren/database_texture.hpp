@@ -4,13 +4,17 @@
 #include "ren/database.hpp"
 #include "wrap/image_res.hpp"
 #include "wrap/sampler.hpp"
+#include "allocator_concurrent.hpp"
 #include "deleter.hpp"
 
 #include <vulkan/vulkan.hpp>
 
 #include <map>
+#include <string>
+#include <vector>
 
 class Device;
+class JobSystem;
 class Transferrer;
 
 class TextureDatabase : public Database<BackedImage> {
@@ -19,6 +23,7 @@ class TextureDatabase : public Database<BackedImage> {
   TextureDatabase(Transferrer& transferrer);
   TextureDatabase(TextureDatabase && dev);
   TextureDatabase(TextureDatabase const&) = delete;
+  ~TextureDatabase();
   
   TextureDatabase& operator=(TextureDatabase const&) = delete;
   TextureDatabase& operator=(TextureDatabase&& dev);
@@ -26,15 +31,36 @@ class TextureDatabase : public Database<BackedImage> {
   void swap(TextureDatabase& dev);
 
   void store(std::string const& tex_path, BackedImage&& texture) override;
+  // thread-safe, textures stored meanwhile by another thread are skipped
+  // upload is batched, image is ready after the transferrer was waited for
   void store(std::string const& tex_path);
+  // decodes in parallel, indices are assigned in order of paths
+  // levels missing in the files are generated, waits for uploads if any are
+  void store(std::vector<std::string> const& tex_paths);
   
+  // decoded images are cached in directory, empty disables cache
+  void setCacheDirectory(std::string const& cache_dir);
+  // decodes with jobs instead of temporary threads
+  void setJobSystem(JobSystem& jobs);
+
   size_t index(std::string const& name) const;
 
   void writeToSet(vk::DescriptorSet const& set, uint32_t binding) const;
   void writeToSet(vk::DescriptorSet const& set, uint32_t first_binding, std::map<std::string, std::map<std::string, int32_t>> const& mapping) const;
+
+  ConcurrentAllocator const& allocator() const override;
  private:
+  // returns false if name is already in use
+  bool emplace(std::string const& tex_path, BackedImage&& texture);
+  // format allows generating mip levels with linear blits
+  bool supportsBlit(vk::Format const& format) const;
+
   std::map<std::string, uint32_t> m_indices;
   Sampler m_sampler;
+  std::string m_cache_dir;
+  JobSystem* m_jobs;
+  // textures are mostly power of two sized, small ones are suballocated per loader thread
+  ConcurrentAllocator m_allocator;
 };
 
 #endif
\ No newline at end of file
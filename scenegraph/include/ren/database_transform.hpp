@@ -36,6 +36,10 @@ class TransformDatabase : public Database<glm::fmat4> {
   Buffer const& buffer() const {
     return m_buffer;
   }
+
+  StaticAllocator const& allocator() const override {
+    return m_allocator;
+  }
   
  private:
   std::map<std::string, size_t> m_indices;
@@ -5,14 +5,45 @@
 
 #include <vulkan/vulkan.hpp>
 
+#include <map>
+#include <string>
+#include <vector>
+
 class Device;
 class Transferrer;
 class ModelNode;
 
 class CommandBuffer;
+class Geometry;
+class TransientBuffer;
+class BufferRegion;
 
 class Renderer {
  public:  
+  // one draw per geometry of a node
+  struct draw_t {
+    uint32_t material;
+    Geometry const* geometry;
+    uint32_t transform;
+  };
+  // vertex attribute of instance binding
+  struct instance_t {
+    uint32_t transform;
+    uint32_t material;
+  };
+  // draws of geometries sharing a vertex buffer
+  struct indirect_group_t {
+    Geometry const* geometry_indexed;
+    Geometry const* geometry_plain;
+    std::vector<vk::DrawIndexedIndirectCommand> commands_indexed;
+    std::vector<vk::DrawIndirectCommand> commands_plain;
+  };
+  struct indirect_draws_t {
+    std::vector<instance_t> instances;
+    std::vector<indirect_group_t> groups;
+  };
+
+
   Renderer();
   Renderer(ApplicationInstance& instance);
   Renderer(Renderer && dev);
@@ -23,8 +54,25 @@ class Renderer {
 
   void swap(Renderer& dev);
   void draw(CommandBuffer& buffer, std::vector<ModelNode const*> const& nodes);
+  // sorted by material and geometry to minimize state changes
+  std::vector<draw_t> sortDraws(std::vector<ModelNode const*> const& nodes) const;
+  // records draws in [begin, end), can be called concurrently for different buffers
+  void draw(CommandBuffer& buffer, std::vector<draw_t> const& draws, std::size_t begin, std::size_t end) const;
+  // one indirect command per geometry and material, transform and material indices are instance attributes in binding 1
+  // commands and instance data are written to the transient buffer, so the buffer must be rerecorded every frame
+  void drawIndirect(CommandBuffer& buffer, std::vector<ModelNode const*> const& nodes, TransientBuffer& transient);
+  // commands and instance data only change with the scene, not every frame
+  indirect_draws_t collectIndirect(std::vector<ModelNode const*> const& nodes) const;
+  // writes instances and commands, same allocation sequence every frame so offsets repeat
+  std::vector<BufferRegion> uploadIndirect(indirect_draws_t const& draws, TransientBuffer& transient) const;
+  // records with the regions returned by upload
+  void drawIndirect(CommandBuffer& buffer, indirect_draws_t const& draws, std::vector<BufferRegion> const& regions) const;
 
  private:
+  // transform indices per geometry per material
+  typedef std::map<std::string, std::map<std::string, std::vector<size_t>>> batches_t;
+  batches_t collectBatches(std::vector<ModelNode const*> const& nodes) const;
+
   ApplicationInstance* m_instance;
 };
 
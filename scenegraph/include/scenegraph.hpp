@@ -32,6 +32,8 @@ public:
 
 	std::string const& getName() const;
 	Node* getRoot() const;
+	// changes when nodes are added or removed
+	uint32_t getVersion() const;
 	void accept(NodeVisitor &v) const;
 
 private:
@@ -10,12 +10,14 @@
 
 Node::Node()
  :m_parent{nullptr}
+ ,m_version{0}
 {
 	m_children = std::vector<std::unique_ptr<Node>>();
 }
 
 Node::Node(std::string const & name, glm::mat4 const& local)
  :m_parent{nullptr}
+ ,m_version{0}
  ,m_name(name)
  ,m_local(local)
  ,m_box(Bbox())
@@ -68,6 +70,18 @@ Node * Node::getParent() const
 	return m_parent;
 }
 
+uint32_t Node::getVersion() const
+{
+	return m_version;
+}
+
+void Node::changed()
+{
+	for (Node* node = this; node != nullptr; node = node->m_parent) {
+		++node->m_version;
+	}
+}
+
 std::vector<Node*> Node::getChildren()
 {
 	std::vector<Node*> children; 
@@ -87,6 +101,7 @@ void Node::addChild(std::unique_ptr<Node>&& n)
 {
 	n->setParent(this);
 	m_children.emplace_back(std::move(n));
+	changed();
 }
 
 std::vector<std::unique_ptr<Node>>::iterator Node::findChild(std::string const& name) {
@@ -109,12 +124,15 @@ std::unique_ptr<Node> Node::detachChild(std::string const& name_child)
 	// take ownership and remove
 	std::unique_ptr<Node> node{child->release()};
 	m_children.erase(child);
+	node->setParent(nullptr);
+	changed();
 	return node;
 }
 
 void Node::clearChildren()
 {
 	m_children.clear();
+	changed();
 }
 
 void Node::scale(glm::vec3 const & s)
@@ -7,6 +7,7 @@
 
 GeometryDatabase::GeometryDatabase()
  :Database{}
+ ,m_storage{}
 {}
 
 GeometryDatabase::GeometryDatabase(GeometryDatabase && rhs)
@@ -21,6 +22,12 @@ GeometryDatabase::GeometryDatabase(Transferrer& transferrer)
   // find memory type which supports optimal image and specific depth format
   auto type_img = m_device->suitableMemoryType(vk::Format::eD32Sfloat, vk::ImageTiling::eOptimal, vk::MemoryPropertyFlagBits::eDeviceLocal);
   m_allocator = BlockAllocator{*m_device, type_img, 4 * 4 * 3840 * 2160};
+  m_storage = GeometryBuffer{transferrer, 64 * 1024 * 1024};
+}
+
+GeometryDatabase::~GeometryDatabase() {
+  // geometries must be freed before their storage is destroyed
+  m_resources.clear();
 }
 
 GeometryDatabase& GeometryDatabase::operator=(GeometryDatabase&& rhs) {
@@ -28,6 +35,26 @@ GeometryDatabase& GeometryDatabase::operator=(GeometryDatabase&& rhs) {
   return *this;
 }
 
+void GeometryDatabase::swap(GeometryDatabase& rhs) {
+  Database::swap(rhs);
+  std::swap(m_storage, rhs.m_storage);
+}
+
+void GeometryDatabase::store(std::string const& name, vertex_data const& model) {
+  Database::store(name, Geometry{m_storage, model});
+}
+
+void GeometryDatabase::release(std::string const& name) {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  if (m_resources.erase(name) == 0) {
+    throw std::runtime_error{"geometry " + name + " not found"};
+  }
+}
+
+GeometryBuffer const& GeometryDatabase::storage() const {
+  return m_storage;
+}
+
 // void GeometryDatabase::store(std::string const& tex_path) {
 //   auto pix_data = texture_loader::file(tex_path);
 
@@ -76,7 +76,7 @@ void MaterialDatabase::store(std::string const& name, material_t&& resource) {
   m_indices.emplace(name, m_indices.size());
   // storge gpu representation
   BufferRegion region{m_buffer, sizeof(gpu_mat_t), (m_indices.size() - 1) * sizeof(gpu_mat_t)};
-  m_transferrer->uploadBufferData(&gpu_mat, region);
+  m_transferrer->uploadBufferDataAsync(&gpu_mat, region);
 
   // store cpu representation
   Database::store(name, std::move(resource));
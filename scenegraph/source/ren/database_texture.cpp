@@ -1,12 +1,22 @@
 #include "ren/database_texture.hpp"
 
 #include "wrap/device.hpp"
+#include "allocator_buddy.hpp"
 #include "wrap/image.hpp"
 #include "texture_loader.hpp"
 #include "transferrer.hpp"
+#include "job_system.hpp"
+
+#include <algorithm>
+#include <exception>
 
 TextureDatabase::TextureDatabase()
  :Database{}
+ ,m_indices{}
+ ,m_sampler{}
+ ,m_cache_dir{}
+ ,m_jobs{nullptr}
+ ,m_allocator{}
 {}
 
 TextureDatabase::TextureDatabase(TextureDatabase && rhs)
@@ -18,11 +28,18 @@ TextureDatabase::TextureDatabase(TextureDatabase && rhs)
 TextureDatabase::TextureDatabase(Transferrer& transferrer)
  :Database{transferrer}
  ,m_sampler{*m_device, vk::Filter::eLinear, vk::SamplerAddressMode::eRepeat}
+ ,m_jobs{nullptr}
 {
   // m_sampler = (*m_device)->createSampler({{}, vk::Filter::eLinear, vk::Filter::eLinear});
   // find memory type which supports optimal image and specific depth format
   auto type_img = m_device->suitableMemoryType(vk::Format::eD32Sfloat, vk::ImageTiling::eOptimal, vk::MemoryPropertyFlagBits::eDeviceLocal);
-  m_allocator = BlockAllocator{*m_device, type_img, 4 * 4 * 3840 * 2160};
+  auto allocator_buddy = std::unique_ptr<Allocator>{new BuddyAllocator{*m_device, type_img, 4 * 4 * 3840 * 2160}};
+  m_allocator = ConcurrentAllocator{std::move(allocator_buddy), vk::DeviceSize{32} * 1024 * 1024};
+}
+
+TextureDatabase::~TextureDatabase() {
+  // images must be freed before their allocator is destroyed
+  m_resources.clear();
 }
 
 TextureDatabase& TextureDatabase::operator=(TextureDatabase&& rhs) {
@@ -31,24 +48,104 @@ TextureDatabase& TextureDatabase::operator=(TextureDatabase&& rhs) {
 }
 
 void TextureDatabase::swap(TextureDatabase& rhs) {
-  std::swap(m_indices, m_indices);
-  std::swap(m_sampler, m_sampler);
+  Database::swap(rhs);
+  std::swap(m_indices, rhs.m_indices);
+  std::swap(m_sampler, rhs.m_sampler);
+  std::swap(m_cache_dir, rhs.m_cache_dir);
+  std::swap(m_jobs, rhs.m_jobs);
+  std::swap(m_allocator, rhs.m_allocator);
+}
+
+bool TextureDatabase::emplace(std::string const& tex_path, BackedImage&& texture) {
+  // indices must stay consistent with resources
+  std::lock_guard<std::mutex> lock{m_mutex};
+  if (m_resources.find(tex_path) != m_resources.end()) {
+    return false;
+  }
+  m_indices.emplace(tex_path, uint32_t(m_indices.size()));
+  m_resources.emplace(tex_path, std::move(texture));
+  return true;
 }
 
 void TextureDatabase::store(std::string const& tex_path, BackedImage&& texture) {
-  m_indices.emplace(tex_path, m_indices.size());
-  Database::store(tex_path, std::move(texture));  
+  if (!emplace(tex_path, std::move(texture))) {
+    throw std::runtime_error{"key already in use"};
+  }
 }
 
 void TextureDatabase::store(std::string const& tex_path) {
-  auto pix_data = texture_loader::file(tex_path);
+  store(std::vector<std::string>{tex_path});
+}
 
-  BackedImage img_new{*m_device, pix_data.extent, pix_data.format, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst};
-  m_allocator.allocate(img_new);
- 
-  m_transferrer->uploadImageData(pix_data.ptr(), pix_data.size(), img_new, vk::ImageLayout::eShaderReadOnlyOptimal);
+void TextureDatabase::store(std::vector<std::string> const& tex_paths) {
+  // skip duplicates and stored textures, keep order for indices
+  std::vector<std::string> paths{};
+  for (auto const& path : tex_paths) {
+    if (!contains(path) && std::find(paths.begin(), paths.end(), path) == paths.end()) {
+      paths.emplace_back(path);
+    }
+  }
+  if (paths.empty()) return;
+
+  std::vector<BackedImage> images(paths.size());
+  std::vector<transfer_token_t> tokens(paths.size(), 0);
+  std::vector<std::exception_ptr> errors(paths.size());
+  // no vector<bool>, elements are written concurrently
+  std::vector<uint8_t> generate_mips(paths.size(), 0);
+  auto decode = [&](std::size_t i) {
+    try {
+      auto pix_data = texture_loader::file(paths[i], m_cache_dir);
+      // levels not stored in file are blitted from the base level
+      auto num_levels = pix_data.levels();
+      vk::ImageUsageFlags usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst;
+      if (num_levels == 1 && supportsBlit(pix_data.format)) {
+        num_levels = mip_levels(pix_data.extent);
+        usage |= vk::ImageUsageFlagBits::eTransferSrc;
+        generate_mips[i] = num_levels > 1;
+      }
+
+      images[i] = BackedImage{*m_device, pix_data.extent, pix_data.format, vk::ImageTiling::eOptimal, usage, num_levels};
+      m_allocator.allocate(images[i]);
+      // pixels are staged immediately and can be freed
+      auto layout = generate_mips[i] ? vk::ImageLayout::eTransferDstOptimal : vk::ImageLayout::eShaderReadOnlyOptimal;
+      for (uint32_t level = 0; level < pix_data.levels(); ++level) {
+        tokens[i] = m_transferrer->uploadImageDataAsync(pix_data.ptr(level), pix_data.size(level), images[i].layers(level), pix_data.format, layout);
+      }
+    }
+    catch (...) {
+      errors[i] = std::current_exception();
+    }
+  };
+  // temporary workers without job system, calling thread decodes as well
+  JobSystem jobs_local{m_jobs ? 0 : std::min(JobSystem::numHardwareWorkers(), paths.size() - 1)};
+  auto& jobs = m_jobs ? *m_jobs : jobs_local;
+  jobs.parallelFor(0, paths.size(), decode, 1, "texture_decode");
+  m_transferrer->flush();
+
+  std::vector<Image const*> images_mips{};
+  for (std::size_t i = 0; i < paths.size(); ++i) {
+    if (generate_mips[i] && !errors[i]) {
+      images_mips.emplace_back(&images[i]);
+    }
+  }
+  m_transferrer->generateMipmaps(images_mips, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
+
+  for (std::size_t i = 0; i < paths.size(); ++i) {
+    if (errors[i]) {
+      // images must not be freed while uploading
+      m_transferrer->waitAll();
+      std::rethrow_exception(errors[i]);
+    }
+    // image is freed if the texture was loaded concurrently
+    if (!emplace(paths[i], std::move(images[i]))) {
+      m_transferrer->wait(tokens[i]);
+    }
+  }
+}
 
-  store(tex_path, std::move(img_new));  
+bool TextureDatabase::supportsBlit(vk::Format const& format) const {
+  auto features = vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst | vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+  return (m_device->physical().getFormatProperties(format).optimalTilingFeatures & features) == features;
 }
 
 void TextureDatabase::writeToSet(vk::DescriptorSet const& set, std::uint32_t binding) const {
@@ -110,6 +207,19 @@ void TextureDatabase::writeToSet(vk::DescriptorSet const& set, uint32_t first_bi
   (*m_device)->updateDescriptorSets(set_writes, 0);
 }
 
+void TextureDatabase::setCacheDirectory(std::string const& cache_dir) {
+  m_cache_dir = cache_dir;
+}
+
+void TextureDatabase::setJobSystem(JobSystem& jobs) {
+  m_jobs = &jobs;
+}
+
 size_t TextureDatabase::index(std::string const& name) const {
+  std::lock_guard<std::mutex> lock{m_mutex};
   return m_indices.at(name);
 }
+
+ConcurrentAllocator const& TextureDatabase::allocator() const {
+  return m_allocator;
+}
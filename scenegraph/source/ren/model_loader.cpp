@@ -41,10 +41,18 @@ Model ModelLoader::load(std::string const& filename, vertex_data::attrib_flag_t
   std::vector<std::string> keys_mat{};
   glm::vec3 box_min(std::numeric_limits<float>::max()); 
   glm::vec3 box_max(std::numeric_limits<float>::lowest());
+  // decode all textures at once, materials need their indices
+  std::vector<std::string> tex_paths{};
+  for (auto const& mat_data : mat_datas) {
+    for (auto const& tex_pair : mat_data.textures) {
+      tex_paths.emplace_back(tex_pair.second);
+    }
+  }
+  m_instance->dbTexture().store(tex_paths);
   for (size_t i = 0; i < vert_datas.size(); ++i) {
     // store geometry
     std::string key_geo{filename + '|' + std::to_string(i)};
-    m_instance->dbGeometry().store(key_geo, Geometry{m_instance->transferrer(), vert_datas[i]});
+    m_instance->dbGeometry().store(key_geo, vert_datas[i]);
     keys_geo.emplace_back(key_geo);
     
     std::string key_mat{filename + '|' + std::to_string(i)};
@@ -52,12 +60,6 @@ Model ModelLoader::load(std::string const& filename, vertex_data::attrib_flag_t
       key_mat = "default";
     }
     else {
-      // load new textures
-      for (auto const& tex_pair : mat_datas[i].textures) {
-        if (!m_instance->dbTexture().contains(tex_pair.second)) {
-          m_instance->dbTexture().store(tex_pair.second);
-        }
-      }
       // store material
       if (!m_instance->dbMaterial().contains(key_mat)) {
         m_instance->dbMaterial().store(key_mat, std::move(mat_datas[i]));
@@ -75,6 +77,8 @@ Model ModelLoader::load(std::string const& filename, vertex_data::attrib_flag_t
         if (vert_datas[i].data[j+2] > box_max.z) box_max.z = vert_datas[i].data[j+2];
     }
   }
+  // uploads of all parts are batched
+  m_instance->transferrer().waitAll();
   if (mat_datas.empty()) {
     std::cerr << "Model " << filename << " has no materials, using default." << std::endl;
   }
@@ -7,9 +7,13 @@
 #include "ren/database_model.hpp"
 #include "ren/database_transform.hpp"
 #include "transferrer.hpp"
+#include "wrap/device.hpp"
+#include "transient_buffer.hpp"
+#include "geometry.hpp"
 #include "geometry_loader.hpp"
 #include "node/node_model.hpp"
 
+#include <cstring>
 #include <iostream>
 
 Renderer::Renderer()
@@ -34,9 +38,9 @@ void Renderer::swap(Renderer& rhs) {
   std::swap(m_instance, rhs.m_instance);
 }
 
-void Renderer::draw(CommandBuffer& buffer, std::vector<ModelNode const*> const& nodes) {
+Renderer::batches_t Renderer::collectBatches(std::vector<ModelNode const*> const& nodes) const {
   // store transforms per geometry per material
-  std::map<std::string, std::map<std::string, std::vector<size_t>>> material_geometries;
+  batches_t material_geometries;
   // collect geometries for materials
   for (auto const& node_ptr : nodes) {
     auto const& model = m_instance->dbModel().get(node_ptr->m_model);
@@ -44,7 +48,6 @@ void Renderer::draw(CommandBuffer& buffer, std::vector<ModelNode const*> const&
     for(size_t i = 0; i < model.m_geometries.size(); ++i) {
       auto const& name_geo = model.m_geometries[i];
       auto const& name_mat = model.m_materials[i];
-      // auto ptr_geo = &m_database_geo->get(name_geo);
       // check if material exists
       auto iter_material = material_geometries.find(name_mat);
       if (iter_material == material_geometries.end()) {
@@ -64,20 +67,173 @@ void Renderer::draw(CommandBuffer& buffer, std::vector<ModelNode const*> const&
       }
     }
   }
-  // material doesnt change for some geometries
+  return material_geometries;
+}
+
+void Renderer::draw(CommandBuffer& buffer, std::vector<ModelNode const*> const& nodes) {
+  auto draws = sortDraws(nodes);
+  draw(buffer, draws, 0, draws.size());
+}
+
+std::vector<Renderer::draw_t> Renderer::sortDraws(std::vector<ModelNode const*> const& nodes) const {
+  auto material_geometries = collectBatches(nodes);
+  std::vector<draw_t> draws{};
   for (auto const& material_entry : material_geometries) {
-    uint32_t const& material_idx = uint32_t(m_instance->dbMaterial().index(material_entry.first));
-    buffer.pushConstants(vk::ShaderStageFlagBits::eFragment, sizeof(uint32_t), material_idx);
+    uint32_t material_idx = uint32_t(m_instance->dbMaterial().index(material_entry.first));
+    for (auto const& geometry_entry : material_entry.second) {
+      auto const& geometry = m_instance->dbGeometry().get(geometry_entry.first);
+      for (auto const& transform_entry : geometry_entry.second) {
+        draws.emplace_back(draw_t{material_idx, &geometry, uint32_t(transform_entry)});
+      }
+    }
+  }
+  return draws;
+}
+
+void Renderer::draw(CommandBuffer& buffer, std::vector<draw_t> const& draws, std::size_t begin, std::size_t end) const {
+  for (auto i = begin; i < end; ++i) {
+    auto const& draw = draws[i];
+    // material doesnt change for some geometries
+    if (i == begin || draw.material != draws[i - 1].material) {
+      // forwarded to fragment shader by vertex shader
+      buffer.pushConstants(vk::ShaderStageFlagBits::eVertex, sizeof(uint32_t), draw.material);
+    }
     // geometry doesnt change for some transforms
+    if (i == begin || draw.geometry != draws[i - 1].geometry) {
+      buffer.bindGeometry(*draw.geometry);
+    }
+    // transform changes every draw
+    buffer.pushConstants(vk::ShaderStageFlagBits::eVertex, 0, draw.transform);
+    buffer.drawGeometry();
+  }
+}
+
+template<typename T>
+static BufferRegion upload_commands(TransientBuffer& transient, std::vector<T> const& commands, bool first_instance) {
+  auto alloc = transient.allocate(sizeof(T) * commands.size());
+  std::memcpy(alloc.ptr, commands.data(), sizeof(T) * commands.size());
+  // without drawIndirectFirstInstance the instance binding is offset instead
+  if (!first_instance) {
+    auto commands_gpu = reinterpret_cast<T*>(alloc.ptr);
+    for (std::size_t i = 0; i < commands.size(); ++i) {
+      commands_gpu[i].firstInstance = 0;
+    }
+  }
+  return alloc.region;
+}
+
+Renderer::indirect_draws_t Renderer::collectIndirect(std::vector<ModelNode const*> const& nodes) const {
+  auto material_geometries = collectBatches(nodes);
+  indirect_draws_t draws{};
+  // one command per geometry and material, instances are consecutive
+  std::map<VkBuffer, indirect_group_t> groups{};
+  for (auto const& material_entry : material_geometries) {
+    uint32_t material_idx = uint32_t(m_instance->dbMaterial().index(material_entry.first));
     for (auto const& geometry_entry : material_entry.second) {
       auto const& geometry = m_instance->dbGeometry().get(geometry_entry.first);
-      buffer.bindGeometry(geometry);
-      // transform changes every draw
+      auto first_instance = uint32_t(draws.instances.size());
       for (auto const& transform_entry : geometry_entry.second) {
-        uint32_t transform_idx = uint32_t(transform_entry);
-        buffer.pushConstants(vk::ShaderStageFlagBits::eVertex, 0, transform_idx);
-        buffer.drawGeometry();
+        draws.instances.emplace_back(instance_t{uint32_t(transform_entry), material_idx});
+      }
+      auto num_instances_geo = uint32_t(geometry_entry.second.size());
+      auto iter_group = groups.find(static_cast<VkBuffer>(geometry.vertices().buffer()));
+      if (iter_group == groups.end()) {
+        iter_group = groups.emplace(static_cast<VkBuffer>(geometry.vertices().buffer()), indirect_group_t{nullptr, nullptr, {}, {}}).first;
+      }
+      auto& group = iter_group->second;
+      if (geometry.numIndices() > 0) {
+        vk::DrawIndexedIndirectCommand command{};
+        command.indexCount = geometry.numIndices();
+        command.instanceCount = num_instances_geo;
+        command.firstIndex = geometry.indexOffset();
+        command.vertexOffset = int32_t(geometry.vertexOffset());
+        command.firstInstance = first_instance;
+        group.commands_indexed.emplace_back(command);
+        group.geometry_indexed = &geometry;
+      }
+      else {
+        vk::DrawIndirectCommand command{};
+        command.vertexCount = geometry.numVertices();
+        command.instanceCount = num_instances_geo;
+        command.firstVertex = geometry.vertexOffset();
+        command.firstInstance = first_instance;
+        group.commands_plain.emplace_back(command);
+        group.geometry_plain = &geometry;
       }
     }
   }
-}
\ No newline at end of file
+  for (auto& pair_group : groups) {
+    draws.groups.emplace_back(std::move(pair_group.second));
+  }
+  return draws;
+}
+
+std::vector<BufferRegion> Renderer::uploadIndirect(indirect_draws_t const& draws, TransientBuffer& transient) const {
+  std::vector<BufferRegion> regions{};
+  if (draws.instances.empty()) return regions;
+
+  auto first_instance = m_instance->transferrer().device().supportsIndirectFirstInstance();
+  auto alloc = transient.allocate(sizeof(instance_t) * draws.instances.size());
+  std::memcpy(alloc.ptr, draws.instances.data(), sizeof(instance_t) * draws.instances.size());
+  regions.emplace_back(alloc.region);
+  for (auto const& group : draws.groups) {
+    if (!group.commands_indexed.empty()) {
+      regions.emplace_back(upload_commands(transient, group.commands_indexed, first_instance));
+    }
+    if (!group.commands_plain.empty()) {
+      regions.emplace_back(upload_commands(transient, group.commands_plain, first_instance));
+    }
+  }
+  return regions;
+}
+
+void Renderer::drawIndirect(CommandBuffer& buffer, indirect_draws_t const& draws, std::vector<BufferRegion> const& regions) const {
+  if (draws.instances.empty()) return;
+
+  auto iter_region = regions.begin();
+  auto const& region_instances = *iter_region;
+  buffer->bindVertexBuffers(1, {region_instances.buffer()}, {region_instances.offset()});
+  ++iter_region;
+  if (m_instance->transferrer().device().supportsIndirectFirstInstance()) {
+    for (auto const& group : draws.groups) {
+      if (!group.commands_indexed.empty()) {
+        buffer.bindGeometry(*group.geometry_indexed);
+        buffer->drawIndexedIndirect(iter_region->buffer(), iter_region->offset(), uint32_t(group.commands_indexed.size()), sizeof(vk::DrawIndexedIndirectCommand));
+        ++iter_region;
+      }
+      if (!group.commands_plain.empty()) {
+        buffer.bindGeometry(*group.geometry_plain);
+        buffer->drawIndirect(iter_region->buffer(), iter_region->offset(), uint32_t(group.commands_plain.size()), sizeof(vk::DrawIndirectCommand));
+        ++iter_region;
+      }
+    }
+    return;
+  }
+  // uploaded commands start at instance 0, the instance attributes are rebound for each command
+  auto bind_instances = [&buffer, &region_instances](uint32_t first_instance) {
+    buffer->bindVertexBuffers(1, {region_instances.buffer()}, {region_instances.offset() + first_instance * sizeof(instance_t)});
+  };
+  for (auto const& group : draws.groups) {
+    if (!group.commands_indexed.empty()) {
+      buffer.bindGeometry(*group.geometry_indexed);
+      for (std::size_t i = 0; i < group.commands_indexed.size(); ++i) {
+        bind_instances(group.commands_indexed[i].firstInstance);
+        buffer->drawIndexedIndirect(iter_region->buffer(), iter_region->offset() + i * sizeof(vk::DrawIndexedIndirectCommand), 1, sizeof(vk::DrawIndexedIndirectCommand));
+      }
+      ++iter_region;
+    }
+    if (!group.commands_plain.empty()) {
+      buffer.bindGeometry(*group.geometry_plain);
+      for (std::size_t i = 0; i < group.commands_plain.size(); ++i) {
+        bind_instances(group.commands_plain[i].firstInstance);
+        buffer->drawIndirect(iter_region->buffer(), iter_region->offset() + i * sizeof(vk::DrawIndirectCommand), 1, sizeof(vk::DrawIndirectCommand));
+      }
+      ++iter_region;
+    }
+  }
+}
+
+void Renderer::drawIndirect(CommandBuffer& buffer, std::vector<ModelNode const*> const& nodes, TransientBuffer& transient) {
+  auto draws = collectIndirect(nodes);
+  drawIndirect(buffer, draws, uploadIndirect(draws, transient));
+}
@@ -85,6 +85,11 @@ Node* Scenegraph::getRoot() const
 	return m_root.get();
 }
 
+uint32_t Scenegraph::getVersion() const
+{
+	return m_root ? m_root->getVersion() : 0;
+}
+
 void Scenegraph::accept(NodeVisitor & v) const
 {
 	v.visit(m_root.get());